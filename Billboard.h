@@ -0,0 +1,28 @@
+#ifndef BILLBOARD_H
+#define BILLBOARD_H
+
+#include <glm/glm.hpp>
+
+/// \desc builds a model matrix for a quad that turns around the world up axis to face the camera
+/// \param position world position of the center of the quad
+/// \param viewMatrix camera view matrix the quad should face
+/// \returns the billboard model matrix
+inline glm::mat4 createBillboardMatrix(const glm::vec3& position, const glm::mat4& viewMatrix) {
+    // Extract camera right and up vectors from view matrix
+    glm::vec3 right = glm::vec3(viewMatrix[0][0], viewMatrix[1][0], viewMatrix[2][0]);
+    glm::vec3 up = glm::vec3(0, 1, 0);
+
+    // Scale for the billboard size - reduced from 2.0f to 1.0f
+    const float BILLBOARD_SIZE = 1.0f;
+
+    // Create billboard model matrix
+    glm::mat4 billboardModel = glm::mat4(1.0f);
+    billboardModel[0] = glm::vec4(right * BILLBOARD_SIZE, 0.0f);
+    billboardModel[1] = glm::vec4(up * BILLBOARD_SIZE, 0.0f);
+    billboardModel[2] = glm::vec4(glm::cross(right, up) * BILLBOARD_SIZE, 0.0f);
+    billboardModel[3] = glm::vec4(position, 1.0f);
+
+    return billboardModel;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "CameraPath.h"
+
+#include "World.h"
+
+#include <queue>
+
+CameraPath::CameraPath(const std::vector<std::vector<int>>& world, glm::ivec2 startCell, float eyeHeight, float cellSize)
+    : _numSegments(0) {
+    if(world.empty()
+       || startCell.x < 0 || startCell.x >= (int)world.size()
+       || startCell.y < 0 || startCell.y >= (int)world[startCell.x].size()
+       || world[startCell.x][startCell.y] == CELL_WALL) {
+        return;
+    }
+
+    // two legs sweep the longest corridors of the maze
+    std::vector<glm::ivec2> cells = _routeToFarthest(world, startCell);
+    const std::vector<glm::ivec2> secondLeg = _routeToFarthest(world, cells.back());
+    cells.insert(cells.end(), secondLeg.begin() + 1, secondLeg.end());
+    if(cells.size() < 2) return;
+
+    std::vector<glm::vec3> points;
+    points.reserve(cells.size());
+    for(const glm::ivec2& cell : cells) {
+        points.emplace_back(cell.x * cellSize, eyeHeight, cell.y * cellSize);
+    }
+
+    // Catmull-Rom tangents, the end points repeat themselves
+    const size_t numPoints = points.size();
+    _curves.reserve(numPoints - 1);
+    _curveSegments.reserve(numPoints - 1);
+    for(size_t i = 0; i + 1 < numPoints; i++) {
+        const glm::vec3& before = points[i > 0 ? i - 1 : i];
+        const glm::vec3& after = points[i + 2 < numPoints ? i + 2 : i + 1];
+        BezierCurve curve;
+        curve.p0 = points[i];
+        curve.p1 = points[i] + (points[i + 1] - before) / 6.0f;
+        curve.p2 = points[i + 1] - (after - points[i]) / 6.0f;
+        curve.p3 = points[i + 1];
+        _curves.push_back(curve);
+
+        // a new segment starts wherever the route turns
+        const bool turns = i > 0 && cells[i + 1] - cells[i] != cells[i] - cells[i - 1];
+        if(i == 0 || turns) _numSegments++;
+        _curveSegments.push_back(_numSegments - 1);
+    }
+}
+
+void CameraPath::sample(size_t curve, float t, glm::vec3& position, glm::vec3& forward) const {
+    const BezierCurve& bezier = _curves[curve];
+    position = bezier.evaluate(t);
+
+    // the tangent vanishes where the route doubles back out of a dead end
+    const glm::vec3 tangent = bezier.derivative(t);
+    if(glm::dot(tangent, tangent) > 1e-6f) {
+        forward = glm::normalize(tangent);
+    } else {
+        forward = glm::normalize(bezier.p3 - bezier.p0);
+    }
+}
+
+std::vector<glm::ivec2> CameraPath::_routeToFarthest(const std::vector<std::vector<int>>& world, glm::ivec2 from) {
+    const int rows = world.size();
+    std::vector<std::vector<glm::ivec2>> cameFrom(rows);
+    for(int i = 0; i < rows; i++) {
+        cameFrom[i].assign(world[i].size(), glm::ivec2(-1, -1));
+    }
+
+    const glm::ivec2 STEPS[4] = { glm::ivec2(1, 0), glm::ivec2(-1, 0), glm::ivec2(0, 1), glm::ivec2(0, -1) };
+    std::queue<glm::ivec2> frontier;
+    frontier.push(from);
+    cameFrom[from.x][from.y] = from;
+    glm::ivec2 farthest = from;
+    while(!frontier.empty()) {
+        const glm::ivec2 cell = frontier.front();
+        frontier.pop();
+        farthest = cell;
+        for(const glm::ivec2& step : STEPS) {
+            const glm::ivec2 next = cell + step;
+            if(next.x < 0 || next.x >= rows || next.y < 0 || next.y >= (int)world[next.x].size()) continue;
+            if(world[next.x][next.y] == CELL_WALL || cameFrom[next.x][next.y].x >= 0) continue;
+            cameFrom[next.x][next.y] = cell;
+            frontier.push(next);
+        }
+    }
+
+    std::vector<glm::ivec2> route;
+    for(glm::ivec2 cell = farthest; cell != from; cell = cameFrom[cell.x][cell.y]) {
+        route.push_back(cell);
+    }
+    route.push_back(from);
+    return std::vector<glm::ivec2>(route.rbegin(), route.rend());
+}
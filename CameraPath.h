@@ -0,0 +1,66 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \desc cubic Bezier curve, evaluated with the same Bernstein form as the glitch distortion
+/// in slendershader.v.glsl
+struct BezierCurve {
+    glm::vec3 p0, p1, p2, p3;
+
+    /// \desc point on the curve
+    /// \param t curve parameter in [0, 1]
+    glm::vec3 evaluate(float t) const {
+        const float s = 1.0f - t;
+        return s*s*s * p0 + 3.0f*s*s*t * p1 + 3.0f*s*t*t * p2 + t*t*t * p3;
+    }
+
+    /// \desc first derivative of the curve, points along the direction of travel
+    /// \param t curve parameter in [0, 1]
+    glm::vec3 derivative(float t) const {
+        const float s = 1.0f - t;
+        return 3.0f*s*s * (p1 - p0) + 6.0f*s*t * (p2 - p1) + 3.0f*t*t * (p3 - p2);
+    }
+};
+
+/// \desc scripted camera path through the open cells of a maze.  the route is found once with
+/// breadth first searches: from the start cell to the farthest reachable cell, then on to the
+/// cell farthest from there.  consecutive cell centers are joined by Bezier curves with
+/// Catmull-Rom tangents so position and heading stay smooth through corners.  the route is
+/// split into segments at every turn, each straight run is reported on its own
+class CameraPath {
+public:
+    /// \param world maze cells
+    /// \param startCell cell the path starts on, indices into world
+    /// \param eyeHeight height of the camera above the floor
+    /// \param cellSize distance between two neighboring cell centers in world units
+    CameraPath(const std::vector<std::vector<int>>& world, glm::ivec2 startCell, float eyeHeight, float cellSize);
+
+    /// \desc true if the start cell is blocked or has no open neighbor
+    bool isEmpty() const { return _curves.empty(); }
+    /// \desc number of Bezier curves, one per step from cell to cell
+    size_t getNumCurves() const { return _curves.size(); }
+    /// \desc number of straight runs the path is split into
+    size_t getNumSegments() const { return _numSegments; }
+    /// \desc segment a curve belongs to
+    size_t getSegment(size_t curve) const { return _curveSegments[curve]; }
+
+    /// \desc camera placement along the path
+    /// \param curve index of the curve
+    /// \param t curve parameter in [0, 1]
+    /// \param [out] position camera position
+    /// \param [out] forward unit view direction
+    void sample(size_t curve, float t, glm::vec3& position, glm::vec3& forward) const;
+
+private:
+    /// \desc cells from one cell to the open cell farthest from it, ties go to the first cell found
+    static std::vector<glm::ivec2> _routeToFarthest(const std::vector<std::vector<int>>& world, glm::ivec2 from);
+
+    std::vector<BezierCurve> _curves;
+    std::vector<size_t> _curveSegments;
+    size_t _numSegments;
+};
+
+#endif
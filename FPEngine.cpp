@@ -1,5 +1,11 @@
 #include "FPEngine.h"
 
+#include "Billboard.h"
+#include "GLStats.h"
+#include "Profiler.h"
+#include "StageTimer.h"
+#include "World.h"
+
 #include <CSCI441/objects.hpp>
 
 #include <cmath>
@@ -8,6 +14,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
 
 //*************************************************************************************
 //
@@ -16,12 +25,57 @@
 static const GLfloat GLM_PI = glm::pi<float>();
 static const GLfloat GLM_2PI = glm::two_pi<float>();
 
+/// \desc extracts the six normalized clip planes (left, right, bottom, top, near, far) of a view projection matrix
+static void extractFrustumPlanes(const glm::mat4& viewProjMtx, glm::vec4 planes[6]) {
+    for(int axis = 0; axis < 3; axis++) {
+        for(int side = 0; side < 2; side++) {
+            const GLfloat sign = side == 0 ? 1.0f : -1.0f;
+            glm::vec4 plane;
+            for(int col = 0; col < 4; col++) {
+                plane[col] = viewProjMtx[col][3] + sign * viewProjMtx[col][axis];
+            }
+            planes[axis*2 + side] = plane / glm::length(glm::vec3(plane));
+        }
+    }
+}
+
+/// \desc true if a bounding sphere intersects the frustum described by the planes
+static bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, GLfloat radius) {
+    for(int i = 0; i < 6; i++) {
+        if(glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// \desc folds bytes into a 64 bit FNV-1a hash
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t bytes) {
+    const unsigned char* bytePtr = (const unsigned char*)data;
+    for(size_t i = 0; i < bytes; i++) {
+        hash = (hash ^ bytePtr[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static const uint64_t HASH_SEED = 14695981039346656037ull;
+
+/// \desc hash of every cell of a world, tells a replay whether it plays in the recorded maze
+static uint64_t hashWorld(const std::vector<std::vector<int>>& world) {
+    uint64_t hash = HASH_SEED;
+    for(const std::vector<int>& row : world) {
+        hash = hashBytes(hash, row.data(), row.size() * sizeof(int));
+    }
+    return hash;
+}
+
 //*************************************************************************************
 //
 // Public Interface
 
-FPEngine::FPEngine()
-     : CSCI441::OpenGLEngine(4, 1, WINDOW_WIDTH, WINDOW_HEIGHT, "FP") {
+FPEngine::FPEngine(const EngineOptions& options)
+     : CSCI441::OpenGLEngine(4, 1, WINDOW_WIDTH, WINDOW_HEIGHT, "FP"),
+       _options(options) {
 
     for(auto& _key : _keys) _key = GL_FALSE;
 
@@ -29,18 +83,123 @@ FPEngine::FPEngine()
     _leftMouseButtonState = GLFW_RELEASE;
     _direction = 0;
     _phi = 0;
-    _pos = glm::vec2(3,3);
-    _playerRadius = 0.5f;
-    _lastDir = 0;
-    _hitTimer = 0;
-    _ghostFreezeTimer = 0.0f;
-    const float GHOST_FREEZE_DURATION = 10.0f;  // 10 seconds
+
+    _simulation = nullptr;
+    _simulationRunning = false;
+    _lastRespawns = 0;
+    _inputButtons = 0;
+    _inputDirection = 0.0f;
+    _tickSeconds = 1.0 / _options.simulationTickRate;
+    _simulationAccumulator = 0.0;
+    _lastSimulationTime = 0.0;
+
+    _cullTimeMs = 0.0;
+    _stageFrames = 0;
+
+    _gpuProfiler = nullptr;
+    _depthShaderProgram = nullptr;
+    _fragmentCounter = nullptr;
+    _occlusionCuller = nullptr;
+    _streamBuffer = nullptr;
+    _uniformStreamBuffer = nullptr;
+    _shadedFragments = 0.0;
+    _statsHud = nullptr;
+    _offscreenTarget = nullptr;
+    _flythrough = nullptr;
+
+    _inputRecorder = nullptr;
+    _inputReplay = nullptr;
+    _inputFrame = 0;
+    _replayExpectedHash = 0;
+    _replayHashPending = false;
+    _replayDivergedFrame = -1;
+    _replayFrameTime = 0.0;
+    _pendingInputTime = -1.0;
+    if(!_options.replayInputFile.empty()) {
+        _inputReplay = new InputReplay(_options.replayInputFile);
+        if(_inputReplay->isOpen()) {
+            // ticks have to line up with the recording, so does the run length when headless
+            _options.simulationTickRate = _inputReplay->getTickRate();
+            _tickSeconds = 1.0 / _options.simulationTickRate;
+            _options.headlessFrames = _inputReplay->getNumFrames();
+        } else {
+            delete _inputReplay;
+            _inputReplay = nullptr;
+        }
+    } else if(!_options.recordInputFile.empty()) {
+        _inputRecorder = new InputRecorder(_options.recordInputFile);
+        if(_inputRecorder->isOpen()) {
+            _inputRecorder->setTickRate(_options.simulationTickRate);
+        } else {
+            delete _inputRecorder;
+            _inputRecorder = nullptr;
+        }
+    }
+
+    _fixedClock = _options.headless || _options.flythrough;
+    // benchmarks and replays want every frame as fast as it can be drawn
+    if(_options.frameMode == FramePacer::VSYNC && (_options.headless || _options.flythrough || _inputReplay)) {
+        _options.frameMode = FramePacer::UNCAPPED;
+    }
+    _framePacer = new FramePacer(_options.frameMode, _options.frameRateCap);
+
+    _frameCapture = nullptr;
+    _captureSequence = !_options.frameDumpPrefix.empty();
+    _screenshotRequested = false;
+    _numScreenshots = 0;
+
+    _lightGrid = nullptr;
+    _lightmapTexture = 0;
+
+    _qualityGovernor = nullptr;
+    _gpuFrameTimer = nullptr;
+    _glitchShaderProgram = nullptr;
+    _renderGraph = nullptr;
+    _graphPasses = 0.0;
+    _graphCulled = 0.0;
+    _quality = QualityGovernor::getFullQuality();
+    if(_options.adaptiveQualityTarget > 0.0) {
+        _qualityGovernor = new QualityGovernor(_options.adaptiveQualityTarget);
+    }
+
+    // a simulation thread samples input at wall clock moments that cannot be replayed
+    if(_fixedClock || _inputRecorder || _inputReplay) {
+        _options.threadedSimulation = false;
+    }
 }
 GLfloat getRand() {
     return (GLfloat)rand() / (GLfloat)RAND_MAX;
 }
 
 void FPEngine::handleKeyEvent(GLint key, GLint action) {
+    if(_inputReplay) {
+        // live input would break the replay, only let the user quit
+        if(key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) setWindowShouldClose();
+        return;
+    }
+    if(_options.measureLatency) _noteInputArrival();
+    if(_inputRecorder) _inputRecorder->recordKey(_inputFrame, key, action);
+    _applyKeyEvent(key, action);
+}
+
+void FPEngine::handleMouseButtonEvent(GLint button, GLint action) {
+    if(_inputReplay) return;
+    if(_options.measureLatency) _noteInputArrival();
+    if(_inputRecorder) _inputRecorder->recordMouseButton(_inputFrame, button, action);
+    _applyMouseButtonEvent(button, action);
+}
+
+void FPEngine::handleCursorPositionEvent(GLFWwindow* window, glm::vec2 currMousePosition) {
+    if(_inputReplay) return;
+    if(_options.measureLatency) _noteInputArrival();
+    if(_inputRecorder) _inputRecorder->recordCursor(_inputFrame, currMousePosition.x, currMousePosition.y);
+    _applyCursorEvent(currMousePosition);
+}
+
+void FPEngine::handleScrollEvent(glm::vec2 offset) {
+}
+
+void FPEngine::_applyKeyEvent(GLint key, GLint action) {
     if(key != GLFW_KEY_UNKNOWN)
         _keys[key] = ((action == GLFW_PRESS) || (action == GLFW_REPEAT));
 
@@ -51,19 +210,36 @@ void FPEngine::handleKeyEvent(GLint key, GLint action) {
             case GLFW_KEY_ESCAPE:
                 setWindowShouldClose();
                 break;
+            // dump the profiler ring buffers
+            case GLFW_KEY_P:
+                Profiler::exportTrace(_options.profileOutput.empty() ? DEFAULT_PROFILE_OUTPUT : _options.profileOutput);
+                break;
+            // show or hide the draw statistics
+            case GLFW_KEY_H:
+                _statsHud->toggle();
+                break;
+            // start or stop capturing every frame
+            case GLFW_KEY_F11:
+                _captureSequence = !_captureSequence;
+                fprintf(stdout, "[INFO]: frame capture %s\n", _captureSequence ? "started" : "stopped");
+                break;
+            // capture the next frame
+            case GLFW_KEY_F12:
+                _screenshotRequested = true;
+                break;
             default: break;
         }
     }
 }
 
-void FPEngine::handleMouseButtonEvent(GLint button, GLint action) {
+void FPEngine::_applyMouseButtonEvent(GLint button, GLint action) {
 
     if( button == GLFW_MOUSE_BUTTON_LEFT ) {
         _leftMouseButtonState = action;
     }
 }
 
-void FPEngine::handleCursorPositionEvent(GLFWwindow* window, glm::vec2 currMousePosition) {
+void FPEngine::_applyCursorEvent(glm::vec2 currMousePosition) {
     // if mouse hasn't moved in the window, prevent camera from flipping out
     if(fabs(_mousePosition.x - MOUSE_UNINITIALIZED) <= 0.000001f) {
         _mousePosition = currMousePosition;
@@ -81,16 +257,22 @@ void FPEngine::handleCursorPositionEvent(GLFWwindow* window, glm::vec2 currMouse
     _mousePosition = currMousePosition;
 }
 
-void FPEngine::handleScrollEvent(glm::vec2 offset) {
-}
-
 //*************************************************************************************
 //
 // Engine Setup
 
 void FPEngine::mSetupGLFW() {
+    if(_options.headless) {
+        _setupHeadlessContext();
+        return;
+    }
+
     CSCI441::OpenGLEngine::mSetupGLFW();
 
+    // only vsync pacing lets the swap wait for the display
+    glfwSwapInterval(_framePacer->getSwapInterval());
+    fprintf(stdout, "[INFO]: frame pacing: %s\n", FramePacer::getModeName(_framePacer->getMode()));
+
     // Update callback references from mp_ to a4_
     glfwSetKeyCallback(mpWindow, fp_keyboard_callback);
     glfwSetMouseButtonCallback(mpWindow, fp_mouse_button_callback);
@@ -105,7 +287,7 @@ void FPEngine::mSetupOpenGL() {
     glEnable( GL_DEPTH_TEST );					                    // enable depth testing
     glDepthFunc( GL_LESS );							                // use less than depth test
 
-    glEnable(GL_BLEND);									            // enable blending
+    // blending stays off, only the passes drawing transparent geometry turn it on
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);	            // use one minus blending equation
 
     glClearColor( 0.0f, 0.0f, 0.0f, 1.0f );	// clear the frame buffer to black
@@ -114,41 +296,49 @@ void FPEngine::mSetupOpenGL() {
 
 void FPEngine::mSetupShaders() {
     _shaderProgram = new CSCI441::ShaderProgram("shaders/fp.v.glsl", "shaders/fp.f.glsl" );
-    _slenderShaderProgram = new CSCI441::ShaderProgram("shaders/slendershader.v.glsl", "shaders/slendershader.f.glsl" );
+    _glitchShaderProgram = new CSCI441::ShaderProgram("shaders/glitch.v.glsl", "shaders/glitch.f.glsl");
+    _glitchUniformLocations.sceneColor = _glitchShaderProgram->getUniformLocation("sceneColor");
+    _glitchUniformLocations.strength = _glitchShaderProgram->getUniformLocation("strength");
+    _glitchUniformLocations.time = _glitchShaderProgram->getUniformLocation("time");
+    _glitchShaderProgram->setProgramUniform(_glitchUniformLocations.sceneColor, 0);
+    // draws the depth prepass and the occlusion proxies
+    _depthShaderProgram = new CSCI441::ShaderProgram("shaders/depth.v.glsl", "shaders/depth.f.glsl");
+    _depthMvpMatrixLocation = _depthShaderProgram->getUniformLocation("mvpMatrix");
+    _depthPositionScaleLocation = _depthShaderProgram->getUniformLocation("positionScale");
+    _depthPositionOffsetLocation = _depthShaderProgram->getUniformLocation("positionOffset");
+    _setPositionUnpacking(_depthShaderProgram, _depthPositionScaleLocation, _depthPositionOffsetLocation, PackedBounds());
 
     // query uniform locations
     _shaderUniformLocations.mvpMatrix      = _shaderProgram->getUniformLocation("mvpMatrix");
+    _shaderUniformLocations.modelMatrix      = _shaderProgram->getUniformLocation("modelMatrix");
+    _shaderUniformLocations.positionScale      = _shaderProgram->getUniformLocation("positionScale");
+    _shaderUniformLocations.positionOffset      = _shaderProgram->getUniformLocation("positionOffset");
+    _shaderUniformLocations.useLightmap      = _shaderProgram->getUniformLocation("useLightmap");
+    _shaderUniformLocations.alphaTest      = _shaderProgram->getUniformLocation("alphaTest");
+    _shaderUniformLocations.instanced      = _shaderProgram->getUniformLocation("instanced");
     _shaderUniformLocations.lightDirection      = _shaderProgram->getUniformLocation("lightDirection");
     _shaderUniformLocations.directionalLightColor      = _shaderProgram->getUniformLocation("directionalLightColor");
-    _shaderUniformLocations.pointLightPosition      = _shaderProgram->getUniformLocation("pointLightPosition");
-    _shaderUniformLocations.pointLightColor      = _shaderProgram->getUniformLocation("pointLightColor");
     _shaderUniformLocations.materialColor      = _shaderProgram->getUniformLocation("materialColor");
     _shaderUniformLocations.normalMatrix      = _shaderProgram->getUniformLocation("normalMatrix");
-    _shaderUniformLocations.viewVector      = _shaderProgram->getUniformLocation("viewVector");
     _shaderUniformLocations.textureMap      = _shaderProgram->getUniformLocation("textureMap");
-    _shaderUniformLocations.time      = _slenderShaderProgram->getUniformLocation("time");
 
     _shaderAttributeLocations.vPos         = _shaderProgram->getAttributeLocation("vPos");
     _shaderAttributeLocations.normalVec      = _shaderProgram->getAttributeLocation("normalVec");
     _shaderAttributeLocations.inTexCoord      = _shaderProgram->getAttributeLocation("inTexCoord");
-
-    // query uniform locations for slender shader separately because linux and mac compiler doesnt optimize and store them at the same location like windows
-    _slenderShaderUniformLocations.mvpMatrix      = _slenderShaderProgram->getUniformLocation("mvpMatrix");
-    _slenderShaderUniformLocations.lightDirection      = _slenderShaderProgram->getUniformLocation("lightDirection");
-    _slenderShaderUniformLocations.directionalLightColor      = _slenderShaderProgram->getUniformLocation("directionalLightColor");
-    _slenderShaderUniformLocations.pointLightPosition      = _slenderShaderProgram->getUniformLocation("pointLightPosition");
-    _slenderShaderUniformLocations.pointLightColor      = _slenderShaderProgram->getUniformLocation("pointLightColor");
-    _slenderShaderUniformLocations.materialColor      = _slenderShaderProgram->getUniformLocation("materialColor");
-    _slenderShaderUniformLocations.normalMatrix      = _slenderShaderProgram->getUniformLocation("normalMatrix");
-    _slenderShaderUniformLocations.viewVector      = _slenderShaderProgram->getUniformLocation("viewVector");
-    _slenderShaderUniformLocations.textureMap      = _slenderShaderProgram->getUniformLocation("textureMap");
-    _slenderShaderUniformLocations.time      = _slenderShaderProgram->getUniformLocation("time");
-
-    _slenderShaderAttributeLocations.vPos         = _slenderShaderProgram->getAttributeLocation("vPos");
-    _slenderShaderAttributeLocations.normalVec      = _slenderShaderProgram->getAttributeLocation("normalVec");
-    _slenderShaderAttributeLocations.inTexCoord      = _slenderShaderProgram->getAttributeLocation("inTexCoord");
+    _shaderAttributeLocations.instanceCenterSize      = _shaderProgram->getAttributeLocation("instanceCenterSize");
+    _shaderAttributeLocations.instanceColor      = _shaderProgram->getAttributeLocation("instanceColor");
 
     _shaderProgram->setProgramUniform("textureMap", 0);
+    _shaderProgram->setProgramUniform("lightData", (GLint)LIGHT_GRID_FIRST_UNIT);
+    _shaderProgram->setProgramUniform("lightCells", (GLint)LIGHT_GRID_FIRST_UNIT + 1);
+    _shaderProgram->setProgramUniform("lightIndices", (GLint)LIGHT_GRID_FIRST_UNIT + 2);
+    _shaderProgram->setProgramUniform("lightmap", (GLint)LIGHTMAP_UNIT);
+    // GLSL 4.10 has no binding layout qualifier, the block is pointed at its binding here
+    glUniformBlockBinding(_shaderProgram->getShaderProgramHandle(),
+        glGetUniformBlockIndex(_shaderProgram->getShaderProgramHandle(), "FrameUniforms"),
+        FRAME_UNIFORM_BINDING);
+    // everything but the platform and quad VAOs has float positions
+    _setPositionUnpacking(_shaderProgram, _shaderUniformLocations.positionScale, _shaderUniformLocations.positionOffset, PackedBounds());
 
 
     CSCI441::setVertexAttributeLocations(_shaderAttributeLocations.vPos,
@@ -162,26 +352,32 @@ void FPEngine::mSetupBuffers() {
     glGenBuffers( NUM_VAOS, _vbos );
     glGenBuffers( NUM_VAOS, _ibos );
 
-    _createPlatform(_vaos[VAO_ID::PLATFORM], _vbos[VAO_ID::PLATFORM], _ibos[VAO_ID::PLATFORM], _numVAOPoints[VAO_ID::PLATFORM]);
+    // the platform is sized to the world, load it first
     _generateEnvironment();
-    _createQuad(_vaos[VAO_ID::QUAD], _vbos[VAO_ID::QUAD], _ibos[VAO_ID::QUAD], _numVAOPoints[VAO_ID::QUAD]);
+    _createPlatform(_vaos[VAO_ID::PLATFORM], _vbos[VAO_ID::PLATFORM], _ibos[VAO_ID::PLATFORM], _numVAOPoints[VAO_ID::PLATFORM], _vaoBounds[VAO_ID::PLATFORM]);
+    _createQuad(_vaos[VAO_ID::QUAD], _vbos[VAO_ID::QUAD], _ibos[VAO_ID::QUAD], _numVAOPoints[VAO_ID::QUAD], _vaoBounds[VAO_ID::QUAD]);
+    _createParticleSphere(_vaos[VAO_ID::PARTICLE], _vbos[VAO_ID::PARTICLE], _ibos[VAO_ID::PARTICLE], _numVAOPoints[VAO_ID::PARTICLE], _vaoBounds[VAO_ID::PARTICLE]);
 
-}
+    _streamBuffer = new StreamBuffer(GL_ARRAY_BUFFER, STREAM_REGION_SIZE);
+    _uniformStreamBuffer = new StreamBuffer(GL_UNIFORM_BUFFER, UNIFORM_REGION_SIZE);
 
-void FPEngine::_createPlatform(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints) const {
-    struct VertexNormalTextured {
-        glm::vec3 position;
-        glm::vec3 normal;
-        glm::vec2 texCoord;
-    };
+}
 
+void FPEngine::_createPlatform(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints, PackedBounds &bounds) const {
     // create our platform
-    VertexNormalTextured platformVertices[4] = {
-            { { -1.5, 1.0f, -1.5 }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } }, // 0 - BL
-            { {  WORLD_SIZE_X*3-1.5, 1.0f, -1.5 }, { 0.0f, 1.0f, 0.0f }, { 10.0f, 0.0f } }, // 1 - BR
-            { { -1.5, 1.0f,  WORLD_SIZE_Y*3-1.5}, { 0.0f, 1.0f, 0.0f }, { 0.0f, 10.0f } }, // 2 - TL
-            { {  WORLD_SIZE_X*3-1.5, 1.0f,  WORLD_SIZE_Y*3-1.5 }, { 0.0f, 1.0f, 0.0f }, { 10.0f, 10.0f } }  // 3 - TR
+    const glm::vec3 positions[4] = {
+            { -1.5, 1.0f, -1.5 },                                   // 0 - BL
+            {  WORLD_SIZE_X*3-1.5, 1.0f, -1.5 },                    // 1 - BR
+            { -1.5, 1.0f,  WORLD_SIZE_Y*3-1.5 },                    // 2 - TL
+            {  WORLD_SIZE_X*3-1.5, 1.0f,  WORLD_SIZE_Y*3-1.5 }      // 3 - TR
     };
+    const glm::vec2 texCoords[4] = { { 0.0f, 0.0f }, { 10.0f, 0.0f }, { 0.0f, 10.0f }, { 10.0f, 10.0f } };
+
+    bounds = VertexPacking::computeBounds(positions, 4);
+    PackedVertex platformVertices[4];
+    for(int i = 0; i < 4; i++) {
+        platformVertices[i] = VertexPacking::pack(positions[i], glm::vec3(0.0f, 1.0f, 0.0f), texCoords[i], bounds);
+    }
 
     GLushort platformIndices[4] = { 0, 1, 2, 3 };
     numVAOPoints = 4;
@@ -191,16 +387,7 @@ void FPEngine::_createPlatform(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numV
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData( GL_ARRAY_BUFFER, sizeof( platformVertices ), platformVertices, GL_STATIC_DRAW );
 
-    glEnableVertexAttribArray( _shaderAttributeLocations.vPos );
-    glVertexAttribPointer( _shaderAttributeLocations.vPos, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured), (void*)nullptr );
-
-    glEnableVertexAttribArray( _shaderAttributeLocations.normalVec );
-    glVertexAttribPointer( _shaderAttributeLocations.normalVec, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured), (void*)(sizeof(glm::vec3)) );
-
-    glEnableVertexAttribArray(_shaderAttributeLocations.inTexCoord);
-    glVertexAttribPointer( _shaderAttributeLocations.inTexCoord, 2, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured), (void*)(sizeof(glm::vec3)*2) );
-
-
+    VertexPacking::setAttributePointers(_shaderAttributeLocations.vPos, _shaderAttributeLocations.normalVec, _shaderAttributeLocations.inTexCoord);
 
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo );
     glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( platformIndices ), platformIndices, GL_STATIC_DRAW );
@@ -208,20 +395,21 @@ void FPEngine::_createPlatform(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numV
     fprintf( stdout, "[INFO]: platform read in with VAO/VBO/IBO %d/%d/%d & %d points\n", vao, vbo, ibo, numVAOPoints );
 }
 
-void FPEngine::_createQuad(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints) const {
-    struct VertexNormalTextured {
-        glm::vec3 position;
-        glm::vec3 normal;
-        glm::vec2 texCoord;
+void FPEngine::_createQuad(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints, PackedBounds &bounds) const {
+    const glm::vec3 positions[4] = {
+        { -2.5f, -2.5f,  0.0f },    // 0 - BL
+        {  2.5f, -2.5f,  0.0f },    // 1 - BR
+        { -2.5f,  2.5f,  0.0f },    // 2 - TL
+        {  2.5f,  2.5f,  0.0f }     // 3 - TR
     };
-
     // Modified UV coordinates to map to entire texture (changed from 3.0 to 1.0)
-    VertexNormalTextured quadVertices[4] = {
-        { { -2.5f, -2.5f,  0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } }, // 0 - BL
-        { {  2.5f, -2.5f,  0.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f } }, // 1 - BR
-        { { -2.5f,  2.5f,  0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f } }, // 2 - TL
-        { {  2.5f,  2.5f,  0.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f } }  // 3 - TR
-    };
+    const glm::vec2 texCoords[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 1.0f } };
+
+    bounds = VertexPacking::computeBounds(positions, 4);
+    PackedVertex quadVertices[4];
+    for(int i = 0; i < 4; i++) {
+        quadVertices[i] = VertexPacking::pack(positions[i], glm::vec3(0.0f, 1.0f, 0.0f), texCoords[i], bounds);
+    }
 
     GLushort quadIndices[4] = { 0, 1, 2, 3 };
     numVAOPoints = 4;
@@ -231,14 +419,7 @@ void FPEngine::_createQuad(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPo
     glBindBuffer( GL_ARRAY_BUFFER, vbo );
     glBufferData( GL_ARRAY_BUFFER, sizeof( quadVertices ), quadVertices, GL_STATIC_DRAW );
 
-    glEnableVertexAttribArray( _shaderAttributeLocations.vPos );
-    glVertexAttribPointer( _shaderAttributeLocations.vPos, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured), (void*)nullptr );
-
-    glEnableVertexAttribArray( _shaderAttributeLocations.normalVec);
-    glVertexAttribPointer( _shaderAttributeLocations.normalVec, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured), (void*)(sizeof(glm::vec3)) );
-
-    glEnableVertexAttribArray( _shaderAttributeLocations.inTexCoord );
-    glVertexAttribPointer( _shaderAttributeLocations.inTexCoord, 2, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured), (void*)(2*sizeof(glm::vec3)) );
+    VertexPacking::setAttributePointers(_shaderAttributeLocations.vPos, _shaderAttributeLocations.normalVec, _shaderAttributeLocations.inTexCoord);
 
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo );
     glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( quadIndices ), quadIndices, GL_STATIC_DRAW );
@@ -246,13 +427,72 @@ void FPEngine::_createQuad(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPo
     fprintf( stdout, "[INFO]: quad read in with VAO/VBO/IBO %d/%d/%d & %d points\n", vao, vbo, ibo, numVAOPoints );
 }
 
+void FPEngine::_createParticleSphere(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints, PackedBounds &bounds) const {
+    // the same detail the particles were drawn with through CSCI441
+    const GLint STACKS = 8, SLICES = 8;
+    const GLfloat RADIUS = 0.5f;
+
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    for(GLint stack = 0; stack <= STACKS; stack++) {
+        const GLfloat phi = glm::pi<GLfloat>() * stack / STACKS;
+        for(GLint slice = 0; slice <= SLICES; slice++) {
+            const GLfloat theta = glm::two_pi<GLfloat>() * slice / SLICES;
+            const glm::vec3 normal(glm::sin(phi) * glm::cos(theta), glm::cos(phi), glm::sin(phi) * glm::sin(theta));
+            normals.push_back(normal);
+            positions.push_back(normal * RADIUS);
+            texCoords.emplace_back((GLfloat)slice / SLICES, (GLfloat)stack / STACKS);
+        }
+    }
+
+    bounds = VertexPacking::computeBounds(positions.data(), positions.size());
+    std::vector<PackedVertex> sphereVertices;
+    for(size_t i = 0; i < positions.size(); i++) {
+        sphereVertices.push_back(VertexPacking::pack(positions[i], normals[i], texCoords[i], bounds));
+    }
+
+    std::vector<GLushort> sphereIndices;
+    for(GLint stack = 0; stack < STACKS; stack++) {
+        for(GLint slice = 0; slice < SLICES; slice++) {
+            const GLushort top = (GLushort)(stack * (SLICES + 1) + slice);
+            const GLushort bottom = (GLushort)(top + SLICES + 1);
+            sphereIndices.insert(sphereIndices.end(), { top, bottom, (GLushort)(top + 1), (GLushort)(top + 1), bottom, (GLushort)(bottom + 1) });
+        }
+    }
+    numVAOPoints = (GLsizei)sphereIndices.size();
+
+    glBindVertexArray( vao );
+
+    glBindBuffer( GL_ARRAY_BUFFER, vbo );
+    glBufferData( GL_ARRAY_BUFFER, sphereVertices.size() * sizeof(PackedVertex), sphereVertices.data(), GL_STATIC_DRAW );
+
+    VertexPacking::setAttributePointers(_shaderAttributeLocations.vPos, _shaderAttributeLocations.normalVec, _shaderAttributeLocations.inTexCoord);
+
+    // one particle per instance, the pointers themselves are set when the instances are written
+    glEnableVertexAttribArray( _shaderAttributeLocations.instanceCenterSize );
+    glVertexAttribDivisor( _shaderAttributeLocations.instanceCenterSize, 1 );
+    glEnableVertexAttribArray( _shaderAttributeLocations.instanceColor );
+    glVertexAttribDivisor( _shaderAttributeLocations.instanceColor, 1 );
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sphereIndices.size() * sizeof(GLushort), sphereIndices.data(), GL_STATIC_DRAW );
+
+    fprintf( stdout, "[INFO]: particle sphere read in with VAO/VBO/IBO %d/%d/%d & %d points\n", vao, vbo, ibo, numVAOPoints );
+}
+
+void FPEngine::_setPositionUnpacking(const CSCI441::ShaderProgram* shader, GLint scaleLocation, GLint offsetLocation, const PackedBounds& bounds) {
+    GLStats::setProgramUniform(shader, scaleLocation, bounds.scale);
+    GLStats::setProgramUniform(shader, offsetLocation, bounds.offset);
+}
+
 void FPEngine::mSetupTextures() {
     _texHandles[TEXTURE_ID::GROUND] = _loadAndRegisterTexture("assets/textures/dirt.png");
     _texHandles[TEXTURE_ID::BUILDING] = _loadAndRegisterTexture("assets/textures/wall.jpg");
     _texHandles[TEXTURE_ID::GHOST] = _loadAndRegisterTexture("assets/textures/ghost.jpeg");
     _texHandles[TEXTURE_ID::LAVA] = _loadAndRegisterTexture("assets/textures/lava.jpg");
     _texHandles[TEXTURE_ID::BLOOD] = _loadAndRegisterTexture("assets/textures/blood.jpg");
-    _texHandles[TEXTURE_ID::SKY] = _loadAndRegisterTexture("assets/textures/skybox.png");
+    _texHandles[TEXTURE_ID::SKY] = _loadSkyCubeMap("assets/textures/skybox.png");
     
     fprintf(stdout, "[INFO]: Skybox texture handle: %d\n", _texHandles[TEXTURE_ID::SKY]);
 }
@@ -263,7 +503,6 @@ void FPEngine::mSetupScene() {
 
     glm::vec3 directionalLightColor = glm::vec3(0.2f, 0.2f, 0.2f);
     glm::vec3 lightDirection = glm::vec3(-1,-1,-1);
-    glm::vec3 viewVector = glm::vec3(1,0,0);
     
     glProgramUniform3fv(_shaderProgram->getShaderProgramHandle(),
         _shaderUniformLocations.directionalLightColor,
@@ -274,17 +513,58 @@ void FPEngine::mSetupScene() {
         _shaderUniformLocations.lightDirection,
         1,
         glm::value_ptr(lightDirection));
-        
-    glProgramUniform3fv(_shaderProgram->getShaderProgramHandle(),
-        _shaderUniformLocations.viewVector,
-        1,
-        glm::value_ptr(viewVector));
 
     _setupSkybox();
 
-    _particleSystem = new ParticleSystem(_shaderProgram->getShaderProgramHandle(),
-                                       _shaderUniformLocations.mvpMatrix,
-                                       _shaderUniformLocations.materialColor);
+    // one grid cell per maze cell plus a border, maze cells are centered on multiples of 3
+    _lightGrid = new LightGrid(glm::vec2(-4.5f, -4.5f), 3.0f, (GLint)WORLD_SIZE_X + 2, (GLint)WORLD_SIZE_Y + 2);
+    const GLuint shaderProgramHandle = _shaderProgram->getShaderProgramHandle();
+    glProgramUniform2fv(shaderProgramHandle, _shaderProgram->getUniformLocation("lightGridOrigin"), 1, glm::value_ptr(_lightGrid->getOrigin()));
+    glProgramUniform1f(shaderProgramHandle, _shaderProgram->getUniformLocation("lightGridCellSize"), _lightGrid->getCellSize());
+    glProgramUniform2i(shaderProgramHandle, _shaderProgram->getUniformLocation("lightGridSize"), _lightGrid->getNumCellsX(), _lightGrid->getNumCellsZ());
+
+    if(_options.bakeLightmap) {
+        // the weights fp.f.glsl applies to ambient and directional light when lighting live
+        _setupLightmap({ lightDirection, directionalLightColor, 0.1f, 0.1f });
+    }
+
+    _gpuProfiler = new GpuProfiler();
+    _fragmentCounter = new FragmentCounter();
+    if(_options.occlusionCulling) {
+        _occlusionCuller = new OcclusionCuller();
+    }
+    _statsHud = new StatsHud();
+    _statsHud->setVisible(_options.showStatsHud);
+    _renderGraph = new RenderGraph();
+
+    if(_options.headless) {
+        _offscreenTarget = new OffscreenTarget(mWindowWidth, mWindowHeight);
+        if(!_offscreenTarget->isComplete()) {
+            setWindowShouldClose();
+        }
+        _headlessFrameTimes.reserve(_options.headlessFrames);
+    }
+
+    if(_options.flythrough) {
+        const CameraPath path(world_matrix, glm::ivec2(FLYTHROUGH_START_CELL, FLYTHROUGH_START_CELL), 1.5f, 3.0f);
+        if(path.isEmpty()) {
+            fprintf(stderr, "[ERROR]: no flythrough path from the spawn cell, flythrough disabled\n");
+        } else {
+            fprintf(stdout, "[INFO]: flythrough path of %zu cells in %zu segments\n", path.getNumCurves(), path.getNumSegments());
+            _flythrough = new FlythroughBenchmark(path, _options.flythroughFramesPerCell);
+        }
+    }
+
+    if(_qualityGovernor) {
+        _gpuFrameTimer = new GpuFrameTimer();
+    }
+
+    // setup bound objects directly, start the frame loop with nothing cached
+    GLStats::invalidateState();
+
+    // publish the initial state so the first frame has something to draw
+    _simulation->writeSnapshot(_snapshots.getBackBuffer());
+    _snapshots.publish();
 }
 
 //*************************************************************************************
@@ -294,6 +574,8 @@ void FPEngine::mSetupScene() {
 void FPEngine::mCleanupShaders() {
     fprintf( stdout, "[INFO]: ...deleting Shaders.\n" );
     delete _shaderProgram;
+    delete _depthShaderProgram;
+    delete _glitchShaderProgram;
 }
 
 void FPEngine::mCleanupBuffers() {
@@ -308,6 +590,9 @@ void FPEngine::mCleanupBuffers() {
     fprintf( stdout, "[INFO]: ...deleting IBOs....\n" );
     glDeleteBuffers( NUM_VAOS, _ibos );
 
+    delete _streamBuffer;
+    delete _uniformStreamBuffer;
+
     fprintf( stdout, "[INFO]: ...deleting models..\n" );
 }
 
@@ -321,13 +606,31 @@ void FPEngine::mCleanupTextures() {
 void FPEngine::mCleanupScene() {
     fprintf(stdout, "[INFO]: ...deleting scene...\n");
     
+    delete _gpuProfiler;
+    delete _fragmentCounter;
+    delete _occlusionCuller;
+    delete _statsHud;
+    delete _offscreenTarget;
+    delete _flythrough;
+    // closing the recorder writes the header of the input log
+    delete _inputRecorder;
+    delete _inputReplay;
+    delete _framePacer;
+    delete _lightGrid;
+    glDeleteTextures(1, &_lightmapTexture);
+    delete _qualityGovernor;
+    delete _gpuFrameTimer;
+    delete _renderGraph;
+    // waits until every captured frame is written
+    delete _frameCapture;
+
     // Cleanup skybox resources
     delete _skyboxShader;
-    glDeleteVertexArrays(1, &_skyboxVAO);
-    glDeleteBuffers(1, &_skyboxVBO);
+    glDeleteVertexArrays(1, &_fullscreenVAO);
     glDeleteTextures(1, &_texHandles[TEXTURE_ID::SKY]);
 
-    delete _particleSystem;
+    delete _simulation;
+    delete _jobSystem;
     for(CarData& carData : _carData) {
         delete carData.car;
     }
@@ -335,41 +638,22 @@ void FPEngine::mCleanupScene() {
 }
 
 
-std::vector<std::vector<int>> read_csv(const std::string& filename) {
-    std::vector<std::vector<int>> data;
-    std::ifstream file(filename);
-    std::string line;
-
-    if (!file.is_open()) {
-        std::cerr << "Could not open the file" << std::endl;
-        return data;
-    }
-
-    while (std::getline(file, line)) {
-        std::vector<int> row;
-        std::stringstream ss(line);
-        std::string cell;
-
-        while (std::getline(ss, cell, ',')) {
-            row.push_back(std::stoi(cell));
-        }
-
-        data.push_back(row);
-    }
-
-    file.close();
-    return data;
-}
-
 void FPEngine::_generateEnvironment() {
-    // Clear any existing collision objects
-    CollisionDetector::clearCollisionObjects();
-    
     //******************************************************************
     // parameters to make up our grid size and spacing, feel free to
     // play around with this
 
-    world_matrix = read_csv("world.csv");
+    _jobSystem = new JobSystem();
+    if(_options.generateMaze) {
+        world_matrix = MazeGenerator(_jobSystem).generate(_options.mazeOptions);
+    } else {
+        world_matrix = read_world(_options.worldFile);
+    }
+    if(world_matrix.empty()) {
+        fprintf(stderr, "[ERROR]: no world to play in, generating the default maze instead\n");
+        world_matrix = MazeGenerator(_jobSystem).generate(MazeOptions());
+    }
+    fprintf(stdout, "[INFO]: world is %zu x %zu cells\n", world_matrix.size(), world_matrix[0].size());
     WORLD_SIZE_X = world_matrix[0].size();
     WORLD_SIZE_Y = world_matrix.size();
 
@@ -385,7 +669,22 @@ void FPEngine::_generateEnvironment() {
     const GLfloat TOP_END_POINT = GRID_LENGTH / 2.0f + 5.0f;
     //******************************************************************
 
-    srand( time(0) );                                                   // seed our RNG
+    // fixed clock runs are compared across runs, keep their particles repeatable
+    unsigned int seed = _fixedClock ? 1 : (unsigned int)time(0);
+    const uint64_t worldHash = hashWorld(world_matrix);
+    if(_inputReplay) {
+        seed = _inputReplay->getSeed();
+        if(_inputReplay->getWorldHash() != worldHash) {
+            fprintf(stderr, "[WARN]: the replayed input was recorded in a different world, it will diverge\n");
+        }
+    } else if(_inputRecorder) {
+        _inputRecorder->setSeed(seed);
+        _inputRecorder->setWorldHash(worldHash);
+    }
+    srand( seed );                                                      // seed our RNG
+
+    _simulation = new Simulation(_jobSystem);
+    _simulation->loadWorld(world_matrix);
 
     for(int i = 0; i < WORLD_SIZE_X; i++){
         for(int j=0; j < WORLD_SIZE_Y; j++){
@@ -399,35 +698,18 @@ void FPEngine::_generateEnvironment() {
                 // store building properties
                 BuildingData currentBuilding = {modelMatrix, color};
                 _buildings.emplace_back( currentBuilding );
-                CollisionDetector::addCollisionObject(glm::vec3(i*3, 0, j*3),2.1, false);
-            }
-            else if(world_matrix[i][j]==0){
-                glm::mat4 transToHeight = glm::translate( glm::mat4(1.0), glm::vec3(0, 1.0f, 0) );
-                glm::mat4 modelMatrix = transToSpotMtx * transToHeight;
-                glm::vec3 color(1,1,1);
-                PointsData currentPoint  ={modelMatrix, color, glm::vec2(i*3, j*3), false};
-                _points.emplace_back(currentPoint);
-            }
-            else if(world_matrix[i][j]==2){
-                glm::mat4 transToHeight = glm::translate( glm::mat4(1.0), glm::vec3(0, 1.0f, 0) );
-                glm::mat4 modelMatrix = transToSpotMtx * transToHeight;
-                glm::vec3 color(1,1,1);
-                Ghost ghost = {modelMatrix, color, glm::vec2(i,j),glm::vec2(i,j),glm::vec2(i,j), glm::vec2(i,j), GHOST_SPEED, 1, false};
-                _ghosts.emplace_back(ghost);
             }
             else if(world_matrix[i][j]==3){
-                glm::mat4 transToHeight = glm::translate( glm::mat4(1.0), glm::vec3(0, 1.0f, 0) );
-                glm::mat4 modelMatrix = transToSpotMtx * transToHeight;
-                
+                // cars are created in the same order the simulation places them
                 Plane* car = new Plane(_shaderProgram->getShaderProgramHandle(),
                                   _shaderUniformLocations.mvpMatrix,
+                                  _shaderUniformLocations.modelMatrix,
                                   _shaderUniformLocations.normalMatrix,
                                   _shaderUniformLocations.materialColor);
                 
                 CarData carData = {
                     car,
-                    glm::vec2(i*3, j*3),
-                    false
+                    glm::vec2(i*3, j*3)
                 };
                 _carData.push_back(carData);
             }
@@ -439,566 +721,639 @@ void FPEngine::_generateEnvironment() {
 //
 // Rendering / Drawing Functions - this is where the magic happens!
 
-void FPEngine::_renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const {
-    // shader uniforms and attribues
-    CSCI441::ShaderProgram* shader;
-    TextureShaderUniformLocations uniforms;
-    TextureShaderAttributeLocations attributes;
-
-    //set shader program, uniforms and attributes based on whether we are using the glitched or normal shader
-    if(_hitTimer>0 && !_isExploding){
-        shader = _slenderShaderProgram;
-        uniforms = _slenderShaderUniformLocations;
-        attributes = _slenderShaderAttributeLocations;
-        glProgramUniform1i(_slenderShaderProgram->getShaderProgramHandle(),_shaderUniformLocations.time,_hitTimer);
-    }
-    else {
-        shader = _shaderProgram;
-        uniforms = _shaderUniformLocations;
-        attributes = _shaderAttributeLocations;
-    }
-    shader->useProgram();
+void FPEngine::_renderScene(glm::mat4 viewMtx, glm::mat4 projMtx, const RenderSnapshot& snapshot, GLfloat alpha, bool depthPrepassed) const {
+    // the hit glitch is a post pass, every object is drawn with the one scene shader
+    CSCI441::ShaderProgram* shader = _shaderProgram;
+    const TextureShaderUniformLocations& uniforms = _shaderUniformLocations;
+    GLStats::useProgram(shader->getShaderProgramHandle());
 
     glm::vec3 defaultColor = glm::vec3(-1,-1,-1);
-    glProgramUniform3fv(shader->getShaderProgramHandle(), uniforms.materialColor, 1, glm::value_ptr(defaultColor));
+    GLStats::programUniform3fv(shader->getShaderProgramHandle(), uniforms.materialColor, 1, glm::value_ptr(defaultColor));
+
+    //*************************************************************************
+    // Opaque pass - blending off and no alpha test, so the depth test can run
+    // before shading
+    GLStats::programUniform1i(shader->getShaderProgramHandle(), uniforms.alphaTest, 0);
+    _lightGrid->bind(LIGHT_GRID_FIRST_UNIT);
+    if(_lightmapTexture) {
+        GLStats::activeTexture(GL_TEXTURE0 + LIGHTMAP_UNIT);
+        GLStats::bindTexture(GL_TEXTURE_2D_ARRAY, _lightmapTexture);
+        GLStats::activeTexture(GL_TEXTURE0);
+        // floor and walls never move, their ambient and directional light is baked
+        GLStats::programUniform1i(shader->getShaderProgramHandle(), uniforms.useLightmap, 1);
+    }
     glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.1f, 0.0f));
     glm::mat4 mvpMtx = projMtx * viewMtx * modelMatrix;
-    shader->setProgramUniform(uniforms.mvpMatrix, mvpMtx);
+    GLStats::setProgramUniform(shader, uniforms.mvpMatrix, mvpMtx);
+    GLStats::setProgramUniform(shader, uniforms.modelMatrix, modelMatrix);
     glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-    shader->setProgramUniform(uniforms.normalMatrix, normalMatrix);
+    GLStats::setProgramUniform(shader, uniforms.normalMatrix, normalMatrix);
 
-
-    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GROUND]);
-
-    glBindVertexArray( _vaos[VAO_ID::PLATFORM] );
-    glDrawElements( GL_TRIANGLE_STRIP, _numVAOPoints[VAO_ID::PLATFORM], GL_UNSIGNED_SHORT, (void*)nullptr );
-
-    for( const BuildingData& currentBuilding : _buildings ) {
-        glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::BUILDING]);
-        mvpMtx = projMtx * viewMtx * currentBuilding.modelMatrix;
-        shader->setProgramUniform(uniforms.mvpMatrix, mvpMtx);
-        CSCI441::drawSolidCubeTextured(1.0);
+    // the prepass already holds the final depth of the maze, only shade what matches it
+    if(depthPrepassed) {
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
     }
-    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::LAVA]);
-    for( const PointsData& currentPoint : _points){
 
-        mvpMtx = projMtx * viewMtx * currentPoint.modelMatrix;
-        shader->setProgramUniform(uniforms.mvpMatrix, mvpMtx);
-        CSCI441::drawSolidSphere(0.2,8,8);
+    // opaque draws nearest first, the walls hide most of the floor so it comes after them
+    {
+        FP_PROFILE_ZONE("buildings");
+        GLStats::bindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::BUILDING]);
+        for( GLuint i : _buildingOrder ) {
+            GLStats::setProgramUniform(shader, uniforms.mvpMatrix, _buildingDrawList[i].mvpMatrix);
+            GLStats::setProgramUniform(shader, uniforms.modelMatrix, _buildings[i].modelMatrix);
+            GLStats::drawSolidCubeTextured(1.0);
+        }
     }
 
-    for (const Ghost& ghost : _ghosts) {
-        // Calculate billboard matrix
-        glm::vec3 ghostPos = glm::vec3(ghost.current_pos.x*3, 1.0f, ghost.current_pos.y*3);
-        glm::mat4 billboardModel = _createBillboardMatrix(ghostPos, viewMtx);
-        
-        // Set uniforms
-        glm::mat4 mvpMtx = projMtx * viewMtx * billboardModel;
-        shader->setProgramUniform(uniforms.mvpMatrix, mvpMtx);
-        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(billboardModel)));
-        shader->setProgramUniform(uniforms.normalMatrix, normalMatrix);
-        
-        // Bind ghost texture
-        glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GHOST]);
-        
-        // Draw billboard quad
-        glBindVertexArray(_vaos[VAO_ID::QUAD]);
-        glDrawElements(GL_TRIANGLE_STRIP, _numVAOPoints[VAO_ID::QUAD], GL_UNSIGNED_SHORT, (void*)nullptr);
+    GLStats::setProgramUniform(shader, uniforms.mvpMatrix, mvpMtx);
+    GLStats::setProgramUniform(shader, uniforms.modelMatrix, modelMatrix);
+    GLStats::bindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GROUND]);
+
+    _setPositionUnpacking(shader, uniforms.positionScale, uniforms.positionOffset, _vaoBounds[VAO_ID::PLATFORM]);
+    GLStats::bindVertexArray( _vaos[VAO_ID::PLATFORM] );
+    GLStats::drawElements( GL_TRIANGLE_STRIP, _numVAOPoints[VAO_ID::PLATFORM], GL_UNSIGNED_SHORT, (void*)nullptr );
+    _setPositionUnpacking(shader, uniforms.positionScale, uniforms.positionOffset, PackedBounds());
+    // everything from here on moves and is lit live
+    if(_lightmapTexture) {
+        GLStats::programUniform1i(shader->getShaderProgramHandle(), uniforms.useLightmap, 0);
+    }
+    {
+        FP_PROFILE_ZONE("points");
+        GLStats::bindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::LAVA]);
+        for( GLuint i : _pointOrder ){
+            GLStats::setProgramUniform(shader, uniforms.mvpMatrix, _pointDrawList[i].mvpMatrix);
+            GLStats::setProgramUniform(shader, uniforms.modelMatrix, glm::translate(glm::mat4(1.0f), glm::vec3(snapshot.pointPositions[i].x, 1.0f, snapshot.pointPositions[i].y)));
+            GLStats::drawSolidSphere(0.2, _quality.pelletSphereDetail, _quality.pelletSphereDetail);
+        }
     }
+    if(depthPrepassed) {
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+
+    FP_PROFILE_ZONE("ghosts and cars");
+    // the walls are all in the depth buffer now, test what hides behind them
+    _queryDynamicOcclusion(viewMtx, projMtx, snapshot, alpha);
+    GLStats::useProgram(shader->getShaderProgramHandle());
 
     modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.1f, 0.0f));
     modelMatrix = glm::rotate( modelMatrix, _objectAngle, CSCI441::Y_AXIS );
     mvpMtx = projMtx * viewMtx * modelMatrix;
-    shader->setProgramUniform(uniforms.mvpMatrix, mvpMtx);
+    GLStats::setProgramUniform(shader, uniforms.mvpMatrix, mvpMtx);
 
-    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::BLOOD]);
-    if(_isExploding) {
-        _particleSystem->draw(viewMtx, projMtx);
-    }
     modelMatrix = glm::mat4(1.0f);
     modelMatrix = glm::translate(modelMatrix, glm::vec3(0, 0, 0));
     modelMatrix = glm::scale(modelMatrix, glm::vec3(1.f));
 
     // Draw static car
-    for(const CarData& carData : _carData) {
-        if(!carData.collected) {
+    for(size_t i = 0; i < _carData.size(); i++) {
+        const CarData& carData = _carData[i];
+        if(!snapshot.carCollected[i]) {
             glm::mat4 carModelMatrix = glm::translate(glm::mat4(1.0f), 
                 glm::vec3(carData.position.x, 0.0f, carData.position.y));
+            if(_occlusionCuller) _occlusionCuller->beginConditional(_carOcclusionIndex(i, snapshot));
             carData.car->drawPlane(carModelMatrix, viewMtx, projMtx);
+            if(_occlusionCuller) _occlusionCuller->endConditional();
         }
     }
-}
-
-void FPEngine::_updateScene() {
 
-    //set shader program, uniforms and attributes based on whether we are using the glitched or normal shader
-    CSCI441::ShaderProgram* shader;
-    TextureShaderUniformLocations uniforms;
-    TextureShaderAttributeLocations attributes;
-    if(_hitTimer>0){
-        shader = _slenderShaderProgram;
-        uniforms = _slenderShaderUniformLocations;
-        attributes = _slenderShaderAttributeLocations;
-        glProgramUniform1f(_slenderShaderProgram->getShaderProgramHandle(),_shaderUniformLocations.time,_hitTimer);
-        _hitTimer--;
-    }
-    else {
-        shader = _shaderProgram;
-        uniforms = _shaderUniformLocations;
-        attributes = _shaderAttributeLocations;
-    }
-    // Handle ghost collision explosion
-    if(NUM_LIVES<=0 && !_isExploding) {
-        _isExploding = true;
-        _particleSystem->spawn(glm::vec3(_pos.x,
-                                        _currentHeight,
-                                        _pos.y));
-        return;
-    }
-    
-    // Handle explosion animation and reset
-    if(_isExploding) {
-        _particleSystem->update(0.016f);
+    //*************************************************************************
+    // Alpha tested pass - the ghost billboards cut their outline out of a quad,
+    // still without blending so they need no sorting
+    GLStats::programUniform1i(shader->getShaderProgramHandle(), uniforms.alphaTest, 1);
+    // the cars left their own colors behind, the ghosts take theirs from the texture
+    GLStats::programUniform3fv(shader->getShaderProgramHandle(), uniforms.materialColor, 1, glm::value_ptr(defaultColor));
+    _setPositionUnpacking(shader, uniforms.positionScale, uniforms.positionOffset, _vaoBounds[VAO_ID::QUAD]);
+    for (size_t i = 0; i < snapshot.ghostPositions.size(); i++) {
+        const glm::vec2 ghostGridPos = glm::mix(snapshot.previousGhostPositions[i], snapshot.ghostPositions[i], alpha);
+        // Calculate billboard matrix
+        glm::vec3 ghostPos = glm::vec3(ghostGridPos.x*3, 1.0f, ghostGridPos.y*3);
+        glm::mat4 billboardModel = createBillboardMatrix(ghostPos, viewMtx);
         
-        if(!_particleSystem->isAlive()) {
-            // Reset everything after explosion
-            _isExploding = false;
-            _pos = glm::vec2(_spawnPosition.x, _spawnPosition.z);
-            _direction = 0.0f;
-            _currentHeight = _spawnPosition.y;
-            NUM_LIVES = 5;
-            generate_points();
-        }
-        return;
+        // Set uniforms
+        glm::mat4 mvpMtx = projMtx * viewMtx * billboardModel;
+        GLStats::setProgramUniform(shader, uniforms.mvpMatrix, mvpMtx);
+        GLStats::setProgramUniform(shader, uniforms.modelMatrix, billboardModel);
+        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(billboardModel)));
+        GLStats::setProgramUniform(shader, uniforms.normalMatrix, normalMatrix);
+        
+        // Bind ghost texture
+        GLStats::bindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::GHOST]);
+        
+        // Draw billboard quad
+        GLStats::bindVertexArray(_vaos[VAO_ID::QUAD]);
+        if(_occlusionCuller) _occlusionCuller->beginConditional(i);
+        GLStats::drawElements(GL_TRIANGLE_STRIP, _numVAOPoints[VAO_ID::QUAD], GL_UNSIGNED_SHORT, (void*)nullptr);
+        if(_occlusionCuller) _occlusionCuller->endConditional();
     }
+    _setPositionUnpacking(shader, uniforms.positionScale, uniforms.positionOffset, PackedBounds());
+    GLStats::programUniform1i(shader->getShaderProgramHandle(), uniforms.alphaTest, 0);
+}
 
-
-
-    if(_pos.x > WORLD_SIZE_X*3-3.1){
-        _pos.x = WORLD_SIZE_X*3-3;
-    }
-    if(_pos.y > WORLD_SIZE_Y*3-3.1){
-        _pos.y = WORLD_SIZE_Y*3-3;
-    }
-    if(_pos.x < 0){
-        _pos.x = 0;
+void FPEngine::_queryDynamicOcclusion(const glm::mat4& viewMtx, const glm::mat4& projMtx, const RenderSnapshot& snapshot, GLfloat alpha) const {
+    if(!_occlusionCuller) return;
+    FP_PROFILE_ZONE("occlusion queries");
+
+    const glm::mat4 viewProjMtx = projMtx * viewMtx;
+    const glm::vec3 cameraPosition = glm::vec3(glm::inverse(viewMtx)[3]);
+    _occlusionCuller->beginFrame((GLuint)(snapshot.ghostPositions.size() + _carData.size()));
+    // only one occlusion query may be active, and the proxies are no shaded fragments anyway
+    _fragmentCounter->suspend();
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    GLStats::useProgram(_depthShaderProgram->getShaderProgramHandle());
+
+    const auto queryBox = [&](GLuint object, const glm::vec3& center, const glm::vec3& halfExtent) {
+        // from inside the box its faces are clipped away and the query would see nothing,
+        // the object is drawn unconditionally then
+        if(glm::all(glm::lessThan(glm::abs(cameraPosition - center), halfExtent + OCCLUSION_CAMERA_MARGIN))) return;
+        const glm::mat4 boxMtx = glm::scale(glm::translate(glm::mat4(1.0f), center), halfExtent * 2.0f);
+        GLStats::setProgramUniform(_depthShaderProgram, _depthMvpMatrixLocation, viewProjMtx * boxMtx);
+        _occlusionCuller->beginQuery(object);
+        GLStats::drawSolidCube(1.0f);
+        _occlusionCuller->endQuery();
+    };
+    for(size_t i = 0; i < snapshot.ghostPositions.size(); i++) {
+        const glm::vec2 ghostGridPos = glm::mix(snapshot.previousGhostPositions[i], snapshot.ghostPositions[i], alpha);
+        // the billboard turns around y, its box holds it facing any way
+        queryBox((GLuint)i, glm::vec3(ghostGridPos.x*3, 1.0f, ghostGridPos.y*3), glm::vec3(GHOST_HALF_SIZE));
     }
-    if(_pos.y < 0){
-        _pos.y = 0;
+    for(size_t i = 0; i < _carData.size(); i++) {
+        if(snapshot.carCollected[i]) continue;
+        glm::vec3 center, halfExtent;
+        _carData[i].car->getBounds(glm::translate(glm::mat4(1.0f), glm::vec3(_carData[i].position.x, 0.0f, _carData[i].position.y)), center, halfExtent);
+        queryBox(_carOcclusionIndex(i, snapshot), center, halfExtent);
     }
-    //get player position in grid
-    glm::vec2 player_aligned_pos = glm::vec2(std::round(_pos.x/3.0f), std::round(_pos.y/3.0f));
-    //fprintf(stdout, "player aligned position: (%f,%f)\n", player_aligned_pos.x, player_aligned_pos.y);
-    // move ghosts
-    for( Ghost& ghost : _ghosts){
-        // Skip ghost movement if frozen
-        if (_ghostFreezeTimer > 0) {
-            continue;  // Skip the movement code while frozen
-        }
 
-        if (!ghost.is_moving) {
-            ghost.start_pos = ghost.current_pos;
-            ghost.target_pos = findBestMove(world_matrix, ghost.current_pos,player_aligned_pos);
-
-            // Only start moving if target is different
-            if (ghost.target_pos != ghost.start_pos) {
-                ghost.is_moving = true;
-                ghost.progress = 0.0f;
-            }
-        }
-        // Update movement progress
-        if (ghost.is_moving) {
-            ghost.progress += GHOST_SPEED;
-
-            // Interpolate position
-            ghost.current_pos = glm::mix(ghost.start_pos, ghost.target_pos, glm::clamp(ghost.progress, 0.0f, 1.0f));
-
-            // Check if movement is complete
-            if (ghost.progress >= 1.0f) {
-                ghost.current_pos = ghost.target_pos;
-                ghost.is_moving = false;
-            }
-        }
-    }
-    //check collisions with ghosts
-    for(Ghost& ghost : _ghosts){
-        float distance = glm::distance(_pos,glm::vec2(ghost.current_pos.x*3, ghost.current_pos.y*3));
-        if(distance<1.2){
-            NUM_LIVES-=1;
-            ghost.current_pos=ghost.spawn_pos;
-            ghost.start_pos=ghost.spawn_pos;
-            ghost.target_pos = ghost.spawn_pos;
-
-            fprintf(stdout,"You have been hit by a ghost, %d lives remaining\n",NUM_LIVES);
-            _hitTimer = 120;
-        }
-    }
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    _fragmentCounter->resume();
+}
 
-    if(NUM_LIVES<=0){
-        fprintf(stdout,"You have lost all of your lives, you lose.\n");
-        //_isExploding = true;
+void FPEngine::_renderParticles(const std::vector<Particle>& particles, const glm::mat4& viewMtx, const glm::mat4& projMtx) {
+    const GLuint shaderProgramHandle = _shaderProgram->getShaderProgramHandle();
+    GLStats::useProgram(shaderProgramHandle);
+    GLStats::bindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::BLOOD]);
+
+    // particles are emitted in random directions, the first ones are as good a sample as any
+    const size_t numDrawn = std::min(particles.size(), (size_t)_quality.maxParticles);
+    if(numDrawn == 0) return;
+
+    // over blending only composites correctly back to front, view space z grows toward the camera
+    _particleDepths.resize(numDrawn);
+    _particleOrder.resize(numDrawn);
+    for(size_t i = 0; i < numDrawn; i++) {
+        _particleDepths[i] = (viewMtx * glm::vec4(particles[i].position, 1.0f)).z;
+        _particleOrder[i] = (GLuint)i;
     }
-    // Check collisions with points
-    for(PointsData& point : _points){
-        float distance = glm::distance(_pos, point.position);
-        if(distance<1){
-            point.toBeDeleted = true;
+    std::sort(_particleOrder.begin(), _particleOrder.end(), [this](GLuint a, GLuint b) {
+        return _particleDepths[a] < _particleDepths[b];
+    });
+
+    //*************************************************************************
+    // Transparent pass - tested against the scene's depth but not writing it,
+    // so particles never hide the ones drawn after them
+    glEnable(GL_BLEND);
+    glDepthMask(GL_FALSE);
+    GLStats::programUniform1i(shaderProgramHandle, _shaderUniformLocations.alphaTest, 0);
+
+    // all particles go up in one write to this frame's region of the stream buffer
+    GLintptr instanceOffset = 0;
+    ParticleInstance* instances = (ParticleInstance*)_streamBuffer->map((GLsizeiptr)(numDrawn * sizeof(ParticleInstance)), alignof(ParticleInstance), instanceOffset);
+    if(instances) {
+        for(size_t i = 0; i < numDrawn; i++) {
+            const Particle& p = particles[_particleOrder[i]];
+            instances[i].centerSize = glm::vec4(p.position, p.size);
+            instances[i].color = glm::vec4(p.color, p.life);
         }
+        _streamBuffer->unmap();
+
+        GLStats::bindVertexArray(_vaos[VAO_ID::PARTICLE]);
+        glBindBuffer(GL_ARRAY_BUFFER, _streamBuffer->getBuffer());
+        glVertexAttribPointer(_shaderAttributeLocations.instanceCenterSize, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(instanceOffset + offsetof(ParticleInstance, centerSize)));
+        glVertexAttribPointer(_shaderAttributeLocations.instanceColor, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(instanceOffset + offsetof(ParticleInstance, color)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // the instances carry their own placement, the matrices only hold the camera
+        const glm::mat4 viewProjMtx = projMtx * viewMtx;
+        const glm::mat4 identityMtx(1.0f);
+        GLStats::programUniformMatrix4fv(shaderProgramHandle, _shaderUniformLocations.mvpMatrix, 1, GL_FALSE, &viewProjMtx[0][0]);
+        GLStats::programUniformMatrix4fv(shaderProgramHandle, _shaderUniformLocations.modelMatrix, 1, GL_FALSE, &identityMtx[0][0]);
+        GLStats::setProgramUniform(_shaderProgram, _shaderUniformLocations.normalMatrix, glm::mat3(1.0f));
+        _setPositionUnpacking(_shaderProgram, _shaderUniformLocations.positionScale, _shaderUniformLocations.positionOffset, _vaoBounds[VAO_ID::PARTICLE]);
+        GLStats::programUniform1i(shaderProgramHandle, _shaderUniformLocations.instanced, 1);
+
+        GLStats::drawElementsInstanced(GL_TRIANGLES, _numVAOPoints[VAO_ID::PARTICLE], GL_UNSIGNED_SHORT, (void*)nullptr, (GLsizei)numDrawn);
+
+        GLStats::programUniform1i(shaderProgramHandle, _shaderUniformLocations.instanced, 0);
+        _setPositionUnpacking(_shaderProgram, _shaderUniformLocations.positionScale, _shaderUniformLocations.positionOffset, PackedBounds());
     }
+    
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
 
-    // delete points that have been collected
-    _points.erase(
-            std::remove_if(_points.begin(), _points.end(),
-                           [](const PointsData& point) { return point.toBeDeleted; }),
-            _points.end()
-    );
-
-    //check to see if all points have been collected
-    if(_points.size()==0){
-        fprintf(stdout,"You have collected all of the points, congratulations!");
-        generate_points();
-        GHOST_SPEED += 0.005;
-    }
-
-
-    float speed = 0.15f;
-
-    // Rest of update code (movement, ghosts, etc.)
-    if(_keys[GLFW_KEY_W]) {
-        // Calculate new position
-        glm::vec2 newPos = _pos;
-        newPos.x += speed * glm::sin(_direction);
-        newPos.y += speed * glm::cos(_direction);
-        
-        // Check for collisions
-        if(!_checkCollisions(newPos)) {
-            // No collision, update position
-            _pos = newPos;
-            _lastValidPosition = newPos;
-            _lastDir = 0;
-        } else {
-            // Collision detected, revert to last valid position
-            CollisionObject* col = CollisionDetector::getCollidedObject(newPos);
-            bool x = false;
-            bool z = false;
-            if(_lastValidPosition.x > col->position.x + col->radius){
-                z = true;
-            }else if(_lastValidPosition.x < col->position.x - col->radius){
-                z = true;
-            } 
-            
-            if(_lastValidPosition.y > col->position.z + col->radius){
-                x = true;
-            }else if(_lastValidPosition.y < col->position.z - col->radius){
-                x = true;
-            }
+void FPEngine::_streamFrameUniforms(const RenderSnapshot& snapshot, const glm::vec3& viewVector) {
+    GLintptr offset = 0;
+    FrameUniforms* frameUniforms = (FrameUniforms*)_uniformStreamBuffer->mapUniformBlock(sizeof(FrameUniforms), offset);
+    if(!frameUniforms) return;
+    // flashlight published by the simulation
+    frameUniforms->pointLightPosition = glm::vec4(snapshot.pointLightPosition, 1.0f);
+    frameUniforms->pointLightColor = glm::vec4(snapshot.pointLightColor, 0.0f);
+    frameUniforms->viewVector = glm::vec4(viewVector, 0.0f);
+    _uniformStreamBuffer->unmap();
+    _uniformStreamBuffer->bindUniformBlock(FRAME_UNIFORM_BINDING, offset, sizeof(FrameUniforms));
+}
 
-            if(x && (_lastDir == 0 || _lastDir == 1)){
-                _pos.x += speed * glm::sin(_direction);
-                _lastDir = 1;
-            }
-            if(z && (_lastDir == 0 || _lastDir == 2)){
-                _pos.y += speed * glm::cos(_direction);
-                _lastDir = 2;
+void FPEngine::_cullScene(const glm::mat4& viewMtx, const glm::mat4& projMtx, const RenderSnapshot& snapshot) {
+    FP_PROFILE_ZONE("cull");
+    ScopedStageTimer timer(_cullTimeMs);
+
+    const glm::mat4 viewProjMtx = projMtx * viewMtx;
+    glm::vec4 frustumPlanes[6];
+    extractFrustumPlanes(viewProjMtx, frustumPlanes);
+    const glm::vec3 cameraPosition = glm::vec3(glm::inverse(viewMtx)[3]);
+
+    // buildings are 3x3x3 cubes, points are spheres of radius 0.2
+    const GLfloat BUILDING_RADIUS = 2.6f;
+    const GLfloat POINT_RADIUS = 0.2f;
+
+    _buildingDrawList.resize(_buildings.size());
+    _jobSystem->parallelFor(0, _buildings.size(), CULL_GRAIN_SIZE, [&](size_t first, size_t last) {
+        for(size_t i = first; i < last; i++) {
+            const glm::mat4& modelMtx = _buildings[i].modelMatrix;
+            const glm::vec3 center = glm::vec3(modelMtx[3]);
+            _buildingDrawList[i].visible = sphereInFrustum(frustumPlanes, center, BUILDING_RADIUS);
+            if(_buildingDrawList[i].visible) {
+                _buildingDrawList[i].mvpMatrix = viewProjMtx * modelMtx;
+                _buildingDrawList[i].distance = glm::dot(center - cameraPosition, center - cameraPosition);
             }
-            if(_checkCollisions(_pos)){
-                _pos = _lastValidPosition;
-                _lastDir = 0;
-            }else{
-                _lastValidPosition = _pos;
+        }
+    });
+
+    _pointDrawList.resize(snapshot.pointPositions.size());
+    _jobSystem->parallelFor(0, snapshot.pointPositions.size(), CULL_GRAIN_SIZE, [&](size_t first, size_t last) {
+        for(size_t i = first; i < last; i++) {
+            const glm::vec3 center = glm::vec3(snapshot.pointPositions[i].x, 1.0f, snapshot.pointPositions[i].y);
+            _pointDrawList[i].visible = sphereInFrustum(frustumPlanes, center, POINT_RADIUS);
+            if(_pointDrawList[i].visible) {
+                _pointDrawList[i].mvpMatrix = viewProjMtx * glm::translate(glm::mat4(1.0f), center);
+                _pointDrawList[i].distance = glm::dot(center - cameraPosition, center - cameraPosition);
             }
         }
+    });
 
+    _sortFrontToBack(_buildingDrawList, _buildingOrder);
+    _sortFrontToBack(_pointDrawList, _pointOrder);
+}
 
+void FPEngine::_sortFrontToBack(const std::vector<DrawItem>& drawList, std::vector<GLuint>& order) {
+    order.clear();
+    for(GLuint i = 0; i < drawList.size(); i++) {
+        if(drawList[i].visible) order.push_back(i);
     }
-    if(_keys[GLFW_KEY_S]){
-        glm::vec2 newPos = _pos;
-        newPos.x -= speed * glm::sin(_direction);
-        newPos.y -= speed * glm::cos(_direction);
-        
-        if(!_checkCollisions(newPos)) {
-            // No collision, update position
-            _pos = newPos;
-            _lastValidPosition = newPos;
-            _lastDir = 0;
-        } else {
-            // Collision detected, revert to last valid position
-            CollisionObject* col = CollisionDetector::getCollidedObject(newPos);
-            bool x = false;
-            bool z = false;
-            if(_lastValidPosition.x > col->position.x + col->radius){
-                z = true;
-            }else if(_lastValidPosition.x < col->position.x - col->radius){
-                z = true;
-            }
+    std::sort(order.begin(), order.end(), [&drawList](GLuint a, GLuint b) {
+        return drawList[a].distance < drawList[b].distance;
+    });
+}
 
-            if(_lastValidPosition.y > col->position.z + col->radius){
-                x = true;
-            }else if(_lastValidPosition.y < col->position.z - col->radius){
-                x = true;
-            }
+void FPEngine::_renderDepthPrepass(const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
+    const glm::mat4 viewProjMtx = projMtx * viewMtx;
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    GLStats::useProgram(_depthShaderProgram->getShaderProgramHandle());
 
-            if(x && (_lastDir == 0 || _lastDir == 1)){
-                _pos.x -= speed * glm::sin(_direction);
-                _lastDir = 1;
-            }
-            if(z && (_lastDir == 0 || _lastDir == 2)){
-                _pos.y -= speed * glm::cos(_direction);
-                _lastDir = 2;
-            }
-            if(_checkCollisions(_pos)){
-                _pos = _lastValidPosition;
-                _lastDir = 0;
-            }else{
-                _lastValidPosition = _pos;
-            }
-        }
+    for(GLuint i : _buildingOrder) {
+        GLStats::setProgramUniform(_depthShaderProgram, _depthMvpMatrixLocation, _buildingDrawList[i].mvpMatrix);
+        GLStats::drawSolidCubeTextured(1.0);
+    }
+    const glm::mat4 platformMtx = viewProjMtx * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.1f, 0.0f));
+    GLStats::setProgramUniform(_depthShaderProgram, _depthMvpMatrixLocation, platformMtx);
+    _setPositionUnpacking(_depthShaderProgram, _depthPositionScaleLocation, _depthPositionOffsetLocation, _vaoBounds[VAO_ID::PLATFORM]);
+    GLStats::bindVertexArray(_vaos[VAO_ID::PLATFORM]);
+    GLStats::drawElements(GL_TRIANGLE_STRIP, _numVAOPoints[VAO_ID::PLATFORM], GL_UNSIGNED_SHORT, (void*)nullptr);
+    _setPositionUnpacking(_depthShaderProgram, _depthPositionScaleLocation, _depthPositionOffsetLocation, PackedBounds());
+    for(GLuint i : _pointOrder) {
+        GLStats::setProgramUniform(_depthShaderProgram, _depthMvpMatrixLocation, _pointDrawList[i].mvpMatrix);
+        GLStats::drawSolidSphere(0.2, _quality.pelletSphereDetail, _quality.pelletSphereDetail);
     }
 
-    //turn when A or D pressed
-    if(_keys[GLFW_KEY_A]){
-        // Calculate new position
-        glm::vec2 newPos = _pos;
-        newPos.x += speed * glm::sin(_direction + M_PI/2);
-        newPos.y += speed * glm::cos(_direction + M_PI/2);
-        
-        // Check for collisions
-        if(!_checkCollisions(newPos)) {
-            // No collision, update position
-            _pos = newPos;
-            _lastValidPosition = newPos;
-            _lastDir = 0;
-        } else {
-            // Collision detected, revert to last valid position
-            CollisionObject* col = CollisionDetector::getCollidedObject(newPos);
-            bool x = false;
-            bool z = false;
-            if(_lastValidPosition.x > col->position.x + col->radius){
-                z = true;
-            }else if(_lastValidPosition.x < col->position.x - col->radius){
-                z = true;
-            }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
 
-            if(_lastValidPosition.y > col->position.z + col->radius){
-                x = true;
-            }else if(_lastValidPosition.y < col->position.z - col->radius){
-                x = true;
-            }
+void FPEngine::_reportStageTimings() {
+    fprintf(stdout, "[INFO]: average render stage timings over %u frames on %u threads: culling %.3fms, %.0f fragments shaded per frame%s\n",
+            _stageFrames, _jobSystem->getNumThreads(), _cullTimeMs / _stageFrames, _shadedFragments / _stageFrames,
+            _options.depthPrepass ? " after the depth prepass" : "");
+    fprintf(stdout, "[INFO]: render graph: %.1f passes per frame, %.1f culled, %u pooled targets\n",
+            _graphPasses / _stageFrames, _graphCulled / _stageFrames, _renderGraph->getNumPooledTargets());
+    _cullTimeMs = 0.0;
+    _shadedFragments = 0.0;
+    _graphPasses = 0.0;
+    _graphCulled = 0.0;
+    _stageFrames = 0;
+}
 
-            if(x && (_lastDir == 0 || _lastDir == 1)){
-                _pos.x += speed * glm::sin(_direction + M_PI/2);
-                _lastDir = 1;
-            }
-            if(z && (_lastDir == 0 || _lastDir == 2)){
-                _pos.y += speed * glm::cos(_direction + M_PI/2);
-                _lastDir = 2;
-            }
-            if(_checkCollisions(_pos)){
-                _pos = _lastValidPosition;
-                _lastDir = 0;
-            }else{
-                _lastValidPosition = _pos;
-            }
+void FPEngine::_latchInput(GLuint frameIndex) {
+    FP_PROFILE_ZONE("latch input");
+    if(_inputReplay) {
+        InputEvent event;
+        while(_inputReplay->nextEvent(frameIndex, event)) {
+            _applyReplayEvent(event);
         }
-
-
     }
-    if(_keys[GLFW_KEY_D]){
-        // Calculate new position
-        glm::vec2 newPos = _pos;
-        newPos.x += speed * glm::sin(_direction - M_PI/2);
-        newPos.y += speed * glm::cos(_direction - M_PI/2);
-        
-        // Check for collisions
-        if(!_checkCollisions(newPos)) {
-            // No collision, update position
-            _pos = newPos;
-            _lastValidPosition = newPos;
-            _lastDir = 0;
-        } else {
-            // Collision detected, revert to last valid position
-            CollisionObject* col = CollisionDetector::getCollidedObject(newPos);
-            bool x = false;
-            bool z = false;
-            if(_lastValidPosition.x > col->position.x + col->radius){
-                z = true;
-            }else if(_lastValidPosition.x < col->position.x - col->radius){
-                z = true;
-            }
+    // still polled while replaying so the window stays responsive and Escape can stop it
+    _inputFrame = frameIndex;
+    glfwPollEvents();
+    _publishInput();
+}
 
-            if(_lastValidPosition.y > col->position.z + col->radius){
-                x = true;
-            }else if(_lastValidPosition.y < col->position.z - col->radius){
-                x = true;
-            }
+void FPEngine::_publishInput() {
+    GLuint buttons = 0;
+    if(_keys[GLFW_KEY_W]) buttons |= INPUT_FORWARD;
+    if(_keys[GLFW_KEY_S]) buttons |= INPUT_BACKWARD;
+    if(_keys[GLFW_KEY_A]) buttons |= INPUT_LEFT;
+    if(_keys[GLFW_KEY_D]) buttons |= INPUT_RIGHT;
+    _inputButtons.store(buttons, std::memory_order_relaxed);
+    _inputDirection.store(_direction, std::memory_order_relaxed);
+}
 
-            if(x && (_lastDir == 0 || _lastDir == 1)){
-                _pos.x += speed * glm::sin(_direction - M_PI/2);
-                _lastDir = 1;
-            }
-            if(z && (_lastDir == 0 || _lastDir == 2)){
-                _pos.y += speed * glm::cos(_direction - M_PI/2);
-                _lastDir = 2;
-            }
-            if(_checkCollisions(_pos)){
-                _pos = _lastValidPosition;
-                _lastDir = 0;
-            }else{
-                _lastValidPosition = _pos;
-            }
-        }
+void FPEngine::_stepSimulation(GLdouble now) {
+    FP_PROFILE_ZONE("simulation step");
+    _simulationAccumulator += std::min(now - _lastSimulationTime, MAX_SIMULATION_STEP);
+    _lastSimulationTime = now;
 
+    if(_simulationAccumulator < _tickSeconds) return;
 
+    Simulation::Input input;
+    const GLuint buttons = _inputButtons.load(std::memory_order_relaxed);
+    input.forward = buttons & INPUT_FORWARD;
+    input.backward = buttons & INPUT_BACKWARD;
+    input.left = buttons & INPUT_LEFT;
+    input.right = buttons & INPUT_RIGHT;
+    input.direction = _inputDirection.load(std::memory_order_relaxed);
+
+    while(_simulationAccumulator >= _tickSeconds) {
+        _simulation->tick(input, (GLfloat)_tickSeconds);
+        _simulationAccumulator -= _tickSeconds;
     }
-    
 
-    // Update point light position to be in front of and above the plane
-    glm::vec3 planePos = glm::vec3(_pos.x+1.5, 0, _pos.y+3);
-    glm::vec3 lightOffset = glm::vec3(
-        -3.0f * glm::sin(_direction), // 3 units in front
-        2.0f,                                          // 2 units above
-        -3.0f * glm::cos(_direction)  // 3 units in front
-    );
-    
-    // Update light position uniform
-    glm::vec3 pointLightPosition = planePos + lightOffset;
-    glProgramUniform3fv(shader->getShaderProgramHandle(),
-        uniforms.pointLightPosition,
-        1,
-        glm::value_ptr(pointLightPosition));
+    RenderSnapshot& snapshot = _snapshots.getBackBuffer();
+    _simulation->writeSnapshot(snapshot);
+    snapshot.tickSeconds = (GLfloat)_tickSeconds;
+    snapshot.tickTime = now - _simulationAccumulator;
+    _snapshots.publish();
+}
 
-    // Make light brighter when moving forward
-    glm::vec3 pointLightColor;
-    if(_keys[GLFW_KEY_W]) {
-        pointLightColor = glm::vec3(0.4f, 0.4f, 0.4f); // Brighter white when moving
-    } else {
-        pointLightColor = glm::vec3(0.2f, 0.2f, 0.2f); // Dimmer white when stationary
+void FPEngine::_simulationLoop() {
+    Profiler::setThreadName("simulation");
+    while(_simulationRunning.load(std::memory_order_acquire)) {
+        _stepSimulation(glfwGetTime());
+
+        // sleep until the next tick is due
+        const GLdouble untilNextTick = _tickSeconds - _simulationAccumulator;
+        std::this_thread::sleep_for(std::chrono::duration<GLdouble>(untilNextTick));
     }
-    glProgramUniform3fv(shader->getShaderProgramHandle(),
-        uniforms.pointLightColor,
-        1,
-        glm::value_ptr(pointLightColor));
+}
+
+GLfloat FPEngine::_interpolationAlpha(const RenderSnapshot& snapshot, GLdouble now) {
+    if(snapshot.tickSeconds <= 0.0f) return 1.0f;
+    return glm::clamp((GLfloat)((now - snapshot.tickTime) / snapshot.tickSeconds), 0.0f, 1.0f);
+}
 
-    // Update ghosts only if we're not falling or exploding
-    if(!_isFalling && !_isExploding) {
+void FPEngine::run() {
+    _lastSimulationTime = _fixedClock ? 0.0 : glfwGetTime();
+    if(_inputReplay) {
+        _lastSimulationTime = _inputReplay->getStartTime();
+    } else if(_inputRecorder) {
+        _inputRecorder->setStartTime(_lastSimulationTime);
     }
+    GLdouble lastFrameTime = _lastSimulationTime;
+    GLuint frameIndex = 0;
 
-    // Add car collection logic
-    for(CarData& carData : _carData) {
-        if(!carData.collected) {
-            float distance = glm::distance(_pos, carData.position);
-            if(distance < 2.0f) {  // Adjust collision radius as needed
-                carData.collected = true;
-                _ghostFreezeTimer = GHOST_FREEZE_DURATION;  // Start freeze timer
-                fprintf(stdout, "Ghosts frozen for 10 seconds!\n");
-            }
-        }
+    if(_options.threadedSimulation) {
+        _simulationRunning = true;
+        _simulationThread = std::thread(&FPEngine::_simulationLoop, this);
     }
 
-    if (_ghostFreezeTimer > 0) {
-        _ghostFreezeTimer -= 0.016f;  // Decrease timer (assuming 60 FPS)
-        if (_ghostFreezeTimer <= 0) {
-            _ghostFreezeTimer = 0;
-            fprintf(stdout, "Ghosts unfrozen!\n");
+    Profiler::setThreadName("main");
+    while(!glfwWindowShouldClose(mpWindow)) {
+        if(_options.headless && frameIndex >= _options.headlessFrames) break;
+        if(_flythrough && _flythrough->isFinished()) break;
+        if(_inputReplay && frameIndex >= _inputReplay->getNumFrames()) break;
+        _framePacer->beginFrame();
+        const GLdouble frameStart = glfwGetTime();
+        if(_flythrough) _flythrough->beginFrame();
+
+        Profiler::beginFrame();
+        _gpuProfiler->beginFrame();
+        GLStats::beginFrame();
+        if(_gpuFrameTimer) _gpuFrameTimer->beginFrame();
+        _streamBuffer->beginFrame();
+        _uniformStreamBuffer->beginFrame();
+        FP_PROFILE_ZONE("frame");
+
+        GLdouble frameTime = _fixedClock ? frameIndex * FIXED_FRAME_SECONDS : frameStart;
+        if(_inputReplay) {
+            frameTime = _replayFrameStart(frameIndex);
+        } else if(_inputRecorder) {
+            _inputRecorder->recordFrame(frameIndex, frameTime);
         }
-    }
-}
 
-std::vector<glm::vec2> getPossibleMoves(
-        const std::vector<std::vector<int>> world_matrix,
-        const glm::vec2 current_pos
-) {
-    // Potential adjacent moves (right, left, down, up)
-    std::vector<glm::vec2> possible_moves = {
-            current_pos + glm::vec2(1, 0),   // right
-            current_pos + glm::vec2(-1, 0),  // left
-            current_pos + glm::vec2(0, 1),   // down
-            current_pos + glm::vec2(0, -1)   // up
-    };
+        const GLfloat frameDelta = (GLfloat)(frameTime - lastFrameTime);
+        lastFrameTime = frameTime;
 
-    std::vector<glm::vec2> actually_possible_moves;
-    // Filter out invalid moves
-    for(glm::vec2 move : possible_moves){
-        //fprintf(stdout,"looking at move (%f,%f)\n",move.x,move.y);
-        if(!(move.x<0 || move.y<0 || move.x>world_matrix[0].size()*3 || move.y>world_matrix.size()*3)&&world_matrix[move.x][move.y]!=1){
-            actually_possible_moves.emplace_back(move);
+        if(!_options.threadedSimulation) {
+            _stepSimulation(frameTime);
         }
-    }
 
-    return actually_possible_moves;
-}
+        const RenderSnapshot& snapshot = _snapshots.acquire();
+        const GLfloat alpha = _interpolationAlpha(snapshot, frameTime);
+        const glm::vec2 playerPosition = glm::mix(snapshot.previousPlayerPosition, snapshot.playerPosition, alpha);
 
-void FPEngine::generate_points() {
-    _points.clear();
-    for(int i=0;i<WORLD_SIZE_X;i++){
-        fprintf(stdout,"\n");
-        for(int j=0;j<WORLD_SIZE_Y;j++){
-            fprintf(stdout,"%d",world_matrix[i][j]);
-            glm::mat4 transToSpotMtx = glm::translate( glm::mat4(1.0), glm::vec3(i*3, 0.0f, j*3));
-            if(world_matrix[i][j]==0) {
-                glm::mat4 transToHeight = glm::translate( glm::mat4(1.0), glm::vec3(0, 1.0f, 0) );
-                glm::mat4 modelMatrix = transToSpotMtx * transToHeight;
-                glm::vec3 color(1,1,1);
-                PointsData currentPoint  ={modelMatrix, color, glm::vec2(i*3, j*3), false};
-                _points.emplace_back(currentPoint);
+        {
+            FP_PROFILE_ZONE("update cars");
+            for(CarData& carData : _carData) {
+                carData.car->update(frameDelta);
             }
         }
 
-    }
-}
-
-void FPEngine::run() {
-    while(!glfwWindowShouldClose(mpWindow)) {
-        glDrawBuffer(GL_BACK);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // the simulation respawned the player, point the camera back down the maze
+        if(snapshot.respawns != _lastRespawns) {
+            _direction = 0.0f;
+            _lastRespawns = snapshot.respawns;
+        }
 
         GLint framebufferWidth, framebufferHeight;
-        glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+        if(_offscreenTarget) {
+            framebufferWidth = _offscreenTarget->getWidth();
+            framebufferHeight = _offscreenTarget->getHeight();
+        } else {
+            glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+        }
+        _quality = _qualityGovernor ? _qualityGovernor->getSettings() : QualityGovernor::getFullQuality();
+        GLint sceneWidth = framebufferWidth, sceneHeight = framebufferHeight;
+        if(_quality.renderScale < 1.0f) {
+            sceneWidth = std::max(1, (GLint)(framebufferWidth * _quality.renderScale));
+            sceneHeight = std::max(1, (GLint)(framebufferHeight * _quality.renderScale));
+        }
 
-        glViewport(0, 0, framebufferWidth, framebufferHeight);
+        // everything that does not depend on the camera is done, take the freshest input now
+        _latchInput(frameIndex);
+        if(_inputRecorder || _inputReplay) {
+            _checkReplayState(frameIndex, snapshot);
+        }
 
-        glm::mat4 projMtx = glm::perspective(30.0f, (GLfloat)framebufferWidth / (GLfloat)framebufferHeight, 0.001f, 1000.0f);
+        glm::mat4 projMtx = glm::perspective(30.0f, (GLfloat)sceneWidth / (GLfloat)sceneHeight, 0.001f, 1000.0f);
         glm::vec3 position = glm::vec3(
-            _pos.x,
+            playerPosition.x,
             1.5f,
-            _pos.y
+            playerPosition.y
         );
         glm::vec3 forward = glm::vec3(
             glm::cos(_phi) * glm::sin(_direction),
             glm::sin(_phi),
             glm::cos(_phi) * glm::cos(_direction)
         );
+        if(_flythrough) {
+            _flythrough->getCamera(position, forward);
+        }
 
-        glProgramUniform3fv(_shaderProgram->getShaderProgramHandle(),
-            _shaderUniformLocations.viewVector,
-            1,
-            glm::value_ptr(glm::normalize(forward)));
+        _streamFrameUniforms(snapshot, glm::normalize(forward));
 
         glm::vec3 up = glm::vec3(0.0f, -1.0f, 0.0f);
         glm::mat4 viewMtx = glm::lookAt(position, position + forward, up);
-        _renderSkybox(viewMtx, projMtx);
-        
-        // Then render scene
-        _renderScene(viewMtx, projMtx);
+        _cullScene(viewMtx, projMtx, snapshot);
+        _buildLightGrid(snapshot, alpha);
+        _buildRenderGraph(viewMtx, projMtx, snapshot, alpha, frameDelta, frameIndex,
+                          framebufferWidth, framebufferHeight, sceneWidth, sceneHeight);
+        _renderGraph->execute(*_gpuProfiler);
+        _graphPasses += _renderGraph->getNumPasses();
+        _graphCulled += _renderGraph->getNumCulled();
+
+        if(++_stageFrames >= STAGE_REPORT_INTERVAL) {
+            _reportStageTimings();
+        }
+
+        const GLdouble frameWorkEnd = glfwGetTime();
+        _streamBuffer->endFrame();
+        _uniformStreamBuffer->endFrame();
+        if(_gpuFrameTimer) _gpuFrameTimer->endFrame();
 
-        _updateScene();
+        if(_offscreenTarget) {
+            FP_PROFILE_ZONE("finish frame");
+            _finishHeadlessFrame(frameStart);
+        } else {
+            FP_PROFILE_ZONE("swap buffers");
+            glfwSwapBuffers(mpWindow);
+        }
+        if(_options.measureLatency) {
+            _recordInputLatency();
+        }
+        if(_qualityGovernor) {
+            _qualityGovernor->update((frameWorkEnd - frameStart) * 1000.0, _gpuFrameTimer->getLastFrameMs());
+        }
+        if(_flythrough) _flythrough->endFrame();
+        frameIndex++;
+    }
 
+    if(_options.headless) {
+        _reportHeadlessTimings();
+    }
+    if(_flythrough) {
+        _flythrough->report();
+    }
+    if(_inputReplay && _replayDivergedFrame < 0) {
+        fprintf(stdout, "[INFO]: replay of %u frames matched the recording\n", frameIndex);
+    }
+    if(_options.measureLatency) {
+        _reportInputLatency();
+    }
 
+    if(_options.threadedSimulation) {
+        _simulationRunning = false;
+        _simulationThread.join();
+    }
 
-        glfwSwapBuffers(mpWindow);
-        glfwPollEvents();
+    if(!_options.profileOutput.empty()) {
+        Profiler::exportTrace(_options.profileOutput);
     }
 }
 
+//*************************************************************************************
+//
+// Render Graph
+
+void FPEngine::_buildRenderGraph(const glm::mat4& viewMtx, const glm::mat4& projMtx, const RenderSnapshot& snapshot, GLfloat alpha,
+                                 GLfloat frameDelta, GLuint frameIndex, GLint width, GLint height, GLint sceneWidth, GLint sceneHeight) {
+    RenderGraph& graph = *_renderGraph;
+    // every effect is declared, these only pick whose version the frame consumes
+    const bool scaled = sceneWidth != width || sceneHeight != height;
+    const bool hitGlitch = snapshot.hitTimer > 0 && !snapshot.isExploding && _options.hitGlitchStrength > 0.0f;
+
+    // the last pass consuming the scene draws straight into the final target, an effect that
+    // is off gets a transient of its own which is never allocated once its pass is culled
+    const RenderGraph::Resource finalTarget = graph.importTarget("final", width, height, [this] { _bindFinalTarget(); });
+    const RenderGraph::Resource sceneTarget = scaled || hitGlitch ? graph.createTarget("scene", sceneWidth, sceneHeight, hitGlitch) : finalTarget;
+    const RenderGraph::Resource glitchTarget = hitGlitch && !scaled ? finalTarget : graph.createTarget("glitched scene", sceneWidth, sceneHeight, false);
+    const RenderGraph::Resource upscaleTarget = scaled ? finalTarget : graph.createTarget("upscaled scene", width, height, false);
+
+    const bool depthPrepassed = _options.depthPrepass;
+    const RenderGraph::Resource prepassed = graph.addPass("depth prepass", {}, sceneTarget, 0, [this, &viewMtx, &projMtx] {
+        _renderDepthPrepass(viewMtx, projMtx);
+    });
+    RenderGraph::Resource image = graph.addPass("scene", {}, depthPrepassed ? prepassed : sceneTarget, 0, [this, &viewMtx, &projMtx, &snapshot, alpha, depthPrepassed] {
+        _fragmentCounter->begin();
+        _renderScene(viewMtx, projMtx, snapshot, alpha, depthPrepassed);
+        _fragmentCounter->end();
+        _shadedFragments += (GLdouble)_fragmentCounter->getLastCount();
+    });
+    // the sky only fills what the scene left uncovered
+    image = graph.addPass("skybox", {}, image, 0, [this, &viewMtx, &projMtx] {
+        _renderSkybox(viewMtx, projMtx);
+    });
+    // blended last so the particles mix with the sky behind them
+    const RenderGraph::Resource exploded = graph.addPass("particles", {}, image, 0, [this, &viewMtx, &projMtx, &snapshot] {
+        _renderParticles(snapshot.particles, viewMtx, projMtx);
+    });
+    if(snapshot.isExploding) image = exploded;
+
+    const GLfloat hitTimer = snapshot.hitTimer;
+    const RenderGraph::Resource sceneImage = image;
+    const RenderGraph::Resource glitched = graph.addPass("hit glitch", { sceneImage }, glitchTarget, RenderGraph::COVERS_TARGET, [this, sceneImage, hitTimer] {
+        _renderHitGlitch(_renderGraph->getTarget(sceneImage)->getColorTexture(), hitTimer);
+    });
+    if(hitGlitch) image = glitched;
+
+    const RenderGraph::Resource scaledImage = image;
+    const RenderGraph::Resource upscaled = graph.addPass("upscale", { scaledImage }, upscaleTarget, RenderGraph::COVERS_TARGET, [this, scaledImage, width, height] {
+        _renderGraph->getTarget(scaledImage)->blitTo(width, height);
+    });
+    if(scaled) image = upscaled;
+
+    // image is in the final target from here on
+    const RenderGraph::Resource withHud = graph.addPass("stats hud", {}, image, 0, [this, frameDelta, width, height] {
+        _renderStatsHud(frameDelta, width, height);
+    });
+    if(_statsHud->isVisible()) image = withHud;
+    graph.markOutput(image);
+
+    // also collects the read backs of earlier frames, so it runs every frame
+    graph.addPass("capture", { image }, RenderGraph::NO_RESOURCE, RenderGraph::SIDE_EFFECTS, [this, frameIndex, width, height] {
+        _captureFrame(frameIndex, width, height);
+    });
+}
+
 //*************************************************************************************
 //
 // Private Helper FUnctions
 
-void FPEngine::_renderFPV(glm::mat4 projMtx) const {
+void FPEngine::_renderFPV(glm::mat4 projMtx, const RenderSnapshot& snapshot) const {
     glm::vec3 position = glm::vec3(
-        _pos.x + 1.0f * glm::sin(_direction),
+        snapshot.playerPosition.x + 1.0f * glm::sin(_direction),
         1.0f,
-        _pos.y + 1.0f * glm::cos(_direction)
+        snapshot.playerPosition.y + 1.0f * glm::cos(_direction)
     );
 
     
@@ -1015,7 +1370,7 @@ void FPEngine::_renderFPV(glm::mat4 projMtx) const {
                               0.1f,
                               1000.0f);
     
-    _renderScene(viewMtx, projMtx);
+    _renderScene(viewMtx, projMtx, snapshot, 1.0f, false);
 }
 
 
@@ -1065,6 +1420,71 @@ GLuint FPEngine::_loadAndRegisterTexture(const char* FILENAME) {
     return textureHandle;
 }
 
+GLuint FPEngine::_loadSkyCubeMap(const char* FILENAME) {
+    // our handle to the GPU
+    GLuint textureHandle = 0;
+
+    // cube map faces start at their top row, +y on the side faces, as the image file does
+    stbi_set_flip_vertically_on_load(false);
+
+    // will hold image parameters after load
+    GLint imageWidth, imageHeight, imageChannels;
+    // load image from file, always as RGB
+    GLubyte* data = stbi_load(FILENAME, &imageWidth, &imageHeight, &imageChannels, 3);
+    if(!data) {
+        fprintf(stderr, "[ERROR]: Could not load sky texture \"%s\"\n", FILENAME);
+        return textureHandle;
+    }
+
+    // the whole image goes on every face like it did on the old textured cube, cube map faces
+    // are square so a wide image is squeezed to its height, the same stretch the cube gave it
+    GLint maxCubeMapSize = 0;
+    glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &maxCubeMapSize);
+    const GLint faceSize = std::max(std::min(std::min(imageWidth, imageHeight), maxCubeMapSize), 1);
+    const GLubyte* faceData = data;
+    std::vector<GLubyte> face;
+    if(faceSize != imageWidth || faceSize != imageHeight) {
+        face.resize((size_t)faceSize * faceSize * 3);
+        for(GLint row = 0; row < faceSize; row++) {
+            const GLfloat y = glm::clamp((row + 0.5f) * imageHeight / faceSize - 0.5f, 0.0f, (GLfloat)(imageHeight - 1));
+            const GLint y0 = (GLint)y;
+            const GLint y1 = std::min(y0 + 1, imageHeight - 1);
+            const GLfloat fy = y - y0;
+            for(GLint column = 0; column < faceSize; column++) {
+                const GLfloat x = glm::clamp((column + 0.5f) * imageWidth / faceSize - 0.5f, 0.0f, (GLfloat)(imageWidth - 1));
+                const GLint x0 = (GLint)x;
+                const GLint x1 = std::min(x0 + 1, imageWidth - 1);
+                const GLfloat fx = x - x0;
+                for(GLint c = 0; c < 3; c++) {
+                    const GLfloat upper = glm::mix((GLfloat)data[(y0 * imageWidth + x0) * 3 + c], (GLfloat)data[(y0 * imageWidth + x1) * 3 + c], fx);
+                    const GLfloat lower = glm::mix((GLfloat)data[(y1 * imageWidth + x0) * 3 + c], (GLfloat)data[(y1 * imageWidth + x1) * 3 + c], fx);
+                    face[((size_t)row * faceSize + column) * 3 + c] = (GLubyte)(glm::mix(upper, lower, fy) + 0.5f);
+                }
+            }
+        }
+        faceData = face.data();
+    }
+
+    glGenTextures(1, &textureHandle);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureHandle);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(GLint faceIndex = 0; faceIndex < 6; faceIndex++) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + faceIndex, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, faceData);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    fprintf(stdout, "[INFO]: %s (%dx%d) uploaded to every face of a %dx%d cube map with handle %d\n",
+            FILENAME, imageWidth, imageHeight, faceSize, faceSize, textureHandle);
+    stbi_image_free(data);
+
+    return textureHandle;
+}
+
 //*************************************************************************************
 //
 // Callbacks
@@ -1100,66 +1520,11 @@ void fp_scroll_callback(GLFWwindow *window, double xOffset, double yOffset) {
 
 
 void FPEngine::_setupSkybox() {
-    float vertices[] = {
-        // positions          // texture coords
-        -100.0f,  100.0f, -100.0f,   0.0f, 1.0f,   // back face
-        -100.0f, -100.0f, -100.0f,   0.0f, 0.0f,
-         100.0f, -100.0f, -100.0f,   1.0f, 0.0f,
-         100.0f, -100.0f, -100.0f,   1.0f, 0.0f,
-         100.0f,  100.0f, -100.0f,   1.0f, 1.0f,
-        -100.0f,  100.0f, -100.0f,   0.0f, 1.0f,
-
-        -100.0f, -100.0f,  100.0f,   0.0f, 0.0f,   // front face
-        -100.0f, -100.0f, -100.0f,   1.0f, 0.0f,
-        -100.0f,  100.0f, -100.0f,   1.0f, 1.0f,
-        -100.0f,  100.0f, -100.0f,   1.0f, 1.0f,
-        -100.0f,  100.0f,  100.0f,   0.0f, 1.0f,
-        -100.0f, -100.0f,  100.0f,   0.0f, 0.0f,
-
-         100.0f, -100.0f, -100.0f,   1.0f, 0.0f,   // right face
-         100.0f, -100.0f,  100.0f,   0.0f, 0.0f,
-         100.0f,  100.0f,  100.0f,   0.0f, 1.0f,
-         100.0f,  100.0f,  100.0f,   0.0f, 1.0f,
-         100.0f,  100.0f, -100.0f,   1.0f, 1.0f,
-         100.0f, -100.0f, -100.0f,   1.0f, 0.0f,
-
-        -100.0f, -100.0f,  100.0f,   0.0f, 0.0f,   // left face
-        -100.0f,  100.0f,  100.0f,   0.0f, 1.0f,
-         100.0f,  100.0f,  100.0f,   1.0f, 1.0f,
-         100.0f,  100.0f,  100.0f,   1.0f, 1.0f,
-         100.0f, -100.0f,  100.0f,   1.0f, 0.0f,
-        -100.0f, -100.0f,  100.0f,   0.0f, 0.0f,
-
-        -100.0f,  100.0f, -100.0f,   0.0f, 1.0f,   // top face
-         100.0f,  100.0f, -100.0f,   1.0f, 1.0f,
-         100.0f,  100.0f,  100.0f,   1.0f, 0.0f,
-         100.0f,  100.0f,  100.0f,   1.0f, 0.0f,
-        -100.0f,  100.0f,  100.0f,   0.0f, 0.0f,
-        -100.0f,  100.0f, -100.0f,   0.0f, 1.0f,
-
-        -100.0f, -100.0f, -100.0f,   0.0f, 0.0f,   // bottom face
-        -100.0f, -100.0f,  100.0f,   0.0f, 1.0f,
-         100.0f, -100.0f, -100.0f,   1.0f, 0.0f,
-         100.0f, -100.0f, -100.0f,   1.0f, 0.0f,
-        -100.0f, -100.0f,  100.0f,   0.0f, 1.0f,
-         100.0f, -100.0f,  100.0f,   1.0f, 1.0f
-    };
-
-    glGenVertexArrays(1, &_skyboxVAO);
-    glBindVertexArray(_skyboxVAO);
-
-    glGenBuffers(1, &_skyboxVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, _skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // the fullscreen triangle has no attributes, core profile still needs a VAO bound to draw
+    glGenVertexArrays(1, &_fullscreenVAO);
 
     _skyboxShader = new CSCI441::ShaderProgram("shaders/skybox.v.glsl", "shaders/skybox.f.glsl");
-    _skyboxUniformLocations.view = _skyboxShader->getUniformLocation("view");
-    _skyboxUniformLocations.projection = _skyboxShader->getUniformLocation("projection");
+    _skyboxUniformLocations.inverseViewProjection = _skyboxShader->getUniformLocation("inverseViewProjection");
     _skyboxUniformLocations.skyTexture = _skyboxShader->getUniformLocation("skyTexture");
 
     _skyboxShader->useProgram();
@@ -1167,80 +1532,342 @@ void FPEngine::_setupSkybox() {
 }
 
 void FPEngine::_renderSkybox(const glm::mat4& view, const glm::mat4& projection) const {
+    // drawn after the opaque scene at far depth, early depth testing skips every covered pixel
     glDepthFunc(GL_LEQUAL);
-    _skyboxShader->useProgram();
-    
-    glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
-    
-    _skyboxShader->setProgramUniform(_skyboxUniformLocations.view, skyboxView);
-    _skyboxShader->setProgramUniform(_skyboxUniformLocations.projection, projection);
-    
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::SKY]);
-    
-    glBindVertexArray(_skyboxVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    
+    glDepthMask(GL_FALSE);
+    GLStats::useProgram(_skyboxShader->getShaderProgramHandle());
+
+    // the sky stays around the camera, only the rotation of the view applies
+    const glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
+    GLStats::setProgramUniform(_skyboxShader, _skyboxUniformLocations.inverseViewProjection, glm::inverse(projection * skyboxView));
+
+    GLStats::activeTexture(GL_TEXTURE0);
+    GLStats::bindTexture(GL_TEXTURE_CUBE_MAP, _texHandles[TEXTURE_ID::SKY]);
+
+    GLStats::bindVertexArray(_fullscreenVAO);
+    GLStats::drawArrays(GL_TRIANGLES, 0, 3);
+
+    glDepthMask(GL_TRUE);
     glDepthFunc(GL_LESS);
 }
 
-bool FPEngine::_checkCollisions(const glm::vec2& newPosition) {
-    bool collided = CollisionDetector::checkCollision(
-        newPosition, 
-        _playerRadius
-    );
-    
-    if(collided) {
-            
-        // Print nearby objects for debugging
-        for(const auto& obj : CollisionDetector::getCollisionObjects()) {
-            float distance = glm::length(
-                glm::vec2(obj.position.x, obj.position.z) - newPosition
-            );
-            if(distance < 5.0f) { // Only show nearby objects
-            }
+void FPEngine::_renderStatsHud(GLfloat frameDelta, GLint framebufferWidth, GLint framebufferHeight) {
+    if(!_statsHud->isVisible()) return;
+
+    // the HUD shows the last finished frame, its own draw lands in the frame being counted
+    const GLStats::FrameCounters& stats = GLStats::getLastFrame();
+    char line[64];
+    std::vector<std::string>& lines = _statsHudLines;
+    lines.clear();
+    snprintf(line, sizeof(line), "frame     %6.2f ms", frameDelta * 1000.0f);
+    lines.emplace_back(line);
+    const FramePacer::FrameStats& pacing = _framePacer->getLastStats();
+    snprintf(line, sizeof(line), "jitter    %6.2f ms  %s", pacing.stdDevMs, FramePacer::getModeName(_framePacer->getMode()));
+    lines.emplace_back(line);
+    if(_qualityGovernor) {
+        snprintf(line, sizeof(line), "quality   %6d  scale %.2f", _qualityGovernor->getLevel(), _quality.renderScale);
+        lines.emplace_back(line);
+    }
+    snprintf(line, sizeof(line), "lights    %6u  per cell %u", _lightGrid->getNumLights(), _lightGrid->getMaxCellLights());
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "fragments %6.0fk %s", _fragmentCounter->getLastCount() / 1000.0, _options.depthPrepass ? "prepass" : "");
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "occluded  %6u/%u", _occlusionCuller ? _occlusionCuller->getNumHidden() : 0, _occlusionCuller ? _occlusionCuller->getNumQueried() : 0);
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "draws     %6u", stats.drawCalls);
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "triangles %6llu", stats.triangles);
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "uniforms  %6u", stats.uniformUploads);
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "programs  %6u  redundant %u", stats.programBinds, stats.redundantProgramBinds);
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "textures  %6u  redundant %u", stats.textureBinds, stats.redundantTextureBinds);
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "vaos      %6u  redundant %u", stats.vaoBinds, stats.redundantVaoBinds);
+    lines.emplace_back(line);
+    snprintf(line, sizeof(line), "uploads   %6.1f kb", stats.bufferBytes / 1024.0);
+    lines.emplace_back(line);
+
+    _statsHud->draw(lines, framebufferWidth, framebufferHeight);
+}
+
+//*************************************************************************************
+//
+// Headless Rendering
+
+void FPEngine::_setupHeadlessContext() {
+#ifdef GLFW_PLATFORM_NULL
+    // GLFW 3.4 can run without a display server at all
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+    fprintf(stdout, "[WARN]: GLFW has no null platform, headless mode still needs a display\n");
+#endif
+    if(!glfwInit()) {
+        fprintf(stderr, "[ERROR]: Could not initialize GLFW for headless rendering\n");
+        mErrorCode = OPENGL_ENGINE_ERROR_GLFW_INIT;
+        return;
+    }
+
+    // EGL surfaceless first, OSMesa covers machines without EGL, both work with llvmpipe
+    const int CONTEXT_APIS[] = { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API };
+    const char* CONTEXT_API_NAMES[] = { "EGL", "OSMesa" };
+    mpWindow = nullptr;
+    for(int i = 0; i < 2 && !mpWindow; i++) {
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, mOpenGLMajorVersion);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, mOpenGLMinorVersion);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, CONTEXT_APIS[i]);
+        mpWindow = glfwCreateWindow(mWindowWidth, mWindowHeight, mWindowTitle, nullptr, nullptr);
+        if(mpWindow) {
+            fprintf(stdout, "[INFO]: headless OpenGL context created through %s\n", CONTEXT_API_NAMES[i]);
         }
     }
-    
-    return collided;
-}
-
-glm::vec2 FPEngine::findBestMove(std::vector<std::vector<int>> world_matrix, glm::vec2 ghost_pos, glm::vec2 player_pos) {
-    // Get possible moves
-    std::vector<glm::vec2> possible_moves = getPossibleMoves(world_matrix, ghost_pos);
-    //fprintf(stdout, "looking for new move for ghost, play pos (%f,%f)\n",player_pos.x,player_pos.y);
-    // If no moves possible, stay in place
-    if (possible_moves.empty()) {
-        //fprintf(stdout,"no possible moves for ghost\n");
-        return ghost_pos;
-    }
-    glm::vec2 target;
-    float minimum = 1000000000;
-    for(glm::vec2 move : possible_moves){
-        float distance = glm::distance(move,player_pos);
-        if(distance<minimum){
-            minimum=distance;
-            target=move;
+    if(!mpWindow) {
+        fprintf(stderr, "[ERROR]: Could not create a headless OpenGL %d.%d context\n", mOpenGLMajorVersion, mOpenGLMinorVersion);
+        mErrorCode = OPENGL_ENGINE_ERROR_GLFW_WINDOW;
+        glfwTerminate();
+        return;
+    }
+
+    glfwMakeContextCurrent(mpWindow);
+    glfwSwapInterval(0);
+    glfwSetWindowUserPointer(mpWindow, this);
+    gladLoadGL(glfwGetProcAddress);
+    fprintf(stdout, "[INFO]: headless renderer: %s\n", (const char*)glGetString(GL_RENDERER));
+}
+
+void FPEngine::_finishHeadlessFrame(GLdouble frameStart) {
+    // without a swap nothing waits for the GPU, wait here so the frame time covers the draw
+    glFinish();
+    _headlessFrameTimes.push_back((glfwGetTime() - frameStart) * 1000.0);
+}
+
+void FPEngine::_reportHeadlessTimings() const {
+    if(_headlessFrameTimes.empty()) return;
+
+    GLdouble total = 0.0;
+    GLdouble fastest = _headlessFrameTimes.front();
+    GLdouble slowest = _headlessFrameTimes.front();
+    for(GLdouble frameMs : _headlessFrameTimes) {
+        total += frameMs;
+        fastest = std::min(fastest, frameMs);
+        slowest = std::max(slowest, frameMs);
+    }
+    const GLdouble mean = total / _headlessFrameTimes.size();
+    fprintf(stdout, "[INFO]: headless: %zu frames in %.3f s, mean %.3f ms (%.1f fps), min %.3f ms, max %.3f ms\n",
+            _headlessFrameTimes.size(), total / 1000.0, mean, 1000.0 / mean, fastest, slowest);
+}
+
+//*************************************************************************************
+//
+// Input Recording & Replay
+
+GLdouble FPEngine::_replayFrameStart(GLuint frameIndex) {
+    // the frame event leads every frame, what follows it was polled at the latch
+    InputEvent event;
+    while(_inputReplay->nextEvent(frameIndex, event)) {
+        _applyReplayEvent(event);
+        if(event.type == InputEvent::FRAME) break;
+    }
+    return _replayFrameTime;
+}
+
+void FPEngine::_applyReplayEvent(const InputEvent& event) {
+    switch(event.type) {
+        case InputEvent::FRAME:
+            _replayFrameTime = event.time;
+            break;
+        case InputEvent::KEY:
+            _applyKeyEvent(event.code, event.action);
+            break;
+        case InputEvent::MOUSE_BUTTON:
+            _applyMouseButtonEvent(event.code, event.action);
+            break;
+        case InputEvent::CURSOR:
+            _applyCursorEvent(glm::vec2(event.cursor[0], event.cursor[1]));
+            break;
+        case InputEvent::STATE_HASH:
+            _replayExpectedHash = event.hash;
+            _replayHashPending = true;
+            break;
+        default: break;
+    }
+}
+
+void FPEngine::_checkReplayState(GLuint frameIndex, const RenderSnapshot& snapshot) {
+    uint64_t hash = HASH_SEED;
+    hash = hashBytes(hash, &snapshot.tick, sizeof(snapshot.tick));
+    hash = hashBytes(hash, &snapshot.playerPosition, sizeof(snapshot.playerPosition));
+    hash = hashBytes(hash, &snapshot.respawns, sizeof(snapshot.respawns));
+    hash = hashBytes(hash, &snapshot.hitTimer, sizeof(snapshot.hitTimer));
+    hash = hashBytes(hash, snapshot.ghostPositions.data(), snapshot.ghostPositions.size() * sizeof(glm::vec2));
+    hash = hashBytes(hash, snapshot.carCollected.data(), snapshot.carCollected.size());
+    const size_t numPoints = snapshot.pointPositions.size();
+    hash = hashBytes(hash, &numPoints, sizeof(numPoints));
+    hash = hashBytes(hash, &_direction, sizeof(_direction));
+    hash = hashBytes(hash, &_phi, sizeof(_phi));
+
+    if(_inputRecorder) {
+        _inputRecorder->recordStateHash(frameIndex, hash);
+        return;
+    }
+    if(_replayHashPending && hash != _replayExpectedHash && _replayDivergedFrame < 0) {
+        fprintf(stderr, "[ERROR]: replay diverged from the recording at frame %u (tick %llu)\n", frameIndex, snapshot.tick);
+        _replayDivergedFrame = (GLint)frameIndex;
+    }
+    _replayHashPending = false;
+}
+
+//*************************************************************************************
+//
+// Input Latency
+
+void FPEngine::_noteInputArrival() {
+    // glfw hands events over without a timestamp, so the oldest event of a frame is timed
+    // from the moment it is delivered
+    if(_pendingInputTime < 0.0) {
+        _pendingInputTime = glfwGetTime();
+    }
+}
+
+void FPEngine::_recordInputLatency() {
+    if(_pendingInputTime < 0.0) return;
+    // the swap only queues the frame, wait until the GPU has actually finished it
+    glFinish();
+    _inputLatencies.push_back((glfwGetTime() - _pendingInputTime) * 1000.0);
+    _pendingInputTime = -1.0;
+}
+
+void FPEngine::_reportInputLatency() {
+    if(_inputLatencies.empty()) {
+        fprintf(stdout, "[INFO]: latency: no input arrived, nothing to report\n");
+        return;
+    }
+    std::sort(_inputLatencies.begin(), _inputLatencies.end());
+    GLdouble total = 0.0;
+    for(GLdouble latencyMs : _inputLatencies) total += latencyMs;
+    const size_t count = _inputLatencies.size();
+    fprintf(stdout, "[INFO]: latency: %zu frames with input, event to swap mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            count, total / count, _inputLatencies[count / 2], _inputLatencies[std::min(count - 1, count * 99 / 100)], _inputLatencies.back());
+}
+
+//*************************************************************************************
+//
+// Clustered Lighting
+
+void FPEngine::_buildLightGrid(const RenderSnapshot& snapshot, GLfloat alpha) {
+    FP_PROFILE_ZONE("light grid");
+    ScopedStageTimer timer(_cullTimeMs);
+
+    // the flashlight stays a uniform, it follows the player and lights everything in view
+    _lightGrid->clear();
+    for(const glm::vec2& point : snapshot.pointPositions) {
+        _lightGrid->addLight(glm::vec3(point.x, 1.0f, point.y), glm::vec3(1.5f, 0.5f, 0.1f), 2.5f);
+    }
+    for(size_t i = 0; i < snapshot.ghostPositions.size(); i++) {
+        const glm::vec2 ghostGridPos = glm::mix(snapshot.previousGhostPositions[i], snapshot.ghostPositions[i], alpha);
+        _lightGrid->addLight(glm::vec3(ghostGridPos.x*3, 1.0f, ghostGridPos.y*3), glm::vec3(0.6f, 0.9f, 2.0f), 6.0f);
+    }
+    for(size_t i = 0; i < _carData.size(); i++) {
+        if(snapshot.carCollected[i]) continue;
+        glm::vec3 headlights[Plane::NUM_HEADLIGHTS];
+        _carData[i].car->getHeadlightPositions(glm::translate(glm::mat4(1.0f), glm::vec3(_carData[i].position.x, 0.0f, _carData[i].position.y)), headlights);
+        for(const glm::vec3& headlight : headlights) {
+            _lightGrid->addLight(headlight, glm::vec3(2.0f, 1.8f, 0.8f), 4.0f);
         }
     }
-    return target;
+    _lightGrid->build(_quality.maxPointLights);
 }
 
-glm::mat4 FPEngine::_createBillboardMatrix(const glm::vec3& position, const glm::mat4& viewMatrix) const {
-    // Extract camera right and up vectors from view matrix
-    glm::vec3 right = glm::vec3(viewMatrix[0][0], viewMatrix[1][0], viewMatrix[2][0]);
-    glm::vec3 up = glm::vec3(0, 1, 0);
-    
-    // Scale for the billboard size - reduced from 2.0f to 1.0f
-    const float BILLBOARD_SIZE = 1.0f;
-    
-    // Create billboard model matrix
-    glm::mat4 billboardModel = glm::mat4(1.0f);
-    billboardModel[0] = glm::vec4(right * BILLBOARD_SIZE, 0.0f);
-    billboardModel[1] = glm::vec4(up * BILLBOARD_SIZE, 0.0f);
-    billboardModel[2] = glm::vec4(glm::cross(right, up) * BILLBOARD_SIZE, 0.0f);
-    billboardModel[3] = glm::vec4(position, 1.0f);
-    
-    return billboardModel;
+//*************************************************************************************
+//
+// Baked Lighting
+
+void FPEngine::_setupLightmap(const LightmapSettings& settings) {
+    LightmapBaker baker(world_matrix, settings);
+    if(!baker.loadOrBake(*_jobSystem, _options.lightmapCacheDirectory)) return;
+
+    glGenTextures(1, &_lightmapTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, _lightmapTexture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, baker.getWidth(), baker.getHeight(), LightmapBaker::NUM_LAYERS,
+                 0, GL_RGB, GL_UNSIGNED_BYTE, baker.getTexels().data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    const GLuint shaderProgramHandle = _shaderProgram->getShaderProgramHandle();
+    glProgramUniform1f(shaderProgramHandle, _shaderProgram->getUniformLocation("lightmapScale"), baker.getScale());
+    glProgramUniform1f(shaderProgramHandle, _shaderProgram->getUniformLocation("lightmapCellSize"), LightmapBaker::CELL_SIZE);
+    glProgramUniform2i(shaderProgramHandle, _shaderProgram->getUniformLocation("lightmapCells"), baker.getNumCellsX(), baker.getNumCellsZ());
 }
 
+//*************************************************************************************
+//
+// Adaptive Quality
+
+void FPEngine::_bindFinalTarget() const {
+    if(_offscreenTarget) {
+        _offscreenTarget->bind();
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDrawBuffer(GL_BACK);
+        glReadBuffer(GL_BACK);
+    }
+}
+
+//*************************************************************************************
+//
+// Hit Glitch
+
+void FPEngine::_renderHitGlitch(GLuint sceneColor, GLfloat hitTimer) {
+    // every pixel is replaced, the scene's depth plays no part
+    glDisable(GL_DEPTH_TEST);
+    GLStats::useProgram(_glitchShaderProgram->getShaderProgramHandle());
+    // the glitch animation was authored against a counter running down 60 steps per second
+    GLStats::setProgramUniform(_glitchShaderProgram, _glitchUniformLocations.time, hitTimer * 60.0f);
+    GLStats::setProgramUniform(_glitchShaderProgram, _glitchUniformLocations.strength, _options.hitGlitchStrength);
+
+    GLStats::activeTexture(GL_TEXTURE0);
+    GLStats::bindTexture(GL_TEXTURE_2D, sceneColor);
+    GLStats::bindVertexArray(_fullscreenVAO);
+    GLStats::drawArrays(GL_TRIANGLES, 0, 3);
+    glEnable(GL_DEPTH_TEST);
+}
+
+//*************************************************************************************
+//
+// Frame Capture
+
+void FPEngine::_captureFrame(GLuint frameIndex, GLint width, GLint height) {
+    if(_frameCapture) _frameCapture->collect();
+
+    const bool sequenceDue = _captureSequence && frameIndex % _options.frameDumpInterval == 0;
+    if(!sequenceDue && !_screenshotRequested) return;
+
+    FP_PROFILE_ZONE("capture");
+    if(!_frameCapture) {
+        _frameCapture = new FrameCapture(_options.frameDumpFormat);
+    }
+    _bindFinalTarget();
+
+    char filename[512];
+    if(sequenceDue) {
+        const char* prefix = _options.frameDumpPrefix.empty() ? DEFAULT_CAPTURE_PREFIX : _options.frameDumpPrefix.c_str();
+        snprintf(filename, sizeof(filename), "%s%05u%s", prefix, frameIndex, _frameCapture->getExtension());
+        _frameCapture->capture(width, height, filename);
+    }
+    if(_screenshotRequested) {
+        snprintf(filename, sizeof(filename), "screenshot_%03u%s", _numScreenshots++, _frameCapture->getExtension());
+        _frameCapture->capture(width, height, filename);
+        fprintf(stdout, "[INFO]: screenshot queued to \"%s\"\n", filename);
+        _screenshotRequested = false;
+    }
+}
@@ -5,19 +5,110 @@
 #include <CSCI441/ModelLoader.hpp>
 #include <CSCI441/OpenGLEngine.hpp>
 #include <CSCI441/ShaderProgram.hpp>
-#include "CollisionDetector.h"
-#include "ParticleSystem.h"
+#include "FlythroughBenchmark.h"
+#include "FragmentCounter.h"
+#include "FrameCapture.h"
+#include "FramePacer.h"
+#include "GpuFrameTimer.h"
+#include "GpuProfiler.h"
+#include "InputRecording.h"
+#include "JobSystem.h"
+#include "LightGrid.h"
+#include "LightmapBaker.h"
+#include "MazeGenerator.h"
+#include "OcclusionCuller.h"
+#include "OffscreenTarget.h"
+#include "PackedVertex.h"
 #include "Plane.h"
-
+#include "QualityGovernor.h"
+#include "RenderGraph.h"
+#include "Simulation.h"
+#include "SnapshotBuffer.h"
+#include "StatsHud.h"
+#include "StreamBuffer.h"
+#include "GLStats.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/// \desc runtime options of the engine, filled in from the command line by main()
+struct EngineOptions {
+    /// \desc simulation ticks per second, independent of the frame rate
+    GLdouble simulationTickRate = 60.0;
+    /// \desc tick the simulation on its own thread, otherwise run() ticks it between frames
+    bool threadedSimulation = true;
+    /// \desc csv or binary world to load when no maze is generated
+    std::string worldFile = "world.csv";
+    /// \desc generate a maze from mazeOptions instead of loading worldFile
+    bool generateMaze = false;
+    /// \desc size, seed and contents of the generated maze
+    MazeOptions mazeOptions;
+    /// \desc profiler trace written at exit, .csv for CSV and Chrome trace JSON otherwise.
+    /// nothing is written at exit when empty
+    std::string profileOutput;
+    /// \desc start with the draw statistics overlay shown, H toggles it at runtime
+    bool showStatsHud = false;
+    /// \desc bake the static ambient and directional light of the maze into a lightmap, the
+    /// floor and walls are lit per fragment every frame otherwise
+    bool bakeLightmap = true;
+    /// \desc directory baked lightmaps are cached in, the working directory when empty
+    std::string lightmapCacheDirectory;
+    /// \desc lay down the depth of the opaque maze with a trivial shader first, so the
+    /// lighting shader only runs on the fragments that end up visible
+    bool depthPrepass = false;
+    /// \desc skip the draws of ghosts and cars hidden behind the walls with occlusion queries
+    bool occlusionCulling = true;
+    /// \desc strength of the full screen glitch while the player is hit, 0 turns it off
+    GLfloat hitGlitchStrength = 1.0f;
+    /// \desc draw into an offscreen framebuffer without a window or display, the context is
+    /// created through EGL or OSMesa.  runs headlessFrames frames on a fixed clock and exits
+    bool headless = false;
+    /// \desc number of frames drawn in headless mode
+    GLuint headlessFrames = 600;
+    /// \desc frames are captured to <frameDumpPrefix><frame>.png or .rgba from the start when
+    /// not empty.  F11 toggles the capture at runtime, F12 captures a single screenshot
+    std::string frameDumpPrefix;
+    /// \desc number of frames between two dumped frames
+    GLuint frameDumpInterval = 1;
+    /// \desc file format of captured frames, raw keeps up with every frame where PNG may not
+    FrameCapture::Format frameDumpFormat = FrameCapture::PNG;
+    /// \desc fly the camera along a scripted path through the maze with vsync off, report
+    /// frame and GPU times per path segment and exit
+    bool flythrough = false;
+    /// \desc frames the flythrough camera spends moving from one cell to the next
+    GLuint flythroughFramesPerCell = 30;
+    /// \desc input events, frame times and the RNG seed are recorded to this log when not empty.
+    /// the simulation ticks on the GL thread while recording so the replay sees the same ticks
+    std::string recordInputFile;
+    /// \desc input log to replay instead of reading the keyboard and mouse, runs at max speed
+    /// and exits at the end of the log.  combine with headless to replay without a window
+    std::string replayInputFile;
+    /// \desc time every frame that consumed input from the first event delivered to the
+    /// finished swap and report the distribution at exit
+    bool measureLatency = false;
+    /// \desc how frames are paced.  headless, flythrough and replay runs draw uncapped
+    /// unless a cap is asked for
+    FramePacer::Mode frameMode = FramePacer::VSYNC;
+    /// \desc frames per second in FramePacer::CAP mode
+    GLdouble frameRateCap = 60.0;
+    /// \desc frames per second the quality governor lowers render cost to hold, 0 always
+    /// draws at full quality
+    GLdouble adaptiveQualityTarget = 0.0;
+};
 
 class FPEngine final : public CSCI441::OpenGLEngine {
 public:
     //***************************************************************************
     // Engine Interface
-    FPEngine();
+
+    explicit FPEngine(const EngineOptions& options = EngineOptions());
 
     void run() final;
 
+    /// \desc GL call counters of the last finished frame
+    static const GLStats::FrameCounters& getFrameStats() { return GLStats::getLastFrame(); }
+
     //***************************************************************************
     // Event Handlers
 
@@ -65,9 +156,299 @@ private:
     /// \desc draws everything to the scene from a particular point of view
     /// \param viewMtx the current view matrix for our camera
     /// \param projMtx the current projection matrix for our camera
-    void _renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const;
-    /// \desc handles moving our FreeCam as determined by keyboard input
-    void _updateScene();
+    /// \param snapshot simulation state to draw
+    /// \param alpha blend factor between the previous and the current tick of the snapshot
+    /// \param depthPrepassed true if _renderDepthPrepass already filled the depth of the maze
+    void _renderScene(glm::mat4 viewMtx, glm::mat4 projMtx, const RenderSnapshot& snapshot, GLfloat alpha, bool depthPrepassed) const;
+    /// \desc draws the explosion particles as small blended spheres, farthest first
+    void _renderParticles(const std::vector<Particle>& particles, const glm::mat4& viewMtx, const glm::mat4& projMtx);
+    /// \desc indices of the particles drawn this frame, back to front
+    std::vector<GLuint> _particleOrder;
+    /// \desc view space depth of each particle, the sort key of _particleOrder
+    std::vector<GLfloat> _particleDepths;
+    /// \desc frustum culls the scene and precomputes the MVP matrix of everything visible
+    /// \param viewMtx the current view matrix for our camera
+    /// \param projMtx the current projection matrix for our camera
+    /// \param snapshot simulation state to cull
+    void _cullScene(const glm::mat4& viewMtx, const glm::mat4& projMtx, const RenderSnapshot& snapshot);
+
+    //***************************************************************************
+    // Depth Prepass
+
+    /// \desc writes depth only, used by the prepass
+    CSCI441::ShaderProgram* _depthShaderProgram;
+    GLint _depthMvpMatrixLocation;
+    GLint _depthPositionScaleLocation;
+    GLint _depthPositionOffsetLocation;
+    /// \desc counts the fragments the scene pass shades
+    FragmentCounter* _fragmentCounter;
+    /// \desc fragments shaded by the scene pass since the last stage report
+    GLdouble _shadedFragments;
+
+    //***************************************************************************
+    // Occlusion Culling
+
+    /// \desc tests the ghosts and cars against the maze's depth, null if turned off
+    OcclusionCuller* _occlusionCuller;
+    /// \desc half the side of the box around a ghost billboard
+    static constexpr GLfloat GHOST_HALF_SIZE = 2.5f;
+    /// \desc distance from an occlusion box within which the camera may clip it
+    static constexpr GLfloat OCCLUSION_CAMERA_MARGIN = 0.05f;
+    /// \desc issues an occlusion query for a box around every ghost and car, the ghosts first
+    /// \param alpha blend factor between the previous and the current tick of the snapshot
+    void _queryDynamicOcclusion(const glm::mat4& viewMtx, const glm::mat4& projMtx, const RenderSnapshot& snapshot, GLfloat alpha) const;
+    /// \desc OcclusionCuller object index of a car, the ghosts come first
+    static GLuint _carOcclusionIndex(size_t car, const RenderSnapshot& snapshot) { return (GLuint)(snapshot.ghostPositions.size() + car); }
+
+    /// \desc draws the depth of the walls, floor and pellets with color writes off
+    /// \param viewMtx the current view matrix for our camera
+    /// \param projMtx the current projection matrix for our camera
+    void _renderDepthPrepass(const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
+
+    //***************************************************************************
+    // Simulation Thread
+
+    /// \desc game logic, only touched by the simulation thread once run() starts it
+    Simulation* _simulation;
+    /// \desc snapshots published by the simulation thread and drawn by the GL thread
+    SnapshotBuffer<RenderSnapshot> _snapshots;
+    /// \desc thread ticking _simulation
+    std::thread _simulationThread;
+    /// \desc cleared to stop the simulation thread
+    std::atomic<bool> _simulationRunning;
+    /// \desc respawn count of the last snapshot drawn, used to reset the camera on respawn
+    GLuint _lastRespawns;
+    /// \desc options the engine was created with
+    EngineOptions _options;
+    /// \desc length of one simulation tick in seconds
+    GLdouble _tickSeconds;
+    /// \desc real time not yet consumed by simulation ticks
+    GLdouble _simulationAccumulator;
+    /// \desc time _stepSimulation() was last called at
+    GLdouble _lastSimulationTime;
+    /// \desc longest stretch of real time simulated in one step, stops a stall from snowballing
+    static constexpr GLdouble MAX_SIMULATION_STEP = 0.25;
+
+    /// \desc feeds the real time passed since the last call into the fixed timestep accumulator,
+    /// runs as many whole ticks as it covers and publishes a snapshot if any tick ran
+    /// \param now current time in seconds
+    void _stepSimulation(GLdouble now);
+    /// \desc ticks the simulation on the simulation thread until _simulationRunning is cleared
+    void _simulationLoop();
+    /// \desc blend factor between the previous and the current tick of a snapshot at a given time
+    static GLfloat _interpolationAlpha(const RenderSnapshot& snapshot, GLdouble now);
+    /// \desc headless and flythrough runs advance a fixed step of virtual time every frame
+    /// instead of following the wall clock, and tick the simulation between frames, so
+    /// every run draws the same frames
+    bool _fixedClock;
+    /// \desc virtual time between two frames on the fixed clock
+    static constexpr GLdouble FIXED_FRAME_SECONDS = 1.0 / 60.0;
+
+    /// \desc bit flags for the movement keys handed to the simulation thread
+    enum INPUT_BUTTON {
+        INPUT_FORWARD = 1 << 0,
+        INPUT_BACKWARD = 1 << 1,
+        INPUT_LEFT = 1 << 2,
+        INPUT_RIGHT = 1 << 3
+    };
+    /// \desc movement keys held on the GL thread, read by the simulation thread
+    std::atomic<GLuint> _inputButtons;
+    /// \desc camera heading on the GL thread, read by the simulation thread
+    std::atomic<GLfloat> _inputDirection;
+    /// \desc hands the current keyboard state and heading to the simulation thread
+    void _publishInput();
+    /// \desc polls window events, or applies the replayed ones, and publishes the result.
+    /// called once per frame right before the camera is built, so mouse look reaches the
+    /// screen with only the draw and swap of one frame in between
+    void _latchInput(GLuint frameIndex);
+
+    //***************************************************************************
+    // Parallel Work
+
+    /// \desc thread pool the simulation and render preparation stages fan out to
+    JobSystem* _jobSystem;
+    /// \desc objects handed to a single job when culling
+    static constexpr size_t CULL_GRAIN_SIZE = 512;
+
+    /// \desc milliseconds spent culling since the last report
+    double _cullTimeMs;
+    /// \desc number of frames accumulated in _cullTimeMs
+    GLuint _stageFrames;
+    /// \desc number of frames between two stage timing reports
+    static constexpr GLuint STAGE_REPORT_INTERVAL = 300;
+    /// \desc prints the average time of the render preparation stages and resets the accumulators
+    void _reportStageTimings();
+
+    //***************************************************************************
+    // Profiling
+
+    /// \desc times the GPU passes, compiled down to nothing without FP_ENABLE_PROFILER
+    GpuProfiler* _gpuProfiler;
+    /// \desc trace written when pressing P and no profileOutput was given
+    static constexpr const char* DEFAULT_PROFILE_OUTPUT = "profile.json";
+
+    /// \desc overlay showing the GL call counters of the last frame
+    StatsHud* _statsHud;
+    /// \desc text of the overlay, kept to reuse the allocations
+    std::vector<std::string> _statsHudLines;
+    /// \desc formats the counters of the last frame and draws them with _statsHud if it is visible
+    void _renderStatsHud(GLfloat frameDelta, GLint framebufferWidth, GLint framebufferHeight);
+
+    //***************************************************************************
+    // Headless Rendering
+
+    /// \desc framebuffer drawn into in headless mode, null when drawing to the window
+    OffscreenTarget* _offscreenTarget;
+    /// \desc wall time of every headless frame in milliseconds
+    std::vector<GLdouble> _headlessFrameTimes;
+
+    /// \desc initializes GLFW without a display and creates an invisible window whose
+    /// context comes from EGL, falling back to OSMesa
+    void _setupHeadlessContext();
+    /// \desc waits for a headless frame to finish and records its time
+    /// \param frameStart wall time the frame started at
+    void _finishHeadlessFrame(GLdouble frameStart);
+    /// \desc prints the frame time statistics of the headless run
+    void _reportHeadlessTimings() const;
+
+    //***************************************************************************
+    // Frame Capture
+
+    /// \desc reads frames back asynchronously and writes them on its own thread, created on
+    /// the first capture
+    FrameCapture* _frameCapture;
+    /// \desc true while every frameDumpInterval-th frame is captured
+    bool _captureSequence;
+    /// \desc set by F12, the next finished frame is captured as a screenshot
+    bool _screenshotRequested;
+    /// \desc number of screenshots taken, numbers the next one
+    GLuint _numScreenshots;
+    /// \desc prefix of the sequence captured after F11 when no frameDumpPrefix was given
+    static constexpr const char* DEFAULT_CAPTURE_PREFIX = "capture_";
+
+    /// \desc hands finished read backs to the encoder and queues the final framebuffer of
+    /// this frame if it is due for capture
+    void _captureFrame(GLuint frameIndex, GLint width, GLint height);
+
+    //***************************************************************************
+    // Flythrough Benchmark
+
+    /// \desc drives the camera and collects frame times in flythrough mode, null otherwise
+    FlythroughBenchmark* _flythrough;
+    /// \desc cell the flythrough path starts on, the cell the player spawns on
+    static constexpr GLint FLYTHROUGH_START_CELL = 1;
+
+    //***************************************************************************
+    // Input Recording & Replay
+
+    /// \desc writes the input log, null unless recording
+    InputRecorder* _inputRecorder;
+    /// \desc feeds the events of the input log, null unless replaying
+    InputReplay* _inputReplay;
+    /// \desc frame the input events polled now take effect in
+    GLuint _inputFrame;
+    /// \desc simulation state hash the recording saw in the current frame
+    uint64_t _replayExpectedHash;
+    /// \desc true if the current frame of the replay has a hash to check
+    bool _replayHashPending;
+    /// \desc first frame whose state did not match the recording, -1 while the replay matches
+    GLint _replayDivergedFrame;
+
+    /// \desc clock value of the frame being replayed
+    GLdouble _replayFrameTime;
+
+    /// \desc applies the replayed events of a frame up to its frame event
+    /// \param frameIndex frame being replayed
+    /// \returns the clock value the frame was recorded at
+    GLdouble _replayFrameStart(GLuint frameIndex);
+    /// \desc applies one replayed event
+    void _applyReplayEvent(const InputEvent& event);
+    /// \desc records or checks the hash of the drawn simulation state and camera
+    void _checkReplayState(GLuint frameIndex, const RenderSnapshot& snapshot);
+
+    /// \desc key handling shared by live and replayed input
+    void _applyKeyEvent(GLint key, GLint action);
+    /// \desc mouse button handling shared by live and replayed input
+    void _applyMouseButtonEvent(GLint button, GLint action);
+    /// \desc mouse look shared by live and replayed input
+    void _applyCursorEvent(glm::vec2 currMousePosition);
+
+    //***************************************************************************
+    // Frame Pacing
+
+    /// \desc waits for the start of every frame and tracks frame time variance
+    FramePacer* _framePacer;
+
+    //***************************************************************************
+    // Clustered Lighting
+
+    /// \desc pellet, ghost and headlight point lights binned over the maze
+    LightGrid* _lightGrid;
+    /// \desc first of the three texture units the light grid is bound to, unit 0 holds the
+    /// texture map
+    static constexpr GLuint LIGHT_GRID_FIRST_UNIT = 1;
+
+    /// \desc gathers the point lights of a frame and bins them into the light grid
+    /// \param snapshot simulation state to light
+    /// \param alpha blend factor between the previous and the current tick of the snapshot
+    void _buildLightGrid(const RenderSnapshot& snapshot, GLfloat alpha);
+
+    //***************************************************************************
+    // Baked Lighting
+
+    /// \desc texture array holding the lightmap layers, 0 if the maze is lit live
+    GLuint _lightmapTexture;
+    /// \desc texture unit the lightmap is bound to, after the light grid's
+    static constexpr GLuint LIGHTMAP_UNIT = LIGHT_GRID_FIRST_UNIT + 3;
+
+    /// \desc bakes or loads the lightmap of the maze and uploads it
+    /// \param settings static light the shader would otherwise apply live
+    void _setupLightmap(const LightmapSettings& settings);
+
+    //***************************************************************************
+    // Adaptive Quality
+
+    /// \desc lowers render cost when frames run over budget, null unless enabled
+    QualityGovernor* _qualityGovernor;
+    /// \desc GPU time of whole frames for the governor, null unless it is enabled
+    GpuFrameTimer* _gpuFrameTimer;
+    /// \desc knobs the current frame is drawn with
+    QualitySettings _quality;
+
+    /// \desc binds the framebuffer the frame ends up in, the offscreen target when headless
+    /// and the back buffer otherwise
+    void _bindFinalTarget() const;
+
+    //***************************************************************************
+    // Render Graph
+
+    /// \desc runs the passes of a frame, owns the scaled scene and glitch targets
+    RenderGraph* _renderGraph;
+    /// \desc passes declared and culled since the last stage report
+    GLdouble _graphPasses;
+    GLdouble _graphCulled;
+    /// \desc declares this frame's passes, from the depth prepass to the capture
+    /// \param width width of the final framebuffer
+    /// \param height height of the final framebuffer
+    /// \param sceneWidth width the scene is drawn at, below width when scaled
+    /// \param sceneHeight height the scene is drawn at, below height when scaled
+    void _buildRenderGraph(const glm::mat4& viewMtx, const glm::mat4& projMtx, const RenderSnapshot& snapshot, GLfloat alpha,
+                           GLfloat frameDelta, GLuint frameIndex, GLint width, GLint height, GLint sceneWidth, GLint sceneHeight);
+
+    //***************************************************************************
+    // Input Latency
+
+    /// \desc delivery time of the oldest input event not yet on screen, negative if none
+    GLdouble _pendingInputTime;
+    /// \desc event to swap time of every frame that consumed input in milliseconds
+    std::vector<GLdouble> _inputLatencies;
+
+    /// \desc remembers when the first event of a frame was delivered
+    void _noteInputArrival();
+    /// \desc waits for the swapped frame to finish and records its input latency
+    void _recordInputLatency();
+    /// \desc prints the mean and percentiles of the recorded input latencies
+    void _reportInputLatency();
 
     //***************************************************************************
     // Input Tracking (Keyboard & Mouse)
@@ -91,33 +472,24 @@ private:
 
     GLfloat _direction;
     GLfloat _phi;
-    glm::vec2 _pos;
-
-    float _hitTimer;
-
-    //0: normal
-    //1: collided moving x
-    //2: collided moving z
-    GLfloat _lastDir;
 
     GLfloat WORLD_SIZE_X = 15.0f;
     GLfloat WORLD_SIZE_Y = 15.0f;
 
-    int NUM_LIVES = 5;
-    float GHOST_SPEED = 0.0125;
-
     std::vector<std::vector<int>> world_matrix;
     //***************************************************************************
     // VAO & Object Information
 
     /// \desc total number of VAOs in our scene
-    static constexpr GLuint NUM_VAOS = 2;
+    static constexpr GLuint NUM_VAOS = 3;
     /// \desc used to index through our VAO/VBO/IBO array to give named access
     enum VAO_ID {
         /// \desc the platform that represents our ground for everything to appear on
         PLATFORM = 0,
         /// \desc the quad that we'll create to apply a texture to
-        QUAD = 1
+        QUAD = 1,
+        /// \desc low detail sphere the particles are instanced from
+        PARTICLE = 2
     };
     /// \desc VAO for our objects
     GLuint _vaos[NUM_VAOS];
@@ -127,20 +499,64 @@ private:
     GLuint _ibos[NUM_VAOS];
     /// \desc the number of points that make up our VAO
     GLsizei _numVAOPoints[NUM_VAOS];
+    /// \desc box the packed positions of each VAO are quantized in
+    PackedBounds _vaoBounds[NUM_VAOS];
 
     /// \desc creates the platform object
     /// \param [in] vao VAO descriptor to bind
     /// \param [in] vbo VBO descriptor to bind
     /// \param [in] ibo IBO descriptor to bind
     /// \param [out] numVAOPoints sets the number of vertices that make up the IBO array
-    void _createPlatform(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints) const;
+    /// \param [out] bounds box the packed vertex positions are quantized in
+    void _createPlatform(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints, PackedBounds &bounds) const;
 
     /// \desc creates the textured quad object
     /// \param [in] vao VAO descriptor to bind
     /// \param [in] vbo VBO descriptor to bind
     /// \param [in] ibo IBO descriptor to bind
     /// \param [out] numVAOPoints sets the number of vertices that make up the IBO array
-    void _createQuad(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints) const;
+    /// \param [out] bounds box the packed vertex positions are quantized in
+    void _createQuad(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints, PackedBounds &bounds) const;
+
+    /// \desc creates the particle sphere, its instance attributes are pointed at the stream
+    /// buffer every frame
+    /// \param [in] vao VAO descriptor to bind
+    /// \param [in] vbo VBO descriptor to bind
+    /// \param [in] ibo IBO descriptor to bind
+    /// \param [out] numVAOPoints sets the number of vertices that make up the IBO array
+    /// \param [out] bounds box the packed vertex positions are quantized in
+    void _createParticleSphere(GLuint vao, GLuint vbo, GLuint ibo, GLsizei &numVAOPoints, PackedBounds &bounds) const;
+
+    /// \desc ring of per-frame regions the instance data of dynamic objects is written to
+    StreamBuffer* _streamBuffer;
+    /// \desc bytes of the stream buffer one frame may use
+    static constexpr GLsizeiptr STREAM_REGION_SIZE = 64 * 1024;
+    /// \desc instance attributes of one particle, as the scene vertex shader reads them
+    struct ParticleInstance {
+        /// \desc world position and scale
+        glm::vec4 centerSize;
+        /// \desc color and opacity
+        glm::vec4 color;
+    };
+    /// \desc ring the per-frame uniform block of the scene shader is written to
+    StreamBuffer* _uniformStreamBuffer;
+    /// \desc bytes of the uniform ring one frame may use, rounded up to the block alignment
+    static constexpr GLsizeiptr UNIFORM_REGION_SIZE = 4 * 1024;
+    /// \desc uniform block binding point of FrameUniforms
+    static constexpr GLuint FRAME_UNIFORM_BINDING = 0;
+    /// \desc the FrameUniforms block of the scene shader in std140 layout, every vec3 is
+    /// padded to a vec4
+    struct FrameUniforms {
+        glm::vec4 pointLightPosition;
+        glm::vec4 pointLightColor;
+        glm::vec4 viewVector;
+    };
+    /// \desc writes this frame's FrameUniforms to the uniform ring and binds them
+    void _streamFrameUniforms(const RenderSnapshot& snapshot, const glm::vec3& viewVector);
+
+    /// \desc sets the uniforms mapping packed positions back to mesh space, pass default
+    /// bounds before drawing the float vertices of the CSCI441 objects again
+    static void _setPositionUnpacking(const CSCI441::ShaderProgram* shader, GLint scaleLocation, GLint offsetLocation, const PackedBounds& bounds);
 
     /// \desc tracks which object we want to be viewing
     GLuint _objectIndex;
@@ -164,33 +580,28 @@ private:
     /// \desc information list of all the buildings to draw
     std::vector<BuildingData> _buildings;
 
-    struct PointsData{
-        glm::mat4 modelMatrix;
-
-        glm::vec3 color;
-        glm::vec2 position;
-
-        bool toBeDeleted;
-    };
-
-    std::vector<PointsData> _points;
-
-    struct Ghost{
-        glm::mat4 modelMatrix;
-        glm::vec3 color;
-        glm::vec2 current_pos;     // Current interpolated position
-        glm::vec2 target_pos;      // Next target point
-        glm::vec2 start_pos;
-        glm::vec2 spawn_pos;
-        float movement_speed;      // Units per second
-        float progress;            // Movement progress [0, 1]
-        bool is_moving;
+    /// \desc draw list entry produced by the culling stage
+    struct DrawItem {
+        /// \desc precomputed MVP matrix for this frame
+        glm::mat4 mvpMatrix;
+        /// \desc false if the object lies outside the view frustum
+        bool visible;
+        /// \desc squared distance from the camera, orders the draws front to back
+        GLfloat distance;
     };
-
-    std::vector<Ghost> _ghosts;
-
-    void _renderFPV(glm::mat4 projMtx) const;
-    void generate_points();
+    /// \desc draw list for _buildings, index aligned
+    std::vector<DrawItem> _buildingDrawList;
+    /// \desc draw list for the pellets of the snapshot being drawn, index aligned
+    std::vector<DrawItem> _pointDrawList;
+    /// \desc indices of the visible buildings, nearest first
+    std::vector<GLuint> _buildingOrder;
+    /// \desc indices of the visible pellets, nearest first
+    std::vector<GLuint> _pointOrder;
+    /// \desc collects the visible items of a draw list nearest first, so the depth test
+    /// rejects the fragments of what lies behind them before they are shaded
+    static void _sortFrontToBack(const std::vector<DrawItem>& drawList, std::vector<GLuint>& order);
+
+    void _renderFPV(glm::mat4 projMtx, const RenderSnapshot& snapshot) const;
 
     //***************************************************************************
     // Texture Information
@@ -212,6 +623,9 @@ private:
     /// \note sets the texture parameters and sends the data to the GPU
     /// \param FILENAME external image filename to load
     static GLuint _loadAndRegisterTexture(const char* FILENAME);
+    /// \desc loads an image onto all six faces of a cube map, squeezed square if it is not
+    /// \param FILENAME external image filename to load
+    static GLuint _loadSkyCubeMap(const char* FILENAME);
 
 
             /// \desc generates building information to make up our scene
@@ -221,23 +635,28 @@ private:
 
     /// \desc shader program that performs texturing
     CSCI441::ShaderProgram* _shaderProgram;
-    CSCI441::ShaderProgram* _slenderShaderProgram;
     /// \desc stores the locations of all of our shader uniforms
     struct TextureShaderUniformLocations {
         /// \desc precomputed MVP matrix location
         GLint mvpMatrix;
-        GLint time;
+        /// \desc model matrix location, places fragments in the light grid
+        GLint modelMatrix;
+        /// \desc scale and offset unpacking quantized positions, see PackedBounds
+        GLint positionScale;
+        GLint positionOffset;
+        /// \desc non-zero while drawing the static maze, which samples the lightmap
+        GLint useLightmap;
+        /// \desc non-zero for the alpha tested pass, which discards transparent texels
+        GLint alphaTest;
+        /// \desc non-zero while drawing the instanced particles
+        GLint instanced;
         GLint textureMap;
         GLint lightDirection;
         GLint directionalLightColor;
         GLint materialColor;
         GLint normalMatrix;
-        GLint viewVector;
-        GLint pointLightPosition;
-        GLint pointLightColor;
 
     } _shaderUniformLocations;
-    TextureShaderUniformLocations _slenderShaderUniformLocations;
     /// \desc stores the locations of all of our shader attributes
     struct TextureShaderAttributeLocations {
         /// \desc vertex position location
@@ -246,54 +665,49 @@ private:
         /// \note not used in this lab
         GLint normalVec;
         GLint inTexCoord;
+        /// \desc per instance attributes of the particles
+        GLint instanceCenterSize;
+        GLint instanceColor;
 
     } _shaderAttributeLocations;
-    TextureShaderAttributeLocations _slenderShaderAttributeLocations;
 
-    GLuint _skyboxVAO, _skyboxVBO;
+    //***************************************************************************
+    // Hit Glitch
+
+    /// \desc distorts the finished scene in one full screen pass while the player is hit
+    CSCI441::ShaderProgram* _glitchShaderProgram;
+    struct GlitchShaderUniformLocations {
+        GLint sceneColor;
+        /// \desc EngineOptions::hitGlitchStrength
+        GLint strength;
+        GLint time;
+    } _glitchUniformLocations;
+    /// \desc draws the glitched scene into the bound scene target
+    /// \param sceneColor texture the scene was drawn into
+    /// \param hitTimer seconds left of the hit, drives the animation
+    void _renderHitGlitch(GLuint sceneColor, GLfloat hitTimer);
+
+    /// \desc empty VAO the fullscreen triangles of the sky and the glitch are drawn with
+    GLuint _fullscreenVAO;
     CSCI441::ShaderProgram* _skyboxShader;
     void _setupSkybox();
+    /// \desc fills every pixel the scene left at far depth with the sky cube map, must come
+    /// after the opaque draws
     void _renderSkybox(const glm::mat4& view, const glm::mat4& projection) const;
 
     struct SkyboxShaderUniformLocations {
-        GLint view;
-        GLint projection;
+        GLint inverseViewProjection;
         GLint skyTexture;
     } _skyboxUniformLocations;
 
     GLuint _skyTexture;
 
-    float _playerRadius = 2.0f;
-    glm::vec2 _lastValidPosition;
-
-    bool _checkCollisions(const glm::vec2& newPosition);
-
-    bool _isFalling = false;
-    float _fallTime = 0.0f;
-    const float MAX_FALL_TIME = 3.0f;
-    const float FALL_SPEED = 15.0f;
-    glm::vec3 _spawnPosition = glm::vec3(3.0f, 0.5f, 3.0f);
-    float _currentHeight = 0.5f;
-
-
-    ParticleSystem* _particleSystem;
-    bool _isExploding = false;
-
-    glm::vec2 findBestMove(std::vector<std::vector<int>> vector1, glm::vec2 vec1, glm::vec2 vec2);
-
-    glm::mat4 _createBillboardMatrix(const glm::vec3& position, const glm::mat4& viewMatrix) const;
-
-    std::vector<Plane*> _cars;
-
     struct CarData {
         Plane* car;
         glm::vec2 position;
-        bool collected;
     };
+    /// \desc car models, index aligned with RenderSnapshot::carCollected
     std::vector<CarData> _carData;
-
-    float _ghostFreezeTimer = 0.0f;
-    const float GHOST_FREEZE_DURATION = 10.0f;  // 10 seconds
 };
 
 void fp_keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mods );
@@ -0,0 +1,104 @@
+#include "FlythroughBenchmark.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdio>
+
+FlythroughBenchmark::FlythroughBenchmark(const CameraPath& path, GLuint framesPerCell)
+    : _path(path),
+      _framesPerCell(std::max(framesPerCell, 1u)),
+      _frame(0),
+      _frameStart(-1.0),
+      _segments(path.getNumSegments()) {
+    _numFrames = (GLuint)_path.getNumCurves() * _framesPerCell;
+
+    glGenQueries(QUERIES_IN_FLIGHT * 2, &_queries[0][0]);
+    for(GLint& segment : _querySegments) {
+        segment = -1;
+    }
+}
+
+FlythroughBenchmark::~FlythroughBenchmark() {
+    glDeleteQueries(QUERIES_IN_FLIGHT * 2, &_queries[0][0]);
+}
+
+void FlythroughBenchmark::getCamera(glm::vec3& position, glm::vec3& forward) const {
+    const GLuint frame = std::min(_frame, _numFrames - 1);
+    const size_t curve = frame / _framesPerCell;
+    const float t = (float)(frame % _framesPerCell) / (float)_framesPerCell;
+    _path.sample(curve, t, position, forward);
+}
+
+void FlythroughBenchmark::beginFrame() {
+    // the previous frame ends where this one starts so the swap is included
+    const GLdouble now = glfwGetTime();
+    if(_frameStart >= 0.0 && _frame > 0) {
+        _segments[_path.getSegment((_frame - 1) / _framesPerCell)].frameMs.push_back((now - _frameStart) * 1000.0);
+    }
+    _frameStart = now;
+
+    const GLuint slot = _frame % QUERIES_IN_FLIGHT;
+    _collectQuery(slot);
+    glQueryCounter(_queries[slot][0], GL_TIMESTAMP);
+    _querySegments[slot] = (GLint)_path.getSegment(_frame / _framesPerCell);
+}
+
+void FlythroughBenchmark::endFrame() {
+    glQueryCounter(_queries[_frame % QUERIES_IN_FLIGHT][1], GL_TIMESTAMP);
+    _frame++;
+}
+
+void FlythroughBenchmark::report() {
+    // the last frame has no successor to end it
+    if(_frameStart >= 0.0 && _frame > 0) {
+        _segments[_path.getSegment((_frame - 1) / _framesPerCell)].frameMs.push_back((glfwGetTime() - _frameStart) * 1000.0);
+        _frameStart = -1.0;
+    }
+    for(GLuint slot = 0; slot < QUERIES_IN_FLIGHT; slot++) {
+        _collectQuery(slot);
+    }
+
+    fprintf(stdout, "[INFO]: flythrough: %u frames over %zu segments, %u frames per cell\n",
+            _frame, _segments.size(), _framesPerCell);
+    fprintf(stdout, "[INFO]: %-12s %-5s %10s %10s %10s\n", "segment", "time", "min ms", "avg ms", "p99 ms");
+
+    std::vector<GLdouble> allFrames, allGpu;
+    char label[32];
+    for(size_t i = 0; i < _segments.size(); i++) {
+        SegmentTimes& segment = _segments[i];
+        allFrames.insert(allFrames.end(), segment.frameMs.begin(), segment.frameMs.end());
+        allGpu.insert(allGpu.end(), segment.gpuMs.begin(), segment.gpuMs.end());
+        snprintf(label, sizeof(label), "%-12zu frame", i);
+        _printStats(label, segment.frameMs);
+        snprintf(label, sizeof(label), "%-12s gpu  ", "");
+        _printStats(label, segment.gpuMs);
+    }
+    snprintf(label, sizeof(label), "%-12s frame", "total");
+    _printStats(label, allFrames);
+    snprintf(label, sizeof(label), "%-12s gpu  ", "");
+    _printStats(label, allGpu);
+}
+
+void FlythroughBenchmark::_collectQuery(GLuint slot) {
+    if(_querySegments[slot] < 0) return;
+
+    // the query is QUERIES_IN_FLIGHT frames old, waiting on it rarely stalls and keeps every sample
+    GLuint64 startNs = 0, endNs = 0;
+    glGetQueryObjectui64v(_queries[slot][0], GL_QUERY_RESULT, &startNs);
+    glGetQueryObjectui64v(_queries[slot][1], GL_QUERY_RESULT, &endNs);
+    _segments[_querySegments[slot]].gpuMs.push_back((endNs - startNs) / 1.0e6);
+    _querySegments[slot] = -1;
+}
+
+void FlythroughBenchmark::_printStats(const char* label, std::vector<GLdouble>& samples) {
+    if(samples.empty()) {
+        fprintf(stdout, "[INFO]: %s %10s %10s %10s\n", label, "-", "-", "-");
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    GLdouble total = 0.0;
+    for(GLdouble sample : samples) total += sample;
+    const size_t p99 = std::min(samples.size() - 1, (size_t)(samples.size() * 0.99));
+    fprintf(stdout, "[INFO]: %s %10.3f %10.3f %10.3f\n", label, samples.front(), total / samples.size(), samples[p99]);
+}
@@ -0,0 +1,69 @@
+#ifndef FLYTHROUGH_BENCHMARK_H
+#define FLYTHROUGH_BENCHMARK_H
+
+#include "CameraPath.h"
+
+#include <glad/gl.h>
+
+#include <vector>
+
+/// \desc drives the camera along a CameraPath a fixed number of frames per cell and measures
+/// every frame: wall time from one frame start to the next and GPU time between two
+/// GL_TIMESTAMP queries, which unlike GL_TIME_ELAPSED can enclose the GpuProfiler zones.
+/// results are grouped by path segment.  requires a current GL context
+class FlythroughBenchmark {
+public:
+    /// \param path route to fly along, must not be empty
+    /// \param framesPerCell frames spent on every curve of the path
+    FlythroughBenchmark(const CameraPath& path, GLuint framesPerCell);
+    ~FlythroughBenchmark();
+
+    FlythroughBenchmark(const FlythroughBenchmark&) = delete;
+    FlythroughBenchmark& operator=(const FlythroughBenchmark&) = delete;
+
+    /// \desc true once the camera reached the end of the path
+    bool isFinished() const { return _frame >= _numFrames; }
+
+    /// \desc camera of the current frame
+    /// \param [out] position camera position
+    /// \param [out] forward unit view direction
+    void getCamera(glm::vec3& position, glm::vec3& forward) const;
+
+    /// \desc starts measuring a frame, call before drawing anything
+    void beginFrame();
+    /// \desc stops measuring the frame and moves the camera on, call after the swap
+    void endFrame();
+
+    /// \desc prints frame and GPU time statistics of every segment and the whole path
+    void report();
+
+private:
+    /// \desc samples of one path segment in milliseconds
+    struct SegmentTimes {
+        std::vector<GLdouble> frameMs;
+        std::vector<GLdouble> gpuMs;
+    };
+
+    /// \desc reads the result of a query slot into its segment, blocks until it is ready
+    void _collectQuery(GLuint slot);
+    /// \desc prints one line of min, mean and 99th percentile
+    static void _printStats(const char* label, std::vector<GLdouble>& samples);
+
+    CameraPath _path;
+    GLuint _framesPerCell;
+    GLuint _numFrames;
+    GLuint _frame;
+    /// \desc wall time the current frame started at, negative before the first frame
+    GLdouble _frameStart;
+
+    /// \desc frames in flight before a query result is read back
+    static constexpr GLuint QUERIES_IN_FLIGHT = 4;
+    /// \desc start and end timestamp of each frame in flight
+    GLuint _queries[QUERIES_IN_FLIGHT][2];
+    /// \desc segment measured by each query slot, -1 if the slot holds no result
+    GLint _querySegments[QUERIES_IN_FLIGHT];
+
+    std::vector<SegmentTimes> _segments;
+};
+
+#endif
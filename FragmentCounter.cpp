@@ -0,0 +1,66 @@
+#include "FragmentCounter.h"
+
+#include <cstdio>
+
+FragmentCounter::FragmentCounter()
+    : _frame(0),
+      _counting(false),
+      _suspended(false),
+      _lastCount(0) {
+    glGenQueries(FRAMES_IN_FLIGHT * MAX_SEGMENTS, &_queries[0][0]);
+    for(GLuint& numSegments : _numSegments) numSegments = 0;
+}
+
+FragmentCounter::~FragmentCounter() {
+    glDeleteQueries(FRAMES_IN_FLIGHT * MAX_SEGMENTS, &_queries[0][0]);
+}
+
+void FragmentCounter::begin() {
+    const GLuint slot = _frame % FRAMES_IN_FLIGHT;
+    if(_numSegments[slot] > 0) {
+        // a frame the GPU has still not finished is dropped rather than waited for, the
+        // segments finish in order so the last one tells for all of them
+        GLint available = 0;
+        glGetQueryObjectiv(_queries[slot][_numSegments[slot] - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(available) {
+            GLuint64 count = 0;
+            _lastCount = 0;
+            for(GLuint i = 0; i < _numSegments[slot]; i++) {
+                glGetQueryObjectui64v(_queries[slot][i], GL_QUERY_RESULT, &count);
+                _lastCount += count;
+            }
+        }
+        _numSegments[slot] = 0;
+    }
+    _beginSegment();
+}
+
+void FragmentCounter::suspend() {
+    if(!_counting) return;
+    glEndQuery(GL_SAMPLES_PASSED);
+    _counting = false;
+    _suspended = true;
+}
+
+void FragmentCounter::resume() {
+    if(!_suspended) return;
+    _suspended = false;
+    _beginSegment();
+}
+
+void FragmentCounter::_beginSegment() {
+    GLuint& numSegments = _numSegments[_frame % FRAMES_IN_FLIGHT];
+    if(numSegments >= MAX_SEGMENTS) {
+        fprintf(stderr, "[WARN]: fragment counter resumed more than %u times in one frame\n", MAX_SEGMENTS - 1);
+        return;
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, _queries[_frame % FRAMES_IN_FLIGHT][numSegments++]);
+    _counting = true;
+}
+
+void FragmentCounter::end() {
+    if(_counting) glEndQuery(GL_SAMPLES_PASSED);
+    _counting = false;
+    _suspended = false;
+    _frame++;
+}
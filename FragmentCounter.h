@@ -0,0 +1,50 @@
+#ifndef FRAGMENT_COUNTER_H
+#define FRAGMENT_COUNTER_H
+
+#include <glad/gl.h>
+
+/// \desc counts the fragments that pass the depth test in one pass of every frame with a
+/// GL_SAMPLES_PASSED query, the fragments the pass shades.  like GpuFrameTimer the results
+/// are read back a few frames later only if the GPU has finished them, so the CPU never
+/// waits.  requires a current GL context
+class FragmentCounter {
+public:
+    FragmentCounter();
+    ~FragmentCounter();
+
+    FragmentCounter(const FragmentCounter&) = delete;
+    FragmentCounter& operator=(const FragmentCounter&) = delete;
+
+    /// \desc collects the oldest frame in flight and starts counting
+    void begin();
+    /// \desc stops counting until resume(), GL allows one occlusion query at a time so other
+    /// queries in the counted pass must run while suspended.  does nothing outside begin()/end()
+    void suspend();
+    /// \desc counts again after suspend(), the frame's count is the sum of its segments
+    void resume();
+    /// \desc stops counting for this frame
+    void end();
+
+    /// \desc fragments counted in the most recent frame read back, 0 before the first result
+    GLuint64 getLastCount() const { return _lastCount; }
+
+private:
+    /// \desc opens the next query of the current frame
+    void _beginSegment();
+
+    /// \desc frames in flight before a result is read back
+    static constexpr GLuint FRAMES_IN_FLIGHT = 4;
+    /// \desc times a frame may be resumed plus one
+    static constexpr GLuint MAX_SEGMENTS = 2;
+    GLuint _queries[FRAMES_IN_FLIGHT][MAX_SEGMENTS];
+    /// \desc segments issued by every frame not yet read back, 0 for free slots
+    GLuint _numSegments[FRAMES_IN_FLIGHT];
+    GLuint _frame;
+    /// \desc true while a query of the current frame is open
+    bool _counting;
+    /// \desc true between suspend() and resume()
+    bool _suspended;
+    GLuint64 _lastCount;
+};
+
+#endif
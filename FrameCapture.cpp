@@ -0,0 +1,205 @@
+#include "FrameCapture.h"
+
+#include <stb_image_write.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+//*************************************************************************************
+//
+// Public Interface
+
+FrameCapture::FrameCapture(Format format)
+    : _format(format),
+      _nextSlot(0),
+      _stopping(false),
+      _written(0),
+      _encoding(0),
+      _captured(0),
+      _dropped(0),
+      _costMs(0.0) {
+    _encoder = std::thread(&FrameCapture::_encodeLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+    for(GLuint i = 0; i < RING_SIZE; i++) {
+        ReadBack& readBack = _ring[(_nextSlot + i) % RING_SIZE];
+        _collectSlot(readBack, true);
+        if(readBack.buffer) glDeleteBuffers(1, &readBack.buffer);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _jobReady.notify_all();
+    _encoder.join();
+
+    if(_captured > 0 || _dropped > 0) {
+        fprintf(stdout, "[INFO]: capture: %u frames written, %u dropped, %.3f ms per frame on the GL thread\n",
+                _written, _dropped, getAverageCostMs());
+    }
+}
+
+void FrameCapture::capture(GLint width, GLint height, const std::string& filename) {
+    const auto start = std::chrono::steady_clock::now();
+    {
+        // the encoder is too far behind, skip the frame rather than pile up more work
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_jobs.size() + _encoding >= MAX_QUEUED_JOBS) {
+            _dropped++;
+            return;
+        }
+    }
+
+    // every slot still in flight, only happens if the GPU is several frames behind
+    ReadBack& readBack = _ring[_nextSlot];
+    _collectSlot(readBack, true);
+
+    const size_t bytes = (size_t)width * height * 4;
+    if(!readBack.buffer) glGenBuffers(1, &readBack.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readBack.buffer);
+    if(readBack.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_READ);
+        readBack.capacity = bytes;
+    }
+    // with a pack buffer bound the read returns immediately, the copy happens on the GPU
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readBack.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readBack.width = width;
+    readBack.height = height;
+    readBack.filename = filename;
+    _nextSlot = (_nextSlot + 1) % RING_SIZE;
+
+    _captured++;
+    _costMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FrameCapture::collect() {
+    const auto start = std::chrono::steady_clock::now();
+    // oldest first, the slot the next capture goes to was filled the longest time ago
+    for(GLuint i = 0; i < RING_SIZE; i++) {
+        _collectSlot(_ring[(_nextSlot + i) % RING_SIZE], false);
+    }
+    _costMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t FrameCapture::getNumPending() const {
+    size_t inFlight = 0;
+    for(const ReadBack& readBack : _ring) {
+        if(readBack.fence) inFlight++;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    return inFlight + _jobs.size() + _encoding;
+}
+
+unsigned int FrameCapture::getNumWritten() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _written;
+}
+
+//*************************************************************************************
+//
+// Read Back
+
+void FrameCapture::_collectSlot(ReadBack& readBack, bool wait) {
+    if(!readBack.fence) return;
+
+    GLenum status = glClientWaitSync(readBack.fence, 0, 0);
+    while(wait && status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(readBack.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    if(status == GL_TIMEOUT_EXPIRED) return;
+    glDeleteSync(readBack.fence);
+    readBack.fence = nullptr;
+    if(status == GL_WAIT_FAILED) {
+        fprintf(stderr, "[ERROR]: waiting for the read back of \"%s\" failed, frame dropped\n", readBack.filename.c_str());
+        _dropped++;
+        return;
+    }
+
+    EncodeJob job;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_freeBuffers.empty()) {
+            job.pixels = std::move(_freeBuffers.back());
+            _freeBuffers.pop_back();
+        }
+    }
+    job.pixels.resize((size_t)readBack.width * readBack.height * 4);
+    job.width = readBack.width;
+    job.height = readBack.height;
+    job.filename = std::move(readBack.filename);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readBack.buffer);
+    const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)job.pixels.size(), GL_MAP_READ_BIT);
+    if(pixels) {
+        // one straight copy, the rows are flipped on the encoder thread
+        memcpy(job.pixels.data(), pixels, job.pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if(!pixels) {
+        fprintf(stderr, "[ERROR]: could not map the read back of \"%s\", frame dropped\n", job.filename.c_str());
+        _dropped++;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+    _jobReady.notify_one();
+}
+
+//*************************************************************************************
+//
+// Encoding
+
+void FrameCapture::_encodeLoop() {
+    for(;;) {
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobReady.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            // finish the queue before stopping, every collected frame gets written
+            if(_jobs.empty()) return;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            _encoding++;
+        }
+
+        const bool written = _write(job);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _encoding--;
+        if(written) _written++;
+        _freeBuffers.push_back(std::move(job.pixels));
+    }
+}
+
+bool FrameCapture::_write(const EncodeJob& job) const {
+    // GL rows start at the bottom, image files at the top
+    const size_t rowBytes = (size_t)job.width * 4;
+    bool written;
+    if(_format == PNG) {
+        // global to stb, only this thread writes images
+        stbi_flip_vertically_on_write(1);
+        written = stbi_write_png(job.filename.c_str(), job.width, job.height, 4, job.pixels.data(), (int)rowBytes) != 0;
+    } else {
+        FILE* file = fopen(job.filename.c_str(), "wb");
+        written = file != nullptr;
+        for(GLint row = job.height - 1; written && row >= 0; row--) {
+            written = fwrite(&job.pixels[row * rowBytes], 1, rowBytes, file) == rowBytes;
+        }
+        if(file) written = fclose(file) == 0 && written;
+    }
+    if(!written) {
+        fprintf(stderr, "[ERROR]: could not write frame to \"%s\"\n", job.filename.c_str());
+    }
+    return written;
+}
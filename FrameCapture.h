@@ -0,0 +1,115 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/gl.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// \desc writes frames to disk without stalling the pipeline.  a capture only queues an
+/// asynchronous read back into one of a ring of pixel pack buffers and a fence; once the
+/// fence has signalled, a later frame copies the pixels out and hands them to a background
+/// thread that encodes and writes the file.  when the encoder falls too far behind new
+/// captures are dropped and counted instead of blocking the frame.  requires a current GL
+/// context, all calls but the encoding happen on the GL thread
+class FrameCapture {
+public:
+    /// \desc how captured frames are stored
+    enum Format {
+        /// \desc compressed RGBA PNG
+        PNG = 0,
+        /// \desc RGBA8 rows, top row first, no header.  cheap enough to keep up with every frame
+        RAW = 1
+    };
+
+    explicit FrameCapture(Format format);
+    /// \desc finishes every read back in flight, waits for the encoder and prints a summary
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    Format getFormat() const { return _format; }
+    /// \desc file extension of the format including the dot
+    const char* getExtension() const { return _format == PNG ? ".png" : ".rgba"; }
+
+    /// \desc queues a read back of the bound read framebuffer
+    /// \param width width of the area read from the lower left corner
+    /// \param height height of the area read from the lower left corner
+    /// \param filename file the frame is written to
+    void capture(GLint width, GLint height, const std::string& filename);
+
+    /// \desc hands finished read backs to the encoder, call once per frame
+    void collect();
+
+    /// \desc frames queued for read back or encoding, not yet written
+    size_t getNumPending() const;
+    /// \desc frames written so far
+    unsigned int getNumWritten() const;
+    /// \desc captures dropped because the encoder fell behind
+    unsigned int getNumDropped() const { return _dropped; }
+    /// \desc average time the GL thread spent in capture() and collect() per captured frame
+    double getAverageCostMs() const { return _captured > 0 ? _costMs / _captured : 0.0; }
+
+private:
+    /// \desc one pixel pack buffer of the ring
+    struct ReadBack {
+        GLuint buffer = 0;
+        /// \desc null while the slot is free
+        GLsync fence = nullptr;
+        GLint width = 0;
+        GLint height = 0;
+        /// \desc bytes the buffer was allocated with
+        size_t capacity = 0;
+        std::string filename;
+    };
+
+    /// \desc pixels waiting for the encoder
+    struct EncodeJob {
+        /// \desc RGBA8 rows as GL read them, bottom row first
+        std::vector<unsigned char> pixels;
+        GLint width;
+        GLint height;
+        std::string filename;
+    };
+
+    /// \desc copies a signalled read back into an encode job and frees its slot
+    /// \param wait blocks until the fence signalled instead of skipping the slot
+    void _collectSlot(ReadBack& readBack, bool wait);
+    /// \desc encodes and writes queued jobs until told to stop
+    void _encodeLoop();
+    /// \desc writes the pixels of a job in the capture format
+    bool _write(const EncodeJob& job) const;
+
+    Format _format;
+
+    /// \desc read backs in flight, the GPU is usually done with one after two or three frames
+    static constexpr GLuint RING_SIZE = 4;
+    ReadBack _ring[RING_SIZE];
+    /// \desc slot the next capture goes to
+    GLuint _nextSlot;
+
+    /// \desc frames handed to the encoder beyond which new captures are dropped
+    static constexpr size_t MAX_QUEUED_JOBS = 16;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _jobReady;
+    std::deque<EncodeJob> _jobs;
+    /// \desc pixel storage returned by the encoder, reused so captures do not allocate
+    std::vector<std::vector<unsigned char>> _freeBuffers;
+    bool _stopping;
+    unsigned int _written;
+    /// \desc jobs the encoder is writing right now
+    unsigned int _encoding;
+    std::thread _encoder;
+
+    unsigned int _captured;
+    unsigned int _dropped;
+    double _costMs;
+};
+
+#endif
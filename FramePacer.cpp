@@ -0,0 +1,147 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+//*************************************************************************************
+//
+// Public Interface
+
+FramePacer::FramePacer(Mode mode, double frameRateCap)
+    : _mode(mode),
+      _framePeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(frameRateCap, 1.0)))),
+      _started(false),
+      _spinMargin(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(INITIAL_SPIN_MARGIN_MS))),
+      _windowFrames(0),
+      _windowMeanMs(0.0),
+      _windowM2(0.0),
+      _windowMinMs(0.0),
+      _windowMaxMs(0.0),
+      _windowSleepMs(0.0),
+      _windowSpinMs(0.0) {
+#ifdef _WIN32
+    // the default 15.6 ms scheduler tick would leave nearly every wait to the spin
+    if(_mode == CAP) timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer() {
+#ifdef _WIN32
+    if(_mode == CAP) timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::beginFrame() {
+    if(_mode == CAP && _started) {
+        const Clock::time_point now = Clock::now();
+        // a frame that ran more than a whole period late starts a new schedule instead of
+        // rushing the following frames to catch up
+        if(now - _nextDeadline > _framePeriod) {
+            _nextDeadline = now;
+        } else {
+            _waitUntil(_nextDeadline);
+        }
+    }
+
+    const Clock::time_point frameStart = Clock::now();
+    if(_mode == CAP) {
+        _nextDeadline = (_started ? _nextDeadline : frameStart) + _framePeriod;
+    }
+    if(_started) {
+        const double frameMs = std::chrono::duration<double, std::milli>(frameStart - _lastFrameStart).count();
+        if(_windowFrames == 0) {
+            _windowMinMs = frameMs;
+            _windowMaxMs = frameMs;
+        }
+        _windowFrames++;
+        const double delta = frameMs - _windowMeanMs;
+        _windowMeanMs += delta / _windowFrames;
+        _windowM2 += delta * (frameMs - _windowMeanMs);
+        _windowMinMs = std::min(_windowMinMs, frameMs);
+        _windowMaxMs = std::max(_windowMaxMs, frameMs);
+        if(_windowFrames >= REPORT_INTERVAL) {
+            _finishWindow();
+        }
+    }
+    _lastFrameStart = frameStart;
+    _started = true;
+}
+
+const char* FramePacer::getModeName(Mode mode) {
+    switch(mode) {
+        case VSYNC: return "vsync";
+        case CAP: return "cap";
+        case UNCAPPED: return "uncapped";
+        default: return "unknown";
+    }
+}
+
+bool FramePacer::parseMode(const char* name, Mode& mode) {
+    for(Mode candidate : { VSYNC, CAP, UNCAPPED }) {
+        if(strcmp(name, getModeName(candidate)) == 0) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+//*************************************************************************************
+//
+// Waiting
+
+void FramePacer::_waitUntil(Clock::time_point deadline) {
+    // sleep in one go up to the margin, the OS may wake the thread late by up to the margin
+    Clock::time_point now = Clock::now();
+    if(deadline - now > _spinMargin) {
+        const Clock::time_point wakeUp = deadline - _spinMargin;
+        std::this_thread::sleep_until(wakeUp);
+        const Clock::time_point woke = Clock::now();
+        _windowSleepMs += std::chrono::duration<double, std::milli>(woke - now).count();
+
+        // widen the margin to the worst oversleep seen, narrow it slowly otherwise
+        const Clock::duration overslept = woke - wakeUp;
+        if(overslept > _spinMargin) {
+            _spinMargin = overslept;
+        } else {
+            _spinMargin -= std::chrono::duration_cast<Clock::duration>(_spinMargin * SPIN_MARGIN_DECAY);
+        }
+        now = woke;
+    }
+
+    // the rest is too short to trust to the scheduler
+    const Clock::time_point spinStart = now;
+    while(now < deadline) {
+        std::this_thread::yield();
+        now = Clock::now();
+    }
+    _windowSpinMs += std::chrono::duration<double, std::milli>(now - spinStart).count();
+}
+
+void FramePacer::_finishWindow() {
+    _lastStats.frames = _windowFrames;
+    _lastStats.meanMs = _windowMeanMs;
+    _lastStats.stdDevMs = _windowFrames > 1 ? std::sqrt(_windowM2 / (_windowFrames - 1)) : 0.0;
+    _lastStats.minMs = _windowMinMs;
+    _lastStats.maxMs = _windowMaxMs;
+    _lastStats.sleepMs = _windowSleepMs / _windowFrames;
+    _lastStats.spinMs = _windowSpinMs / _windowFrames;
+
+    fprintf(stdout, "[INFO]: frame pacing (%s) over %u frames: mean %.3f ms, stddev %.3f ms, min %.3f ms, max %.3f ms, "
+                    "waited %.3f ms asleep and %.3f ms spinning per frame\n",
+            getModeName(_mode), _lastStats.frames, _lastStats.meanMs, _lastStats.stdDevMs, _lastStats.minMs, _lastStats.maxMs,
+            _lastStats.sleepMs, _lastStats.spinMs);
+
+    _windowFrames = 0;
+    _windowMeanMs = 0.0;
+    _windowM2 = 0.0;
+    _windowSleepMs = 0.0;
+    _windowSpinMs = 0.0;
+}
@@ -0,0 +1,98 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+
+/// \desc decides when the next frame starts and measures how evenly frames are spaced.
+/// a capped frame rate waits for its deadline by sleeping until shortly before it and spinning
+/// the rest of the way; the spin margin adapts to how late the OS wakes the thread up, so the
+/// CPU sleeps through most of the wait without overshooting the target.  owns no GL state
+class FramePacer {
+public:
+    /// \desc how frames are paced
+    enum Mode {
+        /// \desc the swap waits for the display refresh, nothing is waited for here
+        VSYNC = 0,
+        /// \desc frames start at a fixed rate, the swap does not wait for the display
+        CAP = 1,
+        /// \desc frames start as soon as the previous one is done
+        UNCAPPED = 2
+    };
+
+    /// \desc frame time statistics of one reporting window
+    struct FrameStats {
+        unsigned int frames = 0;
+        double meanMs = 0.0;
+        double stdDevMs = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+        /// \desc average time spent asleep and spinning per frame while waiting for a deadline
+        double sleepMs = 0.0;
+        double spinMs = 0.0;
+    };
+
+    /// \param mode how to pace frames
+    /// \param frameRateCap frames per second in CAP mode
+    FramePacer(Mode mode, double frameRateCap);
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    Mode getMode() const { return _mode; }
+    /// \desc swap interval the window should use, 1 in VSYNC mode and 0 otherwise
+    int getSwapInterval() const { return _mode == VSYNC ? 1 : 0; }
+
+    /// \desc waits until the next frame is due and records the time since the previous
+    /// frame started, call once at the very start of every frame
+    void beginFrame();
+
+    /// \desc statistics of the last finished reporting window
+    const FrameStats& getLastStats() const { return _lastStats; }
+
+    /// \desc name of a mode as accepted on the command line
+    static const char* getModeName(Mode mode);
+    /// \desc parses a mode name
+    /// \returns false if the name is not a mode
+    static bool parseMode(const char* name, Mode& mode);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// \desc sleeps and then spins until a point in time
+    void _waitUntil(Clock::time_point deadline);
+    /// \desc prints the statistics of the window and starts a new one
+    void _finishWindow();
+
+    Mode _mode;
+    Clock::duration _framePeriod;
+    /// \desc time the next frame is due in CAP mode
+    Clock::time_point _nextDeadline;
+    /// \desc time the previous frame started, unset before the first frame
+    Clock::time_point _lastFrameStart;
+    bool _started;
+
+    /// \desc the thread wakes up at most this much later than asked, spin this long before a
+    /// deadline instead of sleeping
+    Clock::duration _spinMargin;
+
+    /// \desc running sums of the current window, Welford's method for the variance
+    unsigned int _windowFrames;
+    double _windowMeanMs;
+    double _windowM2;
+    double _windowMinMs;
+    double _windowMaxMs;
+    double _windowSleepMs;
+    double _windowSpinMs;
+    FrameStats _lastStats;
+
+    /// \desc number of frames between two pacing reports
+    static constexpr unsigned int REPORT_INTERVAL = 300;
+    /// \desc spin margin before the first oversleep was seen
+    static constexpr double INITIAL_SPIN_MARGIN_MS = 2.0;
+    /// \desc the spin margin shrinks by this fraction every wait so one slow wake up does
+    /// not keep the thread spinning for good
+    static constexpr double SPIN_MARGIN_DECAY = 0.01;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "GLStats.h"
+
+GLStats::FrameCounters GLStats::_currentFrame = {};
+GLStats::FrameCounters GLStats::_lastFrame = {};
+GLuint GLStats::_boundProgram = GLStats::UNKNOWN_BINDING;
+GLuint GLStats::_boundVao = GLStats::UNKNOWN_BINDING;
+GLuint GLStats::_activeUnit = 0;
+GLuint GLStats::_boundTextures[GLStats::NUM_TRACKED_UNITS] = {
+    UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING,
+    UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING,
+    UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING,
+    UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING, UNKNOWN_BINDING
+};
+
+void GLStats::beginFrame() {
+    _lastFrame = _currentFrame;
+    _currentFrame = {};
+}
+
+void GLStats::invalidateState() {
+    _boundProgram = UNKNOWN_BINDING;
+    _boundVao = UNKNOWN_BINDING;
+    for(GLuint& texture : _boundTextures) {
+        texture = UNKNOWN_BINDING;
+    }
+}
+
+//*************************************************************************************
+//
+// State
+
+void GLStats::useProgram(GLuint program) {
+    if(program == _boundProgram) {
+        _currentFrame.redundantProgramBinds++;
+        return;
+    }
+    glUseProgram(program);
+    _boundProgram = program;
+    _currentFrame.programBinds++;
+}
+
+void GLStats::activeTexture(GLenum textureUnit) {
+    glActiveTexture(textureUnit);
+    _activeUnit = textureUnit - GL_TEXTURE0;
+}
+
+void GLStats::bindTexture(GLenum target, GLuint texture) {
+    const bool tracked = target == GL_TEXTURE_2D && _activeUnit < NUM_TRACKED_UNITS;
+    if(tracked && _boundTextures[_activeUnit] == texture) {
+        _currentFrame.redundantTextureBinds++;
+        return;
+    }
+    glBindTexture(target, texture);
+    if(tracked) _boundTextures[_activeUnit] = texture;
+    _currentFrame.textureBinds++;
+}
+
+void GLStats::bindVertexArray(GLuint vao) {
+    if(vao == _boundVao) {
+        _currentFrame.redundantVaoBinds++;
+        return;
+    }
+    glBindVertexArray(vao);
+    _boundVao = vao;
+    _currentFrame.vaoBinds++;
+}
+
+void GLStats::bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glBufferData(target, size, data, usage);
+    if(data) _currentFrame.bufferBytes += size;
+}
+
+void GLStats::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    glBufferSubData(target, offset, size, data);
+    _currentFrame.bufferBytes += size;
+}
+
+//*************************************************************************************
+//
+// Uniforms
+
+void GLStats::programUniform1i(GLuint program, GLint location, GLint value) {
+    glProgramUniform1i(program, location, value);
+    _currentFrame.uniformUploads++;
+}
+
+void GLStats::programUniform3fv(GLuint program, GLint location, GLsizei count, const GLfloat* value) {
+    glProgramUniform3fv(program, location, count, value);
+    _currentFrame.uniformUploads++;
+}
+
+void GLStats::programUniform4fv(GLuint program, GLint location, GLsizei count, const GLfloat* value) {
+    glProgramUniform4fv(program, location, count, value);
+    _currentFrame.uniformUploads++;
+}
+
+void GLStats::programUniformMatrix3fv(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    glProgramUniformMatrix3fv(program, location, count, transpose, value);
+    _currentFrame.uniformUploads++;
+}
+
+void GLStats::programUniformMatrix4fv(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    glProgramUniformMatrix4fv(program, location, count, transpose, value);
+    _currentFrame.uniformUploads++;
+}
+
+//*************************************************************************************
+//
+// Drawing
+
+void GLStats::drawArrays(GLenum mode, GLint first, GLsizei count) {
+    glDrawArrays(mode, first, count);
+    _countDraw(mode, count);
+}
+
+void GLStats::drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    glDrawElements(mode, count, type, indices);
+    _countDraw(mode, count);
+}
+
+void GLStats::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances) {
+    glDrawElementsInstanced(mode, count, type, indices, instances);
+    _countDraw(mode, count, instances);
+}
+
+void GLStats::drawSolidCube(GLfloat sideLength) {
+    CSCI441::drawSolidCube(sideLength);
+    _countObjectDraw(12);
+}
+
+void GLStats::drawSolidCubeTextured(GLfloat sideLength) {
+    CSCI441::drawSolidCubeTextured(sideLength);
+    _countObjectDraw(12);
+}
+
+void GLStats::drawSolidSphere(GLfloat radius, GLint stacks, GLint slices) {
+    CSCI441::drawSolidSphere(radius, stacks, slices);
+    _countObjectDraw(2ULL * stacks * slices);
+}
+
+void GLStats::drawSolidCylinder(GLfloat base, GLfloat top, GLfloat height, GLint stacks, GLint slices) {
+    CSCI441::drawSolidCylinder(base, top, height, stacks, slices);
+    _countObjectDraw(2ULL * stacks * slices);
+}
+
+void GLStats::_countDraw(GLenum mode, GLsizei count, GLsizei instances) {
+    _currentFrame.drawCalls++;
+    switch(mode) {
+        case GL_TRIANGLES: _currentFrame.triangles += (unsigned long long)(count / 3) * instances; break;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN: _currentFrame.triangles += (unsigned long long)(count > 2 ? count - 2 : 0) * instances; break;
+        default: break;
+    }
+}
+
+void GLStats::_countObjectDraw(unsigned long long triangles) {
+    _currentFrame.drawCalls++;
+    _currentFrame.triangles += triangles;
+    _boundVao = UNKNOWN_BINDING;
+}
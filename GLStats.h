@@ -0,0 +1,97 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#include <glad/gl.h>
+
+#include <CSCI441/objects.hpp>
+
+/// \desc thin layer over the GL calls made while drawing a frame.  counts draw calls, triangles,
+/// uniform uploads, binds and uploaded buffer bytes per frame, and remembers the bound texture,
+/// vertex array and program so that binding the same object again is counted as redundant and
+/// never reaches the driver.  render thread only
+class GLStats {
+public:
+    /// \desc counters of one frame
+    struct FrameCounters {
+        unsigned int drawCalls;
+        unsigned long long triangles;
+        unsigned int uniformUploads;
+        unsigned int textureBinds;
+        unsigned int vaoBinds;
+        unsigned int programBinds;
+        unsigned long long bufferBytes;
+        /// \desc binds skipped because the object was already bound
+        unsigned int redundantTextureBinds;
+        unsigned int redundantVaoBinds;
+        unsigned int redundantProgramBinds;
+    };
+
+    /// \desc finishes the counters of the previous frame and starts counting a new one
+    static void beginFrame();
+    /// \desc counters of the last finished frame
+    static const FrameCounters& getLastFrame() { return _lastFrame; }
+    /// \desc counters of the frame being drawn so far
+    static const FrameCounters& getCurrentFrame() { return _currentFrame; }
+    /// \desc forgets the cached bindings, call after GL state was changed behind this layer's back
+    static void invalidateState();
+
+    //***************************************************************************
+    // State
+
+    static void useProgram(GLuint program);
+    static void activeTexture(GLenum textureUnit);
+    static void bindTexture(GLenum target, GLuint texture);
+    static void bindVertexArray(GLuint vao);
+    static void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+    static void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+
+    //***************************************************************************
+    // Uniforms
+
+    static void programUniform1i(GLuint program, GLint location, GLint value);
+    static void programUniform3fv(GLuint program, GLint location, GLsizei count, const GLfloat* value);
+    static void programUniform4fv(GLuint program, GLint location, GLsizei count, const GLfloat* value);
+    static void programUniformMatrix3fv(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+    static void programUniformMatrix4fv(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+
+    /// \desc sets a uniform through a CSCI441::ShaderProgram
+    template<typename ShaderProgram, typename T>
+    static void setProgramUniform(const ShaderProgram* shader, GLint location, const T& value) {
+        shader->setProgramUniform(location, value);
+        _currentFrame.uniformUploads++;
+    }
+
+    //***************************************************************************
+    // Drawing
+
+    static void drawArrays(GLenum mode, GLint first, GLsizei count);
+    static void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+    static void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances);
+
+    /// \desc CSCI441 objects bind their own vertex arrays, these count them as one draw and
+    /// invalidate the cached vertex array binding
+    static void drawSolidCube(GLfloat sideLength);
+    static void drawSolidCubeTextured(GLfloat sideLength);
+    static void drawSolidSphere(GLfloat radius, GLint stacks, GLint slices);
+    static void drawSolidCylinder(GLfloat base, GLfloat top, GLfloat height, GLint stacks, GLint slices);
+
+private:
+    /// \desc records one draw call of a primitive mode and vertex count
+    static void _countDraw(GLenum mode, GLsizei count, GLsizei instances = 1);
+    /// \desc records one draw of a CSCI441 object
+    static void _countObjectDraw(unsigned long long triangles);
+
+    static FrameCounters _currentFrame;
+    static FrameCounters _lastFrame;
+
+    /// \desc texture units whose 2D texture binding is tracked
+    static constexpr unsigned int NUM_TRACKED_UNITS = 16;
+    /// \desc marks a cached binding as unknown
+    static constexpr GLuint UNKNOWN_BINDING = 0xFFFFFFFF;
+    static GLuint _boundProgram;
+    static GLuint _boundVao;
+    static GLuint _activeUnit;
+    static GLuint _boundTextures[NUM_TRACKED_UNITS];
+};
+
+#endif
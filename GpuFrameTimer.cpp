@@ -0,0 +1,36 @@
+#include "GpuFrameTimer.h"
+
+GpuFrameTimer::GpuFrameTimer()
+    : _frame(0),
+      _lastFrameMs(-1.0) {
+    glGenQueries(FRAMES_IN_FLIGHT * 2, &_queries[0][0]);
+    for(bool& pending : _pending) pending = false;
+}
+
+GpuFrameTimer::~GpuFrameTimer() {
+    glDeleteQueries(FRAMES_IN_FLIGHT * 2, &_queries[0][0]);
+}
+
+void GpuFrameTimer::beginFrame() {
+    const GLuint slot = _frame % FRAMES_IN_FLIGHT;
+    if(_pending[slot]) {
+        // a frame the GPU has still not finished is dropped rather than waited for
+        GLint available = 0;
+        glGetQueryObjectiv(_queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(available) {
+            GLuint64 startNs = 0, endNs = 0;
+            glGetQueryObjectui64v(_queries[slot][0], GL_QUERY_RESULT, &startNs);
+            glGetQueryObjectui64v(_queries[slot][1], GL_QUERY_RESULT, &endNs);
+            _lastFrameMs = (endNs - startNs) / 1000000.0;
+        }
+        _pending[slot] = false;
+    }
+    glQueryCounter(_queries[slot][0], GL_TIMESTAMP);
+}
+
+void GpuFrameTimer::endFrame() {
+    const GLuint slot = _frame % FRAMES_IN_FLIGHT;
+    glQueryCounter(_queries[slot][1], GL_TIMESTAMP);
+    _pending[slot] = true;
+    _frame++;
+}
@@ -0,0 +1,38 @@
+#ifndef GPU_FRAME_TIMER_H
+#define GPU_FRAME_TIMER_H
+
+#include <glad/gl.h>
+
+/// \desc measures the GPU time of whole frames with a pair of GL_TIMESTAMP queries each, which
+/// unlike GL_TIME_ELAPSED can enclose the GpuProfiler zones.  results are read back a few
+/// frames later only if the GPU has finished them, so the CPU never waits.  requires a current
+/// GL context
+class GpuFrameTimer {
+public:
+    GpuFrameTimer();
+    ~GpuFrameTimer();
+
+    GpuFrameTimer(const GpuFrameTimer&) = delete;
+    GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+    /// \desc collects the oldest frame in flight and marks the start of a new frame
+    void beginFrame();
+    /// \desc marks the end of the frame
+    void endFrame();
+
+    /// \desc GPU time of the most recent frame read back in milliseconds, negative before the
+    /// first result arrived
+    GLdouble getLastFrameMs() const { return _lastFrameMs; }
+
+private:
+    /// \desc frames in flight before a result is read back
+    static constexpr GLuint FRAMES_IN_FLIGHT = 4;
+    /// \desc start and end timestamp of each frame in flight
+    GLuint _queries[FRAMES_IN_FLIGHT][2];
+    /// \desc true for every slot holding a frame not yet read back
+    bool _pending[FRAMES_IN_FLIGHT];
+    GLuint _frame;
+    GLdouble _lastFrameMs;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "GpuProfiler.h"
+
+#ifdef FP_ENABLE_PROFILER
+
+GpuProfiler::GpuProfiler()
+    : _currentFrame(0),
+      _zoneOpen(false),
+      _droppedZones(0) {
+    for(FrameQueries& frame : _frames) {
+        glGenQueries(MAX_ZONES_PER_FRAME, frame.queries);
+        frame.numZones = 0;
+        frame.frame = 0;
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    for(FrameQueries& frame : _frames) {
+        glDeleteQueries(MAX_ZONES_PER_FRAME, frame.queries);
+    }
+}
+
+void GpuProfiler::beginFrame() {
+    if(_zoneOpen) endZone();
+
+    _currentFrame = (_currentFrame + 1) % FRAMES_IN_FLIGHT;
+    FrameQueries& frame = _frames[_currentFrame];
+
+    // this slot was recorded FRAMES_IN_FLIGHT frames ago, its results should long be ready
+    for(unsigned int i = 0; i < frame.numZones; i++) {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available) {
+            _droppedZones++;
+            continue;
+        }
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsedNs);
+        Profiler::recordGpuZone(frame.zones[i].name, frame.frame, frame.zones[i].submitNs, elapsedNs);
+    }
+
+    frame.numZones = 0;
+    frame.frame = Profiler::getFrame();
+}
+
+bool GpuProfiler::beginZone(const char* name) {
+    FrameQueries& frame = _frames[_currentFrame];
+    if(_zoneOpen || frame.numZones == MAX_ZONES_PER_FRAME) {
+        _droppedZones++;
+        return false;
+    }
+    frame.zones[frame.numZones] = { name, Profiler::now() };
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.numZones]);
+    _zoneOpen = true;
+    return true;
+}
+
+void GpuProfiler::endZone() {
+    if(!_zoneOpen) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    _frames[_currentFrame].numZones++;
+    _zoneOpen = false;
+}
+
+#endif
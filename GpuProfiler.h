@@ -0,0 +1,91 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/gl.h>
+
+#include "Profiler.h"
+
+/// \desc times GPU passes with GL_TIME_ELAPSED queries and hands the results to the Profiler.
+/// results are read back FRAMES_IN_FLIGHT - 1 frames after they were issued and dropped if the
+/// GPU has still not finished them, so the CPU never waits on a query.  time elapsed queries
+/// cannot nest, passes must be timed one after the other.  requires a current GL context
+class GpuProfiler {
+public:
+#ifdef FP_ENABLE_PROFILER
+    GpuProfiler();
+    ~GpuProfiler();
+
+    /// \desc collects the passes of the oldest frame in flight and starts a new frame
+    void beginFrame();
+    /// \desc starts timing a pass
+    /// \param name pass name, must outlive the profiler
+    /// \returns false if the pass is not timed because another pass is open or the frame
+    /// ran out of queries, endZone() must then not be called for it
+    bool beginZone(const char* name);
+    /// \desc stops timing the current pass
+    void endZone();
+
+    /// \desc number of passes dropped because their result was not ready in time or the
+    /// frame ran out of queries
+    unsigned long long getNumDroppedZones() const { return _droppedZones; }
+#else
+    GpuProfiler() {}
+
+    void beginFrame() {}
+    bool beginZone(const char*) { return false; }
+    void endZone() {}
+    unsigned long long getNumDroppedZones() const { return 0; }
+#endif
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+#ifdef FP_ENABLE_PROFILER
+private:
+    /// \desc frames whose queries can be outstanding at once
+    static constexpr unsigned int FRAMES_IN_FLIGHT = 4;
+    /// \desc passes that can be timed per frame
+    static constexpr unsigned int MAX_ZONES_PER_FRAME = 16;
+
+    struct Zone {
+        const char* name;
+        /// \desc CPU time the pass was submitted at, places the pass on the trace timeline
+        uint64_t submitNs;
+    };
+    struct FrameQueries {
+        GLuint queries[MAX_ZONES_PER_FRAME];
+        Zone zones[MAX_ZONES_PER_FRAME];
+        unsigned int numZones;
+        uint32_t frame;
+    };
+
+    FrameQueries _frames[FRAMES_IN_FLIGHT];
+    /// \desc frame slot currently being recorded
+    unsigned int _currentFrame;
+    bool _zoneOpen;
+    unsigned long long _droppedZones;
+#endif
+};
+
+/// \desc times the GPU work submitted in its scope as one pass
+class GpuProfileZone {
+public:
+    GpuProfileZone(GpuProfiler& profiler, const char* name) : _profiler(profiler), _started(profiler.beginZone(name)) {}
+    ~GpuProfileZone() { if(_started) _profiler.endZone(); }
+
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+private:
+    GpuProfiler& _profiler;
+    bool _started;
+};
+
+#ifdef FP_ENABLE_PROFILER
+/// \desc profiles the GPU work of the rest of the enclosing scope under a name
+#define FP_PROFILE_GPU_ZONE(profiler, name) GpuProfileZone FP_PROFILE_CONCAT(_gpuProfileZone, __LINE__)(profiler, name)
+#else
+#define FP_PROFILE_GPU_ZONE(profiler, name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,291 @@
+#include "InputRecording.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//*************************************************************************************
+//
+// Log Layout
+
+namespace {
+    const char INPUT_LOG_MAGIC[4] = { 'F', 'P', 'I', 'R' };
+    /// \desc 2 since input is polled in the middle of the frame, after the frame event
+    const uint32_t INPUT_LOG_VERSION = 2;
+
+    /// \desc start of every log, the events follow directly.  mapped as is, so logs are only
+    /// portable between machines of the same endianness
+    struct InputLogHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t seed;
+        uint32_t numFrames;
+        double tickRate;
+        uint64_t worldHash;
+        double startTime;
+        uint64_t numEvents;
+    };
+    static_assert(sizeof(InputLogHeader) % sizeof(InputEvent) == 0, "events stay aligned after the header");
+}
+
+//*************************************************************************************
+//
+// Recording
+
+InputRecorder::InputRecorder(const std::string& filename)
+    : _filename(filename),
+      _file(-1),
+      _data(nullptr),
+      _mappedBytes(0),
+      _numEvents(0),
+      _capacity(0),
+      _numFrames(0),
+      _seed(0),
+      _tickRate(0.0),
+      _worldHash(0),
+      _startTime(0.0) {
+#ifndef _WIN32
+    _file = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(_file < 0) {
+        fprintf(stderr, "[ERROR]: could not open \"%s\" for recording input\n", filename.c_str());
+        return;
+    }
+#endif
+    if(!_reserve(GROWTH_EVENTS)) {
+        fprintf(stderr, "[ERROR]: could not map \"%s\" for recording input\n", filename.c_str());
+        _close(0);
+    }
+}
+
+InputRecorder::~InputRecorder() {
+    if(!isOpen()) return;
+
+    InputLogHeader header = {};
+    memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC));
+    header.version = INPUT_LOG_VERSION;
+    header.seed = _seed;
+    header.numFrames = _numFrames;
+    header.tickRate = _tickRate;
+    header.worldHash = _worldHash;
+    header.startTime = _startTime;
+    header.numEvents = _numEvents;
+    memcpy(_data, &header, sizeof(header));
+
+    const size_t length = sizeof(InputLogHeader) + _numEvents * sizeof(InputEvent);
+    fprintf(stdout, "[INFO]: recorded %u frames and %zu input events to \"%s\" (%.1f kb)\n",
+            _numFrames, _numEvents, _filename.c_str(), length / 1024.0);
+    _close(length);
+}
+
+void InputRecorder::recordFrame(uint32_t frame, double time) {
+    InputEvent event = {};
+    event.frame = frame;
+    event.type = InputEvent::FRAME;
+    event.time = time;
+    _append(event);
+    _numFrames = frame + 1;
+}
+
+void InputRecorder::recordKey(uint32_t frame, int key, int action) {
+    InputEvent event = {};
+    event.frame = frame;
+    event.type = InputEvent::KEY;
+    event.code = (int16_t)key;
+    event.action = action;
+    _append(event);
+}
+
+void InputRecorder::recordMouseButton(uint32_t frame, int button, int action) {
+    InputEvent event = {};
+    event.frame = frame;
+    event.type = InputEvent::MOUSE_BUTTON;
+    event.code = (int16_t)button;
+    event.action = action;
+    _append(event);
+}
+
+void InputRecorder::recordCursor(uint32_t frame, float x, float y) {
+    InputEvent event = {};
+    event.frame = frame;
+    event.type = InputEvent::CURSOR;
+    event.cursor[0] = x;
+    event.cursor[1] = y;
+    _append(event);
+}
+
+void InputRecorder::recordStateHash(uint32_t frame, uint64_t hash) {
+    InputEvent event = {};
+    event.frame = frame;
+    event.type = InputEvent::STATE_HASH;
+    event.hash = hash;
+    _append(event);
+}
+
+void InputRecorder::_append(const InputEvent& event) {
+    if(!isOpen()) return;
+    if(_numEvents == _capacity && !_reserve(_capacity + GROWTH_EVENTS)) {
+        fprintf(stderr, "[ERROR]: could not grow \"%s\", input recording stopped\n", _filename.c_str());
+        _close(sizeof(InputLogHeader) + _numEvents * sizeof(InputEvent));
+        return;
+    }
+    memcpy(_data + sizeof(InputLogHeader) + _numEvents * sizeof(InputEvent), &event, sizeof(event));
+    _numEvents++;
+}
+
+bool InputRecorder::_reserve(size_t capacity) {
+    const size_t bytes = sizeof(InputLogHeader) + capacity * sizeof(InputEvent);
+#ifdef _WIN32
+    // no mmap, grow a heap buffer that is written out on close
+    unsigned char* data = (unsigned char*)realloc(_data, bytes);
+    if(!data) return false;
+#else
+    if(ftruncate(_file, (off_t)bytes) != 0) return false;
+    if(_data) munmap(_data, _mappedBytes);
+    unsigned char* data = (unsigned char*)mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+    if(data == MAP_FAILED) {
+        _data = nullptr;
+        return false;
+    }
+#endif
+    _data = data;
+    _mappedBytes = bytes;
+    _capacity = capacity;
+    return true;
+}
+
+void InputRecorder::_close(size_t length) {
+#ifdef _WIN32
+    if(_data && length > 0) {
+        if(FILE* file = fopen(_filename.c_str(), "wb")) {
+            fwrite(_data, 1, length, file);
+            fclose(file);
+        } else {
+            fprintf(stderr, "[ERROR]: could not open \"%s\" for recording input\n", _filename.c_str());
+        }
+    }
+    free(_data);
+#else
+    if(_data) munmap(_data, _mappedBytes);
+    if(_file >= 0) {
+        if(ftruncate(_file, (off_t)length) != 0) {
+            fprintf(stderr, "[ERROR]: could not truncate \"%s\"\n", _filename.c_str());
+        }
+        ::close(_file);
+    }
+    _file = -1;
+#endif
+    _data = nullptr;
+    _mappedBytes = 0;
+}
+
+//*************************************************************************************
+//
+// Replay
+
+InputReplay::InputReplay(const std::string& filename)
+    : _file(-1),
+      _data(nullptr),
+      _mappedBytes(0),
+      _events(nullptr),
+      _numEvents(0),
+      _next(0),
+      _numFrames(0),
+      _seed(0),
+      _tickRate(0.0),
+      _worldHash(0),
+      _startTime(0.0) {
+#ifdef _WIN32
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(!file) {
+        fprintf(stderr, "[ERROR]: could not open input log \"%s\"\n", filename.c_str());
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = size > 0 ? (unsigned char*)malloc((size_t)size) : nullptr;
+    if(!data || fread(data, 1, (size_t)size, file) != (size_t)size) {
+        fprintf(stderr, "[ERROR]: could not read input log \"%s\"\n", filename.c_str());
+        free(data);
+        fclose(file);
+        return;
+    }
+    fclose(file);
+    _data = data;
+    _mappedBytes = (size_t)size;
+#else
+    _file = open(filename.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if(_file < 0 || fstat(_file, &fileStat) != 0) {
+        fprintf(stderr, "[ERROR]: could not open input log \"%s\"\n", filename.c_str());
+        if(_file >= 0) ::close(_file);
+        _file = -1;
+        return;
+    }
+    _mappedBytes = (size_t)fileStat.st_size;
+    void* data = _mappedBytes > 0 ? mmap(nullptr, _mappedBytes, PROT_READ, MAP_PRIVATE, _file, 0) : MAP_FAILED;
+    if(data == MAP_FAILED) {
+        fprintf(stderr, "[ERROR]: could not map input log \"%s\"\n", filename.c_str());
+        ::close(_file);
+        _file = -1;
+        _mappedBytes = 0;
+        return;
+    }
+    _data = (const unsigned char*)data;
+#endif
+
+    InputLogHeader header;
+    if(_mappedBytes < sizeof(header)) {
+        header.version = 0;
+    } else {
+        memcpy(&header, _data, sizeof(header));
+    }
+    if(header.version != INPUT_LOG_VERSION || memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC)) != 0
+       || _mappedBytes < sizeof(header) + header.numEvents * sizeof(InputEvent)) {
+        fprintf(stderr, "[ERROR]: \"%s\" is not a complete input log\n", filename.c_str());
+#ifdef _WIN32
+        free((void*)_data);
+#else
+        munmap((void*)_data, _mappedBytes);
+        ::close(_file);
+        _file = -1;
+#endif
+        _data = nullptr;
+        _mappedBytes = 0;
+        return;
+    }
+
+    _seed = header.seed;
+    _numFrames = header.numFrames;
+    _tickRate = header.tickRate;
+    _worldHash = header.worldHash;
+    _startTime = header.startTime;
+    _numEvents = (size_t)header.numEvents;
+    _events = (const InputEvent*)(_data + sizeof(header));
+    fprintf(stdout, "[INFO]: replaying %u frames and %zu input events from \"%s\"\n", _numFrames, _numEvents, filename.c_str());
+}
+
+InputReplay::~InputReplay() {
+    if(!_data) return;
+#ifdef _WIN32
+    free((void*)_data);
+#else
+    munmap((void*)_data, _mappedBytes);
+    ::close(_file);
+#endif
+}
+
+bool InputReplay::nextEvent(uint32_t frame, InputEvent& event) {
+    if(_next >= _numEvents || _events[_next].frame > frame) return false;
+    event = _events[_next++];
+    return true;
+}
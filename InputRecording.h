@@ -0,0 +1,140 @@
+#ifndef INPUT_RECORDING_H
+#define INPUT_RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// \desc one entry of an input log, 16 bytes so a minute of play at 60 fps stays in the tens
+/// of kilobytes.  events are stored in the order they were applied
+struct InputEvent {
+    /// \desc what the event carries
+    enum Type : uint16_t {
+        /// \desc starts a frame, time holds the clock value the frame was simulated at
+        FRAME = 0,
+        /// \desc key press, repeat or release, code is the GLFW key and action the GLFW action
+        KEY = 1,
+        /// \desc mouse button press or release, code is the GLFW button
+        MOUSE_BUTTON = 2,
+        /// \desc cursor moved to cursor[0], cursor[1] in window coordinates
+        CURSOR = 3,
+        /// \desc hash of the simulation state drawn in the frame, checked during replay
+        STATE_HASH = 4
+    };
+
+    /// \desc frame the event is applied in
+    uint32_t frame;
+    uint16_t type;
+    int16_t code;
+    union {
+        int32_t action;
+        float cursor[2];
+        double time;
+        uint64_t hash;
+    };
+};
+static_assert(sizeof(InputEvent) == 16, "input events are written to disk as is");
+
+/// \desc appends input events to a memory mapped log file.  the file grows in large chunks
+/// and is cut to its real length on close, so recording costs one store per event and never
+/// blocks the frame on a write.  the log starts with a header holding the RNG seed, tick rate
+/// and world hash the recorded run was started with
+class InputRecorder {
+public:
+    /// \param filename log file to create, replaced if it exists
+    explicit InputRecorder(const std::string& filename);
+    /// \desc finishes the header and closes the log
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    /// \desc false if the file could not be created, nothing is recorded then
+    bool isOpen() const { return _data != nullptr; }
+
+    /// \desc state the run depends on besides its input, written to the header
+    void setSeed(uint32_t seed) { _seed = seed; }
+    void setTickRate(double tickRate) { _tickRate = tickRate; }
+    void setWorldHash(uint64_t worldHash) { _worldHash = worldHash; }
+    void setStartTime(double startTime) { _startTime = startTime; }
+
+    void recordFrame(uint32_t frame, double time);
+    void recordKey(uint32_t frame, int key, int action);
+    void recordMouseButton(uint32_t frame, int button, int action);
+    void recordCursor(uint32_t frame, float x, float y);
+    void recordStateHash(uint32_t frame, uint64_t hash);
+
+    /// \desc number of events recorded so far
+    size_t getNumEvents() const { return _numEvents; }
+
+private:
+    void _append(const InputEvent& event);
+    /// \desc grows the file and its mapping to hold at least capacity events
+    bool _reserve(size_t capacity);
+    /// \desc unmaps and closes the file, cutting it to length bytes
+    void _close(size_t length);
+
+    std::string _filename;
+    int _file;
+    unsigned char* _data;
+    /// \desc bytes mapped
+    size_t _mappedBytes;
+    size_t _numEvents;
+    size_t _capacity;
+    uint32_t _numFrames;
+
+    uint32_t _seed;
+    double _tickRate;
+    uint64_t _worldHash;
+    double _startTime;
+
+    /// \desc events the file grows by when full, 1 MiB
+    static constexpr size_t GROWTH_EVENTS = 65536;
+};
+
+/// \desc reads an input log written by InputRecorder through a read only memory mapping and
+/// hands its events out frame by frame
+class InputReplay {
+public:
+    /// \param filename log file to replay
+    explicit InputReplay(const std::string& filename);
+    ~InputReplay();
+
+    InputReplay(const InputReplay&) = delete;
+    InputReplay& operator=(const InputReplay&) = delete;
+
+    /// \desc false if the file is missing or not an input log
+    bool isOpen() const { return _data != nullptr; }
+
+    uint32_t getSeed() const { return _seed; }
+    double getTickRate() const { return _tickRate; }
+    uint64_t getWorldHash() const { return _worldHash; }
+    double getStartTime() const { return _startTime; }
+    /// \desc number of frames recorded
+    uint32_t getNumFrames() const { return _numFrames; }
+
+    /// \desc true once every event has been handed out
+    bool isFinished() const { return _next >= _numEvents; }
+
+    /// \desc hands out the next event of a frame
+    /// \param frame frame being replayed
+    /// \param [out] event next event applied in that frame
+    /// \returns false once the frame has no events left
+    bool nextEvent(uint32_t frame, InputEvent& event);
+
+private:
+    int _file;
+    const unsigned char* _data;
+    size_t _mappedBytes;
+    const InputEvent* _events;
+    size_t _numEvents;
+    size_t _next;
+    uint32_t _numFrames;
+
+    uint32_t _seed;
+    double _tickRate;
+    uint64_t _worldHash;
+    double _startTime;
+};
+
+#endif
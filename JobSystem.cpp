@@ -0,0 +1,131 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cstdio>
+#include <string>
+
+namespace {
+    /// \desc the pool the current thread works for, if any
+    thread_local const JobSystem* tlsOwner = nullptr;
+    /// \desc index of the queue owned by the current worker thread
+    thread_local unsigned int tlsQueueIndex = 0;
+}
+
+JobSystem::JobSystem(unsigned int numWorkers)
+    : _queuedJobs(0),
+      _running(true) {
+    if(numWorkers == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    for(unsigned int i = 0; i <= numWorkers; i++) {
+        _queues.push_back(new WorkQueue());
+    }
+    for(unsigned int i = 0; i < numWorkers; i++) {
+        _workers.emplace_back(&JobSystem::_workerLoop, this, i);
+    }
+
+    fprintf(stdout, "[INFO]: job system started with %u worker threads\n", numWorkers);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _running = false;
+    }
+    _sleepCondition.notify_all();
+
+    for(std::thread& worker : _workers) {
+        worker.join();
+    }
+    for(WorkQueue* queue : _queues) {
+        delete queue;
+    }
+}
+
+void JobSystem::run(JobCounter& counter, std::function<void()> job) {
+    counter._pending.fetch_add(1, std::memory_order_relaxed);
+
+    WorkQueue* queue = _queues[_localQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->jobs.push_back({std::move(job), &counter});
+    }
+    _queuedJobs.fetch_add(1, std::memory_order_release);
+
+    // take the sleep lock so a worker between its check and its wait cannot miss us
+    { std::lock_guard<std::mutex> lock(_sleepMutex); }
+    _sleepCondition.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const unsigned int queueIndex = _localQueueIndex();
+    while(!counter.isDone()) {
+        Job job;
+        if(_findJob(queueIndex, job)) {
+            _execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::_workerLoop(unsigned int queueIndex) {
+    tlsOwner = this;
+    tlsQueueIndex = queueIndex;
+    Profiler::setThreadName(("worker " + std::to_string(queueIndex)).c_str());
+
+    while(_running.load(std::memory_order_acquire)) {
+        Job job;
+        if(_findJob(queueIndex, job)) {
+            _execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleepCondition.wait(lock, [this]() {
+            return !_running.load(std::memory_order_acquire) || _queuedJobs.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+bool JobSystem::_findJob(unsigned int queueIndex, Job& job) {
+    if(_queuedJobs.load(std::memory_order_acquire) <= 0) return false;
+
+    // newest job from our own queue first
+    {
+        WorkQueue* queue = _queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if(!queue->jobs.empty()) {
+            job = std::move(queue->jobs.back());
+            queue->jobs.pop_back();
+            _queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // then steal the oldest job from everyone else
+    const size_t numQueues = _queues.size();
+    for(size_t offset = 1; offset < numQueues; offset++) {
+        WorkQueue* victim = _queues[(queueIndex + offset) % numQueues];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if(!victim->jobs.empty()) {
+            job = std::move(victim->jobs.front());
+            victim->jobs.pop_front();
+            _queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::_execute(Job& job) {
+    job.function();
+    job.counter->_pending.fetch_sub(1, std::memory_order_release);
+}
+
+unsigned int JobSystem::_localQueueIndex() const {
+    if(tlsOwner == this) return tlsQueueIndex;
+    return static_cast<unsigned int>(_queues.size()) - 1;
+}
@@ -0,0 +1,115 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \desc tracks the outstanding jobs of one fork/join group.  fork jobs against it with
+/// JobSystem::run() and join them with JobSystem::wait()
+class JobCounter {
+public:
+    JobCounter() : _pending(0) {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    /// \desc true once every job forked against this counter has finished
+    bool isDone() const { return _pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> _pending;
+};
+
+/// \desc work-stealing thread pool.  every worker owns a deque of jobs; it pops its own work
+/// from the back (newest first, cache warm) and steals from the front of the other workers'
+/// deques when it runs dry.  threads blocked in wait() help execute jobs instead of sleeping
+class JobSystem {
+public:
+    /// \desc starts the worker threads
+    /// \param numWorkers number of background workers, 0 picks one per hardware thread
+    /// minus the calling thread
+    explicit JobSystem(unsigned int numWorkers = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /// \desc forks a job into the pool
+    /// \param counter group the job belongs to
+    /// \param job work to execute on any thread
+    void run(JobCounter& counter, std::function<void()> job);
+
+    /// \desc joins every job forked against the counter.  the calling thread executes
+    /// queued jobs while it waits
+    /// \param counter group to wait on
+    void wait(JobCounter& counter);
+
+    /// \desc splits [begin, end) into chunks of at most grainSize elements and runs
+    /// body(first, last) for every chunk in parallel, returning once all chunks are done
+    /// \param begin first index of the range
+    /// \param end one past the last index of the range
+    /// \param grainSize minimum number of elements handed to a single job
+    /// \param body callable invoked as body(size_t first, size_t last)
+    template<typename Body>
+    void parallelFor(size_t begin, size_t end, size_t grainSize, const Body& body);
+
+    /// \desc number of threads that execute jobs, including the caller of wait()
+    unsigned int getNumThreads() const { return static_cast<unsigned int>(_workers.size()) + 1; }
+
+private:
+    struct Job {
+        std::function<void()> function;
+        JobCounter* counter;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    /// \desc main loop of each background worker
+    void _workerLoop(unsigned int queueIndex);
+    /// \desc pops a job from the given queue or steals one from any other queue
+    bool _findJob(unsigned int queueIndex, Job& job);
+    /// \desc runs a job and signals its counter
+    static void _execute(Job& job);
+    /// \desc queue owned by the calling thread, or the shared submission queue for
+    /// threads outside the pool
+    unsigned int _localQueueIndex() const;
+
+    /// \desc one queue per worker plus a trailing queue for external threads
+    std::vector<WorkQueue*> _queues;
+    std::vector<std::thread> _workers;
+
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCondition;
+    std::atomic<int> _queuedJobs;
+    std::atomic<bool> _running;
+};
+
+template<typename Body>
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, const Body& body) {
+    if(end <= begin) return;
+    if(grainSize == 0) grainSize = 1;
+
+    // not worth the scheduling overhead, run it inline
+    if(end - begin <= grainSize || _workers.empty()) {
+        body(begin, end);
+        return;
+    }
+
+    JobCounter counter;
+    for(size_t first = begin; first < end; first += grainSize) {
+        size_t last = first + grainSize < end ? first + grainSize : end;
+        run(counter, [&body, first, last]() { body(first, last); });
+    }
+    wait(counter);
+}
+
+#endif
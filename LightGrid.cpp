@@ -0,0 +1,112 @@
+#include "LightGrid.h"
+
+#include "GLStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+LightGrid::LightGrid(const glm::vec2& origin, GLfloat cellSize, GLint numCellsX, GLint numCellsZ)
+    : _origin(origin),
+      _cellSize(cellSize),
+      _numCellsX(numCellsX),
+      _numCellsZ(numCellsZ),
+      _cellLights((size_t)numCellsX * numCellsZ),
+      _maxCellLights(0),
+      _numDropped(0) {
+    const GLenum FORMATS[NUM_BUFFERS] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+
+    glGenBuffers(NUM_BUFFERS, _buffers);
+    glGenTextures(NUM_BUFFERS, _textures);
+    for(GLuint i = 0; i < NUM_BUFFERS; i++) {
+        // never empty, a texture buffer without storage reads as incomplete on some drivers
+        glBindBuffer(GL_TEXTURE_BUFFER, _buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, FORMATS[i], _buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    fprintf(stdout, "[INFO]: light grid of %dx%d cells, %.1f units each\n", numCellsX, numCellsZ, cellSize);
+}
+
+LightGrid::~LightGrid() {
+    glDeleteTextures(NUM_BUFFERS, _textures);
+    glDeleteBuffers(NUM_BUFFERS, _buffers);
+}
+
+void LightGrid::build(GLuint maxLightsPerCell) {
+    for(std::vector<GLuint>& cell : _cellLights) cell.clear();
+
+    _lightTexels.clear();
+    for(GLuint i = 0; i < _lights.size(); i++) {
+        const PointLight& light = _lights[i];
+        _lightTexels.emplace_back(light.position, light.radius);
+        _lightTexels.emplace_back(light.color, 0.0f);
+
+        // cells under the square around the light's range, then the exact circle test
+        const glm::vec2 center(light.position.x, light.position.z);
+        const GLint minX = std::max((GLint)std::floor((center.x - light.radius - _origin.x) / _cellSize), 0);
+        const GLint maxX = std::min((GLint)std::floor((center.x + light.radius - _origin.x) / _cellSize), _numCellsX - 1);
+        const GLint minZ = std::max((GLint)std::floor((center.y - light.radius - _origin.y) / _cellSize), 0);
+        const GLint maxZ = std::min((GLint)std::floor((center.y + light.radius - _origin.y) / _cellSize), _numCellsZ - 1);
+        for(GLint z = minZ; z <= maxZ; z++) {
+            for(GLint x = minX; x <= maxX; x++) {
+                const glm::vec2 cellMin = _origin + glm::vec2(x, z) * _cellSize;
+                const glm::vec2 offset = glm::clamp(center, cellMin, cellMin + _cellSize) - center;
+                if(glm::dot(offset, offset) <= light.radius * light.radius) {
+                    _cellLights[z * _numCellsX + x].push_back(i);
+                }
+            }
+        }
+    }
+
+    _cellRanges.clear();
+    _lightIndices.clear();
+    _maxCellLights = 0;
+    _numDropped = 0;
+    for(GLint z = 0; z < _numCellsZ; z++) {
+        for(GLint x = 0; x < _numCellsX; x++) {
+            std::vector<GLuint>& cell = _cellLights[z * _numCellsX + x];
+            if(cell.size() > maxLightsPerCell) {
+                // keep the lights that contribute the most at the center of the cell
+                const glm::vec2 cellCenter = _origin + (glm::vec2(x, z) + 0.5f) * _cellSize;
+                const auto contribution = [&](GLuint index) {
+                    const PointLight& light = _lights[index];
+                    const glm::vec2 offset = glm::vec2(light.position.x, light.position.z) - cellCenter;
+                    return (light.color.r + light.color.g + light.color.b) / (1.0f + glm::dot(offset, offset));
+                };
+                std::partial_sort(cell.begin(), cell.begin() + maxLightsPerCell, cell.end(), [&](GLuint a, GLuint b) {
+                    return contribution(a) > contribution(b);
+                });
+                _numDropped += (GLuint)cell.size() - maxLightsPerCell;
+                cell.resize(maxLightsPerCell);
+            }
+            _cellRanges.push_back((GLuint)_lightIndices.size());
+            _cellRanges.push_back((GLuint)cell.size());
+            _lightIndices.insert(_lightIndices.end(), cell.begin(), cell.end());
+            _maxCellLights = std::max(_maxCellLights, (GLuint)cell.size());
+        }
+    }
+
+    _upload(LIGHT_DATA, _lightTexels.data(), _lightTexels.size() * sizeof(glm::vec4));
+    _upload(CELL_RANGES, _cellRanges.data(), _cellRanges.size() * sizeof(GLuint));
+    _upload(LIGHT_INDICES, _lightIndices.data(), _lightIndices.size() * sizeof(GLuint));
+}
+
+void LightGrid::bind(GLuint firstUnit) const {
+    for(GLuint i = 0; i < NUM_BUFFERS; i++) {
+        GLStats::activeTexture(GL_TEXTURE0 + firstUnit + i);
+        GLStats::bindTexture(GL_TEXTURE_BUFFER, _textures[i]);
+    }
+    GLStats::activeTexture(GL_TEXTURE0);
+}
+
+void LightGrid::_upload(BUFFER_ID buffer, const void* data, size_t bytes) {
+    if(bytes == 0) return;
+    // orphans last frame's storage, the GPU may still be reading it
+    glBindBuffer(GL_TEXTURE_BUFFER, _buffers[buffer]);
+    GLStats::bufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)bytes, data, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
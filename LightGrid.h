@@ -0,0 +1,96 @@
+#ifndef LIGHT_GRID_H
+#define LIGHT_GRID_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \desc culls point lights against a grid of square cells laid over the ground plane.  the
+/// maze is flat, so a cell spans the full height of the scene and a light lands in every cell
+/// its range reaches on the ground.  the lights, the range of each cell's list and the lists
+/// themselves are uploaded to texture buffers that the fragment shader walks for the cell it
+/// falls in, so the lighting cost of a pixel follows the lights near it instead of the total
+/// count.  requires a current GL context
+class LightGrid {
+public:
+    /// \desc a light whose influence ends at its radius
+    struct PointLight {
+        glm::vec3 position;
+        GLfloat radius;
+        glm::vec3 color;
+    };
+
+    /// \param origin corner of the grid with the smallest x and z
+    /// \param cellSize side length of a cell in world units
+    /// \param numCellsX number of cells along x
+    /// \param numCellsZ number of cells along z
+    LightGrid(const glm::vec2& origin, GLfloat cellSize, GLint numCellsX, GLint numCellsZ);
+    ~LightGrid();
+
+    LightGrid(const LightGrid&) = delete;
+    LightGrid& operator=(const LightGrid&) = delete;
+
+    /// \desc removes every light, call before adding the lights of a new frame
+    void clear() { _lights.clear(); }
+    /// \desc adds a light to the next build
+    void addLight(const glm::vec3& position, const glm::vec3& color, GLfloat radius) { _lights.push_back({ position, radius, color }); }
+
+    /// \desc bins the lights added since clear() into the cells and uploads the result
+    /// \param maxLightsPerCell cells reached by more lights keep the ones contributing the
+    /// most at their center, bounds the work of a single pixel
+    void build(GLuint maxLightsPerCell);
+
+    /// \desc binds the light data, cell ranges and light indices to three consecutive texture
+    /// units starting at firstUnit, texture unit 0 is active afterwards
+    void bind(GLuint firstUnit) const;
+
+    const glm::vec2& getOrigin() const { return _origin; }
+    GLfloat getCellSize() const { return _cellSize; }
+    GLint getNumCellsX() const { return _numCellsX; }
+    GLint getNumCellsZ() const { return _numCellsZ; }
+
+    /// \desc lights in the last build
+    GLuint getNumLights() const { return (GLuint)_lights.size(); }
+    /// \desc longest cell list of the last build
+    GLuint getMaxCellLights() const { return _maxCellLights; }
+    /// \desc light to cell assignments the last build dropped to stay within maxLightsPerCell
+    GLuint getNumDropped() const { return _numDropped; }
+
+private:
+    /// \desc texture buffers walked by the fragment shader
+    enum BUFFER_ID {
+        /// \desc two RGBA32F texels per light, position and radius then color
+        LIGHT_DATA = 0,
+        /// \desc one RG32UI texel per cell, first index and count of its list
+        CELL_RANGES = 1,
+        /// \desc R32UI light indices of all cell lists back to back
+        LIGHT_INDICES = 2
+    };
+    static constexpr GLuint NUM_BUFFERS = 3;
+
+    /// \desc replaces the contents of a texture buffer
+    void _upload(BUFFER_ID buffer, const void* data, size_t bytes);
+
+    glm::vec2 _origin;
+    GLfloat _cellSize;
+    GLint _numCellsX;
+    GLint _numCellsZ;
+
+    std::vector<PointLight> _lights;
+    /// \desc lights reaching each cell, kept across frames so binning does not allocate
+    std::vector<std::vector<GLuint>> _cellLights;
+
+    std::vector<glm::vec4> _lightTexels;
+    std::vector<GLuint> _cellRanges;
+    std::vector<GLuint> _lightIndices;
+
+    GLuint _maxCellLights;
+    GLuint _numDropped;
+
+    GLuint _buffers[NUM_BUFFERS];
+    GLuint _textures[NUM_BUFFERS];
+};
+
+#endif
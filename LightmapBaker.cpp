@@ -0,0 +1,253 @@
+#include "LightmapBaker.h"
+
+#include "JobSystem.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+/// \desc start of every lightmap cache file
+struct LightmapFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    int32_t numLayers;
+    float scale;
+};
+
+static const char LIGHTMAP_MAGIC[4] = { 'F', 'P', 'L', 'M' };
+
+/// \desc rows of texels handed to a single bake job
+static const size_t ROW_GRAIN_SIZE = 4;
+
+/// \desc folds bytes into a 64 bit FNV-1a hash
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t bytes) {
+    const unsigned char* bytePtr = (const unsigned char*)data;
+    for(size_t i = 0; i < bytes; i++) {
+        hash = (hash ^ bytePtr[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+LightmapBaker::LightmapBaker(const std::vector<std::vector<int>>& world, const LightmapSettings& settings)
+    : _world(world),
+      _settings(settings),
+      _numCellsX((int)world.size()),
+      _numCellsZ(world.empty() ? 0 : (int)world[0].size()) {
+    _texelsPerCell = std::min(MAX_TEXELS_PER_CELL, MAX_LAYER_SIZE / std::max(std::max(_numCellsX, _numCellsZ), 1));
+    const glm::vec3& color = _settings.lightColor;
+    _scale = _settings.ambient + _settings.directionalScale * std::max(std::max(color.r, color.g), color.b);
+
+    _key = 14695981039346656037ull;
+    _key = hashBytes(_key, &VERSION, sizeof(VERSION));
+    _key = hashBytes(_key, &_texelsPerCell, sizeof(_texelsPerCell));
+    _key = hashBytes(_key, &_settings, sizeof(_settings));
+    for(const std::vector<int>& row : world) {
+        _key = hashBytes(_key, row.data(), row.size() * sizeof(int));
+    }
+
+    // a spiral over the unit disc lifted onto the hemisphere gives evenly spread cosine
+    // weighted directions, the same ones every bake
+    for(int i = 0; i < NUM_AO_SAMPLES; i++) {
+        const float radius = std::sqrt((i + 0.5f) / NUM_AO_SAMPLES);
+        const float angle = i * glm::pi<float>() * (3.0f - std::sqrt(5.0f));
+        _aoDirections[i] = glm::vec3(radius * std::cos(angle), radius * std::sin(angle), std::sqrt(1.0f - radius * radius));
+    }
+}
+
+bool LightmapBaker::loadOrBake(JobSystem& jobSystem, const std::string& cacheDirectory) {
+    if(_texelsPerCell < 1) {
+        fprintf(stderr, "[WARN]: a %dx%d maze is too large for a lightmap, lighting it live\n", _numCellsX, _numCellsZ);
+        return false;
+    }
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), "lightmap_%016llx.bin", (unsigned long long)_key);
+    const std::string path = cacheDirectory.empty() ? filename : cacheDirectory + "/" + filename;
+    if(_load(path)) {
+        fprintf(stdout, "[INFO]: lightmap loaded from \"%s\"\n", path.c_str());
+        return true;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    _texels.assign((size_t)getWidth() * getHeight() * NUM_LAYERS * 3, 0);
+    jobSystem.parallelFor(0, (size_t)getHeight() * NUM_LAYERS, ROW_GRAIN_SIZE, [this](size_t first, size_t last) {
+        _bakeRows(first, last);
+    });
+    const double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "[INFO]: baked a %dx%dx%d lightmap in %.1f ms on %u threads\n",
+            getWidth(), getHeight(), (int)NUM_LAYERS, bakeMs, jobSystem.getNumThreads());
+
+    _save(path);
+    return true;
+}
+
+//*************************************************************************************
+//
+// Baking
+
+void LightmapBaker::_bakeRows(size_t first, size_t last) {
+    const int width = getWidth();
+    const int height = getHeight();
+    const float texelSize = CELL_SIZE / _texelsPerCell;
+    const float halfCell = CELL_SIZE * 0.5f;
+
+    for(size_t row = first; row < last; row++) {
+        const int layer = (int)(row / height);
+        const int y = (int)(row % height);
+        const int cellZ = y / _texelsPerCell;
+        // position along the height of a wall face, or along z on the upward faces
+        const float v = ((y % _texelsPerCell) + 0.5f) * texelSize;
+        unsigned char* texel = &_texels[((size_t)layer * height + y) * width * 3];
+
+        for(int x = 0; x < width; x++, texel += 3) {
+            const int cellX = x / _texelsPerCell;
+            const float u = ((x % _texelsPerCell) + 0.5f) * texelSize;
+            const glm::vec3 cellCorner(cellX * CELL_SIZE - halfCell, 0.0f, cellZ * CELL_SIZE - halfCell);
+
+            glm::vec3 position, normal;
+            int neighborX = cellX, neighborZ = cellZ;
+            switch(layer) {
+                case UP:
+                    position = cellCorner + glm::vec3(u, _isWall(cellX, cellZ) ? WALL_HEIGHT : FLOOR_HEIGHT, v);
+                    normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                    break;
+                case POSITIVE_X:
+                    position = cellCorner + glm::vec3(CELL_SIZE, v, u);
+                    normal = glm::vec3(1.0f, 0.0f, 0.0f);
+                    neighborX++;
+                    break;
+                case NEGATIVE_X:
+                    position = cellCorner + glm::vec3(0.0f, v, u);
+                    normal = glm::vec3(-1.0f, 0.0f, 0.0f);
+                    neighborX--;
+                    break;
+                case POSITIVE_Z:
+                    position = cellCorner + glm::vec3(u, v, CELL_SIZE);
+                    normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                    neighborZ++;
+                    break;
+                default:
+                    position = cellCorner + glm::vec3(u, v, 0.0f);
+                    normal = glm::vec3(0.0f, 0.0f, -1.0f);
+                    neighborZ--;
+                    break;
+            }
+            // only wall faces open to a corridor are ever seen
+            if(layer != UP) {
+                const bool insideMaze = neighborX >= 0 && neighborX < _numCellsX && neighborZ >= 0 && neighborZ < _numCellsZ;
+                if(!_isWall(cellX, cellZ) || !insideMaze || _isWall(neighborX, neighborZ)) continue;
+            }
+
+            const glm::vec3 light = _bakeTexel(position, normal) / _scale;
+            for(int c = 0; c < 3; c++) {
+                texel[c] = (unsigned char)(std::min(light[c], 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+glm::vec3 LightmapBaker::_bakeTexel(const glm::vec3& position, const glm::vec3& normal) const {
+    // start just off the surface so the face does not occlude itself
+    const glm::vec3 origin = position + normal * 0.01f;
+
+    const glm::vec3 toLight = -glm::normalize(_settings.lightDirection);
+    const float lambert = std::max(glm::dot(normal, toLight), 0.0f);
+    float shadow = 0.0f;
+    if(lambert > 0.0f) {
+        shadow = 1.0f;
+        // past the maze's diagonal nothing can be in the way any more
+        const float maxDistance = std::sqrt((float)(_numCellsX * _numCellsX + _numCellsZ * _numCellsZ)) * CELL_SIZE + WALL_HEIGHT;
+        for(float t = SHADOW_STEP; t < maxDistance; t += SHADOW_STEP) {
+            const glm::vec3 point = origin + toLight * t;
+            if(point.y > WALL_HEIGHT && toLight.y >= 0.0f) break;
+            if(_isSolid(point)) {
+                shadow = 0.0f;
+                break;
+            }
+        }
+    }
+
+    const glm::vec3 tangent = glm::normalize(glm::cross(std::abs(normal.y) > 0.5f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f), normal));
+    const glm::vec3 bitangent = glm::cross(normal, tangent);
+    float occlusion = 0.0f;
+    for(const glm::vec3& sample : _aoDirections) {
+        const glm::vec3 direction = tangent * sample.x + bitangent * sample.y + normal * sample.z;
+        for(float t = AO_STEP; t < AO_RANGE; t += AO_STEP) {
+            if(_isSolid(origin + direction * t)) {
+                // near walls occlude more than far ones
+                occlusion += 1.0f - t / AO_RANGE;
+                break;
+            }
+        }
+    }
+    const float ambientOcclusion = 1.0f - occlusion / NUM_AO_SAMPLES;
+
+    return glm::vec3(_settings.ambient * ambientOcclusion) + _settings.lightColor * (_settings.directionalScale * lambert * shadow);
+}
+
+bool LightmapBaker::_isSolid(const glm::vec3& position) const {
+    if(position.y < FLOOR_HEIGHT) return true;
+    if(position.y > WALL_HEIGHT) return false;
+    return _isWall((int)std::floor(position.x / CELL_SIZE + 0.5f), (int)std::floor(position.z / CELL_SIZE + 0.5f));
+}
+
+bool LightmapBaker::_isWall(int x, int z) const {
+    if(x < 0 || x >= _numCellsX || z < 0 || z >= (int)_world[x].size()) return false;
+    return _world[x][z] == 1;
+}
+
+//*************************************************************************************
+//
+// Cache
+
+bool LightmapBaker::_load(const std::string& filename) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(!file) return false;
+
+    LightmapFileHeader header;
+    const size_t numBytes = (size_t)getWidth() * getHeight() * NUM_LAYERS * 3;
+    bool loaded = fread(&header, sizeof(header), 1, file) == 1 &&
+                  memcmp(header.magic, LIGHTMAP_MAGIC, sizeof(LIGHTMAP_MAGIC)) == 0 &&
+                  header.version == VERSION && header.key == _key &&
+                  header.width == getWidth() && header.height == getHeight() && header.numLayers == NUM_LAYERS;
+    if(loaded) {
+        _texels.resize(numBytes);
+        loaded = fread(_texels.data(), 1, numBytes, file) == numBytes;
+    }
+    fclose(file);
+
+    if(!loaded) {
+        fprintf(stderr, "[WARN]: ignoring stale or damaged lightmap cache \"%s\"\n", filename.c_str());
+        _texels.clear();
+    }
+    return loaded;
+}
+
+void LightmapBaker::_save(const std::string& filename) const {
+    LightmapFileHeader header;
+    memcpy(header.magic, LIGHTMAP_MAGIC, sizeof(LIGHTMAP_MAGIC));
+    header.version = VERSION;
+    header.key = _key;
+    header.width = getWidth();
+    header.height = getHeight();
+    header.numLayers = NUM_LAYERS;
+    header.scale = _scale;
+
+    FILE* file = fopen(filename.c_str(), "wb");
+    bool written = file &&
+                   fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(_texels.data(), 1, _texels.size(), file) == _texels.size();
+    if(file) written = fclose(file) == 0 && written;
+    if(written) {
+        fprintf(stdout, "[INFO]: lightmap cached to \"%s\"\n", filename.c_str());
+    } else {
+        fprintf(stderr, "[WARN]: could not cache the lightmap to \"%s\", it is baked again next run\n", filename.c_str());
+    }
+}
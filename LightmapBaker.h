@@ -0,0 +1,107 @@
+#ifndef LIGHTMAP_BAKER_H
+#define LIGHTMAP_BAKER_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+/// \desc the static light baked into the maze
+struct LightmapSettings {
+    /// \desc direction the directional light travels in
+    glm::vec3 lightDirection;
+    glm::vec3 lightColor;
+    /// \desc ambient light before occlusion
+    float ambient;
+    /// \desc weight of the directional diffuse term
+    float directionalScale;
+};
+
+/// \desc bakes the directional light, its shadows and ambient occlusion onto the floor and
+/// walls of a maze on the CPU.  the lightmap is a stack of layers covering the maze with one
+/// tile per cell: the upward faces of floor and wall tops, then one layer per side direction
+/// for the wall faces.  a texel is found from the world position and normal alone, so the
+/// geometry needs no lightmap coordinates.  baked texels are cached to disk keyed by a hash of
+/// the world and the light, the same maze only bakes once
+class LightmapBaker {
+public:
+    /// \desc layers of the lightmap, by the direction the faces in them point to
+    enum Layer {
+        UP = 0,
+        POSITIVE_X = 1,
+        NEGATIVE_X = 2,
+        POSITIVE_Z = 3,
+        NEGATIVE_Z = 4,
+        NUM_LAYERS = 5
+    };
+
+    /// \desc maze geometry the lightmap is baked for, matching FPEngine's scene
+    static constexpr float CELL_SIZE = 3.0f;
+    static constexpr float WALL_HEIGHT = 3.0f;
+    static constexpr float FLOOR_HEIGHT = -0.1f;
+
+    /// \param world maze cells, 1 for walls, indexed [x][z]
+    /// \param settings light to bake
+    LightmapBaker(const std::vector<std::vector<int>>& world, const LightmapSettings& settings);
+
+    /// \desc loads the cached lightmap of this maze and light, baking and caching it if there is none
+    /// \param jobSystem thread pool the texels are baked on
+    /// \param cacheDirectory directory the cache files live in
+    /// \returns false if the maze is too large for a lightmap
+    bool loadOrBake(JobSystem& jobSystem, const std::string& cacheDirectory);
+
+    /// \desc size of one layer in texels
+    int getWidth() const { return _numCellsX * _texelsPerCell; }
+    int getHeight() const { return _numCellsZ * _texelsPerCell; }
+    int getTexelsPerCell() const { return _texelsPerCell; }
+    int getNumCellsX() const { return _numCellsX; }
+    int getNumCellsZ() const { return _numCellsZ; }
+    /// \desc RGB8 texels of all layers, the light divided by getScale()
+    const std::vector<unsigned char>& getTexels() const { return _texels; }
+    /// \desc light of a texel at full intensity
+    float getScale() const { return _scale; }
+
+private:
+    /// \desc texels per cell side, fewer for large mazes to stay below MAX_LAYER_SIZE
+    static constexpr int MAX_TEXELS_PER_CELL = 8;
+    /// \desc largest side of a layer in texels
+    static constexpr int MAX_LAYER_SIZE = 2048;
+    /// \desc hemisphere samples per texel for the ambient occlusion
+    static constexpr int NUM_AO_SAMPLES = 24;
+    /// \desc distance beyond which walls no longer occlude
+    static constexpr float AO_RANGE = 2.5f;
+    static constexpr float AO_STEP = 0.15f;
+    static constexpr float SHADOW_STEP = 0.05f;
+    /// \desc bumped whenever the baked result changes, invalidates old cache files
+    static constexpr uint32_t VERSION = 1;
+
+    /// \desc bakes the rows [first, last) counted over all layers
+    void _bakeRows(size_t first, size_t last);
+    /// \desc light arriving at a surface point
+    glm::vec3 _bakeTexel(const glm::vec3& position, const glm::vec3& normal) const;
+    /// \desc true inside a wall or below the floor
+    bool _isSolid(const glm::vec3& position) const;
+    /// \desc true for wall cells, false outside the maze
+    bool _isWall(int x, int z) const;
+
+    bool _load(const std::string& filename);
+    void _save(const std::string& filename) const;
+
+    const std::vector<std::vector<int>>& _world;
+    LightmapSettings _settings;
+    int _numCellsX;
+    int _numCellsZ;
+    int _texelsPerCell;
+    float _scale;
+    /// \desc hash of the world, the light and the baker version
+    uint64_t _key;
+    /// \desc cosine weighted directions around +z, rotated onto each texel's normal
+    glm::vec3 _aoDirections[NUM_AO_SAMPLES];
+
+    std::vector<unsigned char> _texels;
+};
+
+#endif
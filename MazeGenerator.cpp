@@ -0,0 +1,144 @@
+#include "MazeGenerator.h"
+
+#include "JobSystem.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cstdio>
+
+//*************************************************************************************
+//
+// Helper Functions
+
+/// \desc mixes the maze seed with a stream index so that neighboring rows get unrelated
+/// random streams
+static unsigned long long streamSeed(unsigned int seed, unsigned int stream) {
+    unsigned long long z = ((unsigned long long)seed << 32 | stream) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/// \desc splitmix64 stream.  carving needs a few random bits per cell, so a generator that is
+/// cheap to seed per row and to step matters more than statistical strength here
+class MazeRandom {
+public:
+    explicit MazeRandom(unsigned long long seed) : _state(seed) {}
+
+    unsigned int next() {
+        unsigned long long z = (_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return (unsigned int)((z ^ (z >> 31)) >> 32);
+    }
+
+    /// \returns a value in [0, bound)
+    unsigned int below(unsigned int bound) { return (unsigned int)(((unsigned long long)next() * bound) >> 32); }
+
+private:
+    unsigned long long _state;
+};
+
+//*************************************************************************************
+//
+// Public Interface
+
+MazeGenerator::MazeGenerator(JobSystem* jobSystem)
+    : _jobSystem(jobSystem) {}
+
+std::vector<std::vector<int>> MazeGenerator::generate(const MazeOptions& options) const {
+    if(options.size < MIN_SIZE || options.size > MAX_SIZE) {
+        fprintf(stderr, "[ERROR]: maze size %d is outside [%d, %d]\n", options.size, MIN_SIZE, MAX_SIZE);
+        return {};
+    }
+
+    const int size = options.size;
+    std::vector<std::vector<int>> world(size);
+    // node cells sit on odd coordinates, the last one right inside the border
+    const int numNodeRows = ((size - 3) | 1) / 2 + 1;
+
+    auto carveRows = [&world, &options, size](size_t first, size_t last) {
+        for(size_t row = first; row < last; row++) {
+            const int i = 2 * (int)row + 1;
+            // a node row owns itself and the wall row above it, allocate both here so the
+            // page faults are spread over the threads as well
+            world[i - 1].assign(size, CELL_WALL);
+            world[i].assign(size, CELL_WALL);
+            _carveRow(world, i, options);
+        }
+    };
+    if(_jobSystem) {
+        _jobSystem->parallelFor(0, numNodeRows, ROW_GRAIN_SIZE, carveRows);
+    } else {
+        carveRows(0, numNodeRows);
+    }
+    // trailing border rows below the last node row
+    for(int i = 2 * numNodeRows; i < size; i++) {
+        world[i].assign(size, CELL_WALL);
+    }
+
+    const int ghosts = _placeCells(world, CELL_GHOST, options.numGhosts, streamSeed(options.seed, size));
+    const int pickups = _placeCells(world, CELL_CAR, options.numPickups, streamSeed(options.seed, size + 1));
+    if(ghosts < options.numGhosts || pickups < options.numPickups) {
+        fprintf(stderr, "[ERROR]: maze only had room for %d ghosts and %d pickups\n", ghosts, pickups);
+    }
+    return world;
+}
+
+//*************************************************************************************
+//
+// Private Helper Functions
+
+void MazeGenerator::_carveRow(std::vector<std::vector<int>>& world, int i, const MazeOptions& options) {
+    MazeRandom rng(streamSeed(options.seed, i));
+    // a wall survives the knock out pass if a random 32 bit value falls below this
+    const unsigned long long keepThreshold = (unsigned long long)(std::max(0.0f, options.wallDensity) * 4294967296.0);
+    const int last = (options.size - 3) | 1;
+    std::vector<int>& row = world[i];
+    std::vector<int>& above = world[i - 1];
+
+    int runStart = 1;
+    for(int j = 1; j <= last; j += 2) {
+        row[j] = CELL_POINT;
+        const bool atEastEdge = j == last;
+        if(i == 1) {
+            // the first row has nothing above it and is one long corridor
+            if(!atEastEdge) row[j + 1] = CELL_POINT;
+            continue;
+        }
+        if(atEastEdge || (rng.next() & 1)) {
+            // close the run and connect one of its cells to the row above
+            const int runLength = (j - runStart) / 2 + 1;
+            above[runStart + 2 * (int)rng.below(runLength)] = CELL_POINT;
+            runStart = j + 2;
+        } else {
+            row[j + 1] = CELL_POINT;
+        }
+    }
+
+    if(options.wallDensity >= 1.0f) return;
+    // knock out remaining walls between two nodes: east walls of this row and the walls
+    // between this row and the one above.  the pillars on even coordinates stay
+    for(int j = 1; j <= last; j += 2) {
+        if(j < last && row[j + 1] == CELL_WALL && rng.next() >= keepThreshold) row[j + 1] = CELL_POINT;
+        if(i > 1 && above[j] == CELL_WALL && rng.next() >= keepThreshold) above[j] = CELL_POINT;
+    }
+}
+
+int MazeGenerator::_placeCells(std::vector<std::vector<int>>& world, int cellType, int count, unsigned long long seed) {
+    const int size = (int)world.size();
+    MazeRandom rng(seed);
+
+    int placed = 0;
+    // rejection sampling stays fast while the maze is mostly empty, give up once it is not
+    for(long long attempts = 64LL * count; placed < count && attempts > 0; attempts--) {
+        const int i = 1 + (int)rng.below(size - 2);
+        const int j = 1 + (int)rng.below(size - 2);
+        // keep the player spawn clear
+        if(i <= 3 && j <= 3) continue;
+        if(world[i][j] != CELL_POINT) continue;
+        world[i][j] = cellType;
+        placed++;
+    }
+    return placed;
+}
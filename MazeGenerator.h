@@ -0,0 +1,56 @@
+#ifndef MAZE_GENERATOR_H
+#define MAZE_GENERATOR_H
+
+#include <cstddef>
+#include <vector>
+
+class JobSystem;
+
+/// \desc parameters of a generated maze
+struct MazeOptions {
+    /// \desc side length of the maze in cells including the solid border
+    int size = 16;
+    /// \desc seed of every random choice, the same options always produce the same maze
+    unsigned int seed = 1;
+    /// \desc fraction of the walls of the perfect maze that are kept.  1 leaves exactly one
+    /// path between any two cells, lower values knock out walls and open up loops
+    float wallDensity = 1.0f;
+    /// \desc number of ghost cells to place
+    int numGhosts = 8;
+    /// \desc number of car pickup cells to place
+    int numPickups = 4;
+};
+
+/// \desc carves seeded mazes in the world format.  rows are carved with the sidewinder
+/// algorithm, which only ever connects a row to the row above it, so every row is carved
+/// by its own job with its own random stream and the result does not depend on the number
+/// of threads
+class MazeGenerator {
+public:
+    /// \param jobSystem thread pool to carve the rows on, rows are carved serially when null
+    explicit MazeGenerator(JobSystem* jobSystem = nullptr);
+
+    /// \desc generates a maze.  the player spawn on cell (1,1) is always open and kept
+    /// free of ghosts and pickups
+    /// \param options size, seed, wall density and contents of the maze
+    /// \returns the maze cells, empty if the options are invalid
+    std::vector<std::vector<int>> generate(const MazeOptions& options) const;
+
+    /// \desc smallest maze that has room for a single open cell
+    static constexpr int MIN_SIZE = 3;
+    /// \desc largest supported maze
+    static constexpr int MAX_SIZE = 8192;
+
+private:
+    /// \desc carves the node row i and the walls between it and the row above
+    static void _carveRow(std::vector<std::vector<int>>& world, int i, const MazeOptions& options);
+    /// \desc turns up to count random open cells into the given cell type
+    static int _placeCells(std::vector<std::vector<int>>& world, int cellType, int count, unsigned long long seed);
+
+    JobSystem* _jobSystem;
+
+    /// \desc rows handed to a single job
+    static constexpr size_t ROW_GRAIN_SIZE = 8;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "OcclusionCuller.h"
+
+OcclusionCuller::OcclusionCuller()
+    : _conditionalOpen(false),
+      _numQueried(0),
+      _numHidden(0) {
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    if(!_queries.empty()) {
+        glDeleteQueries((GLsizei)_queries.size(), _queries.data());
+    }
+}
+
+void OcclusionCuller::beginFrame(GLuint numObjects) {
+    // last frame's queries were consumed by its own draws, they are only counted here
+    GLuint queried = 0, hidden = 0;
+    bool complete = true;
+    for(size_t i = 0; i < _issued.size(); i++) {
+        if(!_issued[i]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available) {
+            complete = false;
+            break;
+        }
+        GLuint anySamples = 0;
+        glGetQueryObjectuiv(_queries[i], GL_QUERY_RESULT, &anySamples);
+        queried++;
+        if(!anySamples) hidden++;
+    }
+    if(complete) {
+        _numQueried = queried;
+        _numHidden = hidden;
+    }
+
+    if(_queries.size() < numObjects) {
+        const size_t first = _queries.size();
+        _queries.resize(numObjects);
+        glGenQueries((GLsizei)(numObjects - first), &_queries[first]);
+    }
+    _issued.assign(numObjects, false);
+}
+
+void OcclusionCuller::beginQuery(GLuint object) {
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, _queries[object]);
+    _issued[object] = true;
+}
+
+void OcclusionCuller::endQuery() {
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+}
+
+void OcclusionCuller::beginConditional(GLuint object) {
+    if(!_issued[object]) return;
+    // the GPU waits for the query, not the CPU.  the proxies of every object are issued
+    // before the first conditional draw, so the result is usually there already
+    glBeginConditionalRender(_queries[object], GL_QUERY_WAIT);
+    _conditionalOpen = true;
+}
+
+void OcclusionCuller::endConditional() {
+    if(!_conditionalOpen) return;
+    glEndConditionalRender();
+    _conditionalOpen = false;
+}
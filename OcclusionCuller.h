@@ -0,0 +1,49 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glad/gl.h>
+
+#include <vector>
+
+/// \desc skips the draws of objects hidden behind what is already in the depth buffer.  a
+/// cheap proxy of every object is tested with a GL_ANY_SAMPLES_PASSED query, then the real
+/// draws run under conditional rendering on that query.  the GPU decides whether they run,
+/// so nothing is read back on the CPU.  results are collected for statistics a frame later
+/// only if the GPU has finished them.  requires a current GL context
+class OcclusionCuller {
+public:
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    /// \desc collects the last frame's results and forgets its queries
+    /// \param numObjects objects that may be queried this frame, indexed from 0
+    void beginFrame(GLuint numObjects);
+
+    /// \desc starts the query of an object, draw its proxy with color and depth writes off
+    void beginQuery(GLuint object);
+    void endQuery();
+
+    /// \desc draws until endConditional() only if the proxy of the object was visible, an
+    /// object without a query this frame is always drawn
+    void beginConditional(GLuint object);
+    void endConditional();
+
+    /// \desc objects queried in the most recent frame read back
+    GLuint getNumQueried() const { return _numQueried; }
+    /// \desc objects of the most recent frame read back whose draws were skipped
+    GLuint getNumHidden() const { return _numHidden; }
+
+private:
+    std::vector<GLuint> _queries;
+    /// \desc true for every object queried this frame
+    std::vector<bool> _issued;
+    /// \desc true between beginConditional() and endConditional() of a queried object
+    bool _conditionalOpen;
+    GLuint _numQueried;
+    GLuint _numHidden;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef OFFSCREEN_TARGET_H
+#define OFFSCREEN_TARGET_H
+
+#include <glad/gl.h>
+
+/// \desc framebuffer object with a color and a depth renderbuffer that frames are drawn into
+/// when there is no window to present to, or a color texture when a later pass samples the
+/// frame.  requires a current GL context
+class OffscreenTarget {
+public:
+    /// \param width width of the color and depth attachments in pixels
+    /// \param height height of the color and depth attachments in pixels
+    /// \param sampledColor attach a texture instead of a renderbuffer as color, leaves texture
+    /// unit 0 with no 2D texture bound
+    OffscreenTarget(GLint width, GLint height, bool sampledColor = false);
+    ~OffscreenTarget();
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    /// \desc false if the driver rejected the attachments, nothing should be drawn then
+    bool isComplete() const { return _complete; }
+    GLint getWidth() const { return _width; }
+    GLint getHeight() const { return _height; }
+    /// \desc color attachment to sample from, 0 unless constructed with sampledColor
+    GLuint getColorTexture() const { return _colorTexture; }
+
+    /// \desc binds the framebuffer for drawing and reading
+    void bind() const;
+
+    /// \desc copies the color attachment into the bound draw framebuffer, filtered linearly
+    /// when the sizes differ
+    /// \param width width of the destination rectangle in pixels
+    /// \param height height of the destination rectangle in pixels
+    void blitTo(GLint width, GLint height) const;
+
+private:
+    GLint _width;
+    GLint _height;
+    GLuint _framebuffer;
+    GLuint _colorRenderbuffer;
+    GLuint _colorTexture;
+    GLuint _depthRenderbuffer;
+    bool _complete;
+};
+
+#endif
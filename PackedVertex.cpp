@@ -0,0 +1,45 @@
+#include "PackedVertex.h"
+
+#include <glm/gtc/packing.hpp>
+
+PackedBounds VertexPacking::computeBounds(const glm::vec3* positions, size_t count) {
+    PackedBounds bounds;
+    if(count == 0) return bounds;
+
+    glm::vec3 minimum = positions[0], maximum = positions[0];
+    for(size_t i = 1; i < count; i++) {
+        minimum = glm::min(minimum, positions[i]);
+        maximum = glm::max(maximum, positions[i]);
+    }
+    bounds.offset = (minimum + maximum) * 0.5f;
+    bounds.scale = (maximum - minimum) * 0.5f;
+    // a flat mesh has no extent along its normal, every position there is the offset
+    for(int i = 0; i < 3; i++) {
+        if(bounds.scale[i] <= 0.0f) bounds.scale[i] = 1.0f;
+    }
+    return bounds;
+}
+
+PackedVertex VertexPacking::pack(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& texCoord, const PackedBounds& bounds) {
+    PackedVertex vertex;
+    const glm::vec3 normalized = (position - bounds.offset) / bounds.scale;
+    for(int i = 0; i < 3; i++) {
+        vertex.position[i] = (GLshort)glm::packSnorm1x16(normalized[i]);
+    }
+    vertex.padding = 0;
+    vertex.normal = glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+    vertex.texCoord[0] = glm::packHalf1x16(texCoord.x);
+    vertex.texCoord[1] = glm::packHalf1x16(texCoord.y);
+    return vertex;
+}
+
+void VertexPacking::setAttributePointers(GLint positionLocation, GLint normalLocation, GLint texCoordLocation) {
+    glEnableVertexAttribArray(positionLocation);
+    glVertexAttribPointer(positionLocation, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+
+    glEnableVertexAttribArray(normalLocation);
+    glVertexAttribPointer(normalLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+
+    glEnableVertexAttribArray(texCoordLocation);
+    glVertexAttribPointer(texCoordLocation, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
+}
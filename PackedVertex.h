@@ -0,0 +1,44 @@
+#ifndef PACKED_VERTEX_H
+#define PACKED_VERTEX_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+/// \desc 16 byte vertex, half of three float positions, normals and two float texture
+/// coordinates.  positions are signed normalized shorts inside the bounds of their mesh,
+/// normals are packed 10:10:10:2 and texture coordinates are half floats
+struct PackedVertex {
+    GLshort position[3];
+    /// \desc keeps the normal 4 byte aligned
+    GLshort padding;
+    GLuint normal;
+    GLushort texCoord[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay tightly packed");
+
+/// \desc box the positions of a mesh are quantized in, the vertex shader maps a packed
+/// position p back with p * scale + offset.  the defaults leave unpacked meshes unchanged
+struct PackedBounds {
+    glm::vec3 scale = glm::vec3(1.0f);
+    glm::vec3 offset = glm::vec3(0.0f);
+};
+
+/// \desc converts float vertices to PackedVertex and describes the packed layout to GL
+class VertexPacking {
+public:
+    /// \desc the smallest box around a set of positions, centered on them so the precision
+    /// is spent where the mesh is
+    static PackedBounds computeBounds(const glm::vec3* positions, size_t count);
+
+    /// \param bounds box from computeBounds() the position lies in
+    /// \param normal unit length normal
+    static PackedVertex pack(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& texCoord, const PackedBounds& bounds);
+
+    /// \desc points the attributes of the bound vertex array at a GL_ARRAY_BUFFER of PackedVertex
+    static void setAttributePointers(GLint positionLocation, GLint normalLocation, GLint texCoordLocation);
+};
+
+#endif
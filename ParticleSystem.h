@@ -3,7 +3,8 @@
 
 #include <glm/glm.hpp>
 #include <vector>
-#include <CSCI441/ShaderProgram.hpp>
+
+class JobSystem;
 
 struct Particle {
     glm::vec3 position;
@@ -13,28 +14,32 @@ struct Particle {
     glm::vec3 color;
 };
 
+/// \desc simulates the death explosion.  holds no GL state, the engine draws the particles
 class ParticleSystem {
 public:
-    ParticleSystem(GLuint shaderProgramHandle, GLint mvpMatrixUniform, GLint colorUniform);
+    /// \desc particles emitted by the death explosion
+    static constexpr int NUM_PARTICLES = 100;
+
+    ParticleSystem();
     
-    void spawn(const glm::vec3& position);
-    void update(float deltaTime);
-    void draw(const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
+    /// \desc restarts the explosion at a position
+    /// \param position center of the explosion
+    /// \param numParticles number of particles to emit
+    void spawn(const glm::vec3& position, int numParticles = NUM_PARTICLES);
+    /// \desc advances every particle, fanning out over the job system when one is given
+    void update(float deltaTime, JobSystem* jobSystem = nullptr);
     bool isAlive() const { return _timeSinceSpawn < _totalLifetime; }
+    const std::vector<Particle>& getParticles() const { return _particles; }
     
 private:
     std::vector<Particle> _particles;
     float _timeSinceSpawn;
     const float _totalLifetime = 5.0f;
     
-    GLuint _shaderProgramHandle;
-    GLint _mvpMatrixUniform;
-    GLint _colorUniform;
-    
-    static constexpr int NUM_PARTICLES = 100;
     static constexpr float PARTICLE_SPEED = 5.0f;
     static constexpr float PARTICLE_SIZE = 0.2f;
     static constexpr float GRAVITY = -9.81f;
+    static constexpr size_t UPDATE_GRAIN_SIZE = 256;
 };
 
-#endif 
\ No newline at end of file
+#endif 
@@ -1,5 +1,7 @@
 #include "Plane.h"
 
+#include "GLStats.h"
+
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -8,9 +10,10 @@
 
 #include <cmath> // for sin function
 
-Plane::Plane( GLuint shaderProgramHandle, GLint mvpMtxUniformLocation, GLint normalMtxUniformLocation, GLint materialColorUniformLocation ) {
+Plane::Plane( GLuint shaderProgramHandle, GLint mvpMtxUniformLocation, GLint modelMtxUniformLocation, GLint normalMtxUniformLocation, GLint materialColorUniformLocation ) {
     _shaderProgramHandle                            = shaderProgramHandle;
     _shaderProgramUniformLocations.mvpMtx           = mvpMtxUniformLocation;
+    _shaderProgramUniformLocations.modelMtx         = modelMtxUniformLocation;
     _shaderProgramUniformLocations.normalMtx        = normalMtxUniformLocation;
     _shaderProgramUniformLocations.materialColor    = materialColorUniformLocation;
 
@@ -23,12 +26,14 @@ Plane::Plane( GLuint shaderProgramHandle, GLint mvpMtxUniformLocation, GLint nor
     _internalTimer = 0.0f;
 }
 
-void Plane::drawPlane( glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx ) {
-    _internalTimer += 0.016f;
+void Plane::update( GLfloat deltaTime ) {
+    _internalTimer += deltaTime;
     if (_internalTimer >= _2PI) {
         _internalTimer -= _2PI;
     }
+}
 
+glm::mat4 Plane::_animate( glm::mat4 modelMtx ) const {
     modelMtx = glm::rotate(modelMtx, _internalTimer * _spinSpeed, glm::vec3(0.0f, 1.0f, 0.0f));
 
     modelMtx = glm::rotate(modelMtx, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
@@ -37,53 +42,73 @@ void Plane::drawPlane( glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx
     modelMtx = glm::translate(modelMtx, glm::vec3(0.0f, carHeight, 0.0f));
 
     float rumbleOffset = sin(_internalTimer * _rumbleSpeed) * _rumbleAmount;
-    modelMtx = glm::translate(modelMtx, glm::vec3(0, rumbleOffset, 0));
+    return glm::translate(modelMtx, glm::vec3(0, rumbleOffset, 0));
+}
+
+void Plane::getHeadlightPositions( glm::mat4 modelMtx, glm::vec3 positions[NUM_HEADLIGHTS] ) const {
+    modelMtx = _animate(modelMtx);
+    // the front pair of the lights drawPlane draws
+    for (int j = 0; j < NUM_HEADLIGHTS; j++) {
+        positions[j] = glm::vec3(modelMtx * glm::vec4(1.1f, 0.0f, j == 0 ? -0.5f : 0.5f, 1.0f));
+    }
+}
+
+void Plane::getBounds( const glm::mat4& modelMtx, glm::vec3& center, glm::vec3& halfExtent ) const {
+    // drawPlane's parts reach 1.15 along the car and 0.85 across it, 0.4 below and 0.5 above
+    // its center, the car spins around y so any direction in xz is as far as the corner
+    center = glm::vec3(modelMtx * glm::vec4(0.0f, 0.55f, 0.0f, 1.0f));
+    halfExtent = glm::vec3(1.45f, 0.45f + std::abs(_rumbleAmount), 1.45f);
+}
+
+void Plane::drawPlane( glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx ) {
+    modelMtx = _animate(modelMtx);
 
     glm::mat4 bodyMtx = glm::scale(modelMtx, _scaleBody);
-    _computeAndSendMatrixUniforms(bodyMtx, viewMtx, projMtx);
-    glProgramUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorBody));
-    CSCI441::drawSolidCube(1.0f);
+    computeAndSendMatrixUniforms(bodyMtx, viewMtx, projMtx);
+    GLStats::programUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorBody));
+    GLStats::drawSolidCube(1.0f);
 
     glm::mat4 roofMtx = glm::translate(modelMtx, glm::vec3(0, 0.35f, 0));
     roofMtx = glm::scale(roofMtx, glm::vec3(1.6f, 0.3f, 1.0f));
-    _computeAndSendMatrixUniforms(roofMtx, viewMtx, projMtx);
-    CSCI441::drawSolidCube(1.0f);
+    computeAndSendMatrixUniforms(roofMtx, viewMtx, projMtx);
+    GLStats::drawSolidCube(1.0f);
 
-    glProgramUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorWheels));
+    GLStats::programUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorWheels));
     for (int i = -1; i <= 1; i += 2) {
         for (int j = -1; j <= 1; j += 2) {
             glm::mat4 wheelMtx = glm::translate(modelMtx, glm::vec3(i * 0.9f, -0.25f, j * 0.7f));
             wheelMtx = glm::rotate(wheelMtx, glm::radians(90.0f), glm::vec3(0, 0, 1));
             wheelMtx = glm::scale(wheelMtx, glm::vec3(0.3f, 0.1f, 0.3f));
-            _computeAndSendMatrixUniforms(wheelMtx, viewMtx, projMtx);
-            CSCI441::drawSolidCylinder(0.5f, 0.5f, 1.0f, 16, 16);
+            computeAndSendMatrixUniforms(wheelMtx, viewMtx, projMtx);
+            GLStats::drawSolidCylinder(0.5f, 0.5f, 1.0f, 16, 16);
         }
     }
 
-    glProgramUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorWindows));
+    GLStats::programUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorWindows));
     for (int i = -1; i <= 1; i += 2) {
         glm::mat4 windowMtx = glm::translate(modelMtx, glm::vec3(i * 0.7f, 0.3f, 0.0f));
         windowMtx = glm::scale(windowMtx, glm::vec3(0.2f, 0.25f, 0.9f));
         windowMtx = glm::rotate(windowMtx, glm::radians(i * 20.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        _computeAndSendMatrixUniforms(windowMtx, viewMtx, projMtx);
-        CSCI441::drawSolidCube(1.0f);
+        computeAndSendMatrixUniforms(windowMtx, viewMtx, projMtx);
+        GLStats::drawSolidCube(1.0f);
     }
 
-    glProgramUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorLights));
+    GLStats::programUniform3fv(_shaderProgramHandle, _shaderProgramUniformLocations.materialColor, 1, glm::value_ptr(_colorLights));
     for (int i = -1; i <= 1; i += 2) {
         for (int j = -1; j <= 1; j += 2) {
             glm::mat4 lightMtx = glm::translate(modelMtx, glm::vec3(i * 1.1f, 0.0f, j * 0.5f));
             lightMtx = glm::scale(lightMtx, glm::vec3(0.1f, 0.1f, 0.1f));
-            _computeAndSendMatrixUniforms(lightMtx, viewMtx, projMtx);
-            CSCI441::drawSolidSphere(0.5f, 10, 10);
+            computeAndSendMatrixUniforms(lightMtx, viewMtx, projMtx);
+            GLStats::drawSolidSphere(0.5f, 10, 10);
         }
     }
 }
 
-void Plane::_computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const {
+void Plane::computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const {
     glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-    glProgramUniformMatrix4fv( _shaderProgramHandle, _shaderProgramUniformLocations.mvpMtx, 1, GL_FALSE, glm::value_ptr(mvpMtx) );
+    GLStats::programUniformMatrix4fv( _shaderProgramHandle, _shaderProgramUniformLocations.mvpMtx, 1, GL_FALSE, glm::value_ptr(mvpMtx) );
+    GLStats::programUniformMatrix4fv( _shaderProgramHandle, _shaderProgramUniformLocations.modelMtx, 1, GL_FALSE, glm::value_ptr(modelMtx) );
 
     glm::mat3 normalMtx = glm::mat3( glm::transpose( glm::inverse( modelMtx )));
-    glProgramUniformMatrix3fv( _shaderProgramHandle, _shaderProgramUniformLocations.normalMtx, 1, GL_FALSE, glm::value_ptr(normalMtx) );
+    GLStats::programUniformMatrix3fv( _shaderProgramHandle, _shaderProgramUniformLocations.normalMtx, 1, GL_FALSE, glm::value_ptr(normalMtx) );
 }
@@ -11,9 +11,10 @@ public:
     /// \desc creates a simple plane that gives the appearance of flight
     /// \param shaderProgramHandle shader program handle that the plane should be drawn using
     /// \param mvpMtxUniformLocation uniform location for the full precomputed MVP matrix
+    /// \param modelMtxUniformLocation uniform location for the model matrix
     /// \param normalMtxUniformLocation uniform location for the precomputed Normal matrix
     /// \param materialColorUniformLocation uniform location for the material diffuse color
-    Plane( GLuint shaderProgramHandle, GLint mvpMtxUniformLocation, GLint normalMtxUniformLocation, GLint materialColorUniformLocation );
+    Plane( GLuint shaderProgramHandle, GLint mvpMtxUniformLocation, GLint modelMtxUniformLocation, GLint normalMtxUniformLocation, GLint materialColorUniformLocation );
 
     /// \desc draws the model plane for a given MVP matrix
     /// \param modelMtx existing model matrix to apply to plane
@@ -21,6 +22,30 @@ public:
     /// \param projMtx camera projection matrix to apply to plane
     void drawPlane( glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx );
 
+    /// \desc number of headlights at the front of the car
+    static constexpr int NUM_HEADLIGHTS = 2;
+    /// \desc world positions of the headlights as drawn by drawPlane
+    /// \param modelMtx existing model matrix to apply to plane
+    /// \param positions receives NUM_HEADLIGHTS positions
+    void getHeadlightPositions( glm::mat4 modelMtx, glm::vec3 positions[NUM_HEADLIGHTS] ) const;
+    /// \desc world box holding the car in any spin and rumble, for occlusion tests
+    /// \param modelMtx existing model matrix to apply to plane, a translation only
+    /// \param center receives the center of the box
+    /// \param halfExtent receives half the size of the box along each axis
+    void getBounds( const glm::mat4& modelMtx, glm::vec3& center, glm::vec3& halfExtent ) const;
+
+    /// \desc advances the spin and rumble animation
+    /// \param deltaTime real time since the last update in seconds
+    void update( GLfloat deltaTime );
+
+    /// \desc precomputes the matrix uniforms CPU-side and then sends them
+    /// to the GPU to be used in the shader for each vertex.  It is more efficient
+    /// to calculate these once and then use the resultant product in the shader.
+    /// \param modelMtx model transformation matrix
+    /// \param viewMtx camera view matrix
+    /// \param projMtx camera projection matrix
+    void computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const;
+
 private:
     /// \desc handle of the shader program to use when drawing the plane
     GLuint _shaderProgramHandle;
@@ -28,6 +53,8 @@ private:
     struct ShaderProgramUniformLocations {
         /// \desc location of the precomputed ModelViewProjection matrix
         GLint mvpMtx;
+        /// \desc location of the model matrix
+        GLint modelMtx;
         /// \desc location of the precomputed Normal matrix
         GLint normalMtx;
         /// \desc location of the material diffuse color
@@ -99,13 +126,9 @@ private:
     /// \param projMtx camera projection matrix to apply to plane
     void _drawPlaneTail(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx ) const;
 
-    /// \desc precomputes the matrix uniforms CPU-side and then sends them
-    /// to the GPU to be used in the shader for each vertex.  It is more efficient
-    /// to calculate these once and then use the resultant product in the shader.
-    /// \param modelMtx model transformation matrix
-    /// \param viewMtx camera view matrix
-    /// \param projMtx camera projection matrix
-    void _computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const;
+    /// \desc applies the spin and rumble animation to the car's model matrix
+    /// \param modelMtx existing model matrix to apply to plane
+    glm::mat4 _animate( glm::mat4 modelMtx ) const;
 
     /// Add internal animation state
     float _internalTimer;
@@ -0,0 +1,199 @@
+#include "Profiler.h"
+
+#ifdef FP_ENABLE_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace {
+    /// \desc ring of the most recent events of one thread.  the owning thread is the only
+    /// writer, the mutex is only ever contended while exporting
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Profiler::Event> events;
+        /// \desc total number of events ever recorded, the ring index is written % capacity
+        uint64_t written = 0;
+        uint32_t threadId = 0;
+        std::string name;
+    };
+
+    struct ProfilerState {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::atomic<uint32_t> frame{0};
+        /// \desc guards the list itself, not the buffers in it
+        std::mutex buffersMutex;
+        /// \desc buffers of every thread that ever recorded, kept after the thread exits so
+        /// its events can still be exported
+        std::vector<ThreadBuffer*> buffers;
+        ThreadBuffer gpuBuffer;
+    };
+
+    ProfilerState& state() {
+        static ProfilerState* profilerState = new ProfilerState();
+        return *profilerState;
+    }
+
+    thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+    ThreadBuffer& localBuffer() {
+        if(!tlsBuffer) {
+            ProfilerState& profiler = state();
+            ThreadBuffer* buffer = new ThreadBuffer();
+            buffer->events.resize(Profiler::EVENTS_PER_THREAD);
+            std::lock_guard<std::mutex> lock(profiler.buffersMutex);
+            buffer->threadId = (uint32_t)profiler.buffers.size() + 1;
+            buffer->name = "thread " + std::to_string(buffer->threadId);
+            profiler.buffers.push_back(buffer);
+            tlsBuffer = buffer;
+        }
+        return *tlsBuffer;
+    }
+
+    void push(ThreadBuffer& buffer, const Profiler::Event& event) {
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.events[buffer.written % buffer.events.size()] = event;
+        buffer.written++;
+    }
+
+    /// \desc copies the buffered events of a thread in recording order
+    void collect(ThreadBuffer& buffer, std::vector<Profiler::Event>& events) {
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        const uint64_t capacity = buffer.events.size();
+        const uint64_t first = buffer.written > capacity ? buffer.written - capacity : 0;
+        for(uint64_t i = first; i < buffer.written; i++) {
+            events.push_back(buffer.events[i % capacity]);
+        }
+    }
+
+    /// \desc every buffered event plus the thread names, GPU track last
+    void snapshotAll(std::vector<Profiler::Event>& events, std::vector<std::pair<uint32_t, std::string>>& threadNames) {
+        ProfilerState& profiler = state();
+        std::vector<ThreadBuffer*> buffers;
+        {
+            std::lock_guard<std::mutex> lock(profiler.buffersMutex);
+            buffers = profiler.buffers;
+        }
+        for(ThreadBuffer* buffer : buffers) {
+            collect(*buffer, events);
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            threadNames.emplace_back(buffer->threadId, buffer->name);
+        }
+        collect(profiler.gpuBuffer, events);
+        threadNames.emplace_back(Profiler::GPU_THREAD_ID, "GPU");
+    }
+
+    /// \desc writes a string as a JSON string literal
+    void writeJsonString(FILE* file, const char* text) {
+        fputc('"', file);
+        for(const char* c = text; *c; c++) {
+            if(*c == '"' || *c == '\\') fputc('\\', file);
+            if((unsigned char)*c >= 0x20) fputc(*c, file);
+        }
+        fputc('"', file);
+    }
+}
+
+uint64_t Profiler::now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state().start).count();
+}
+
+void Profiler::beginFrame() {
+    state().frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t Profiler::getFrame() {
+    return state().frame.load(std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char* name) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void Profiler::recordZone(const char* name, uint64_t startNs, uint64_t endNs) {
+    ThreadBuffer& buffer = localBuffer();
+    push(buffer, { name, startNs, endNs - startNs, getFrame(), buffer.threadId });
+}
+
+void Profiler::recordGpuZone(const char* name, uint32_t frame, uint64_t startNs, uint64_t durationNs) {
+    ThreadBuffer& buffer = state().gpuBuffer;
+    {
+        // the GPU ring is allocated on first use so CPU-only tools never pay for it
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        if(buffer.events.empty()) {
+            buffer.events.resize(EVENTS_PER_THREAD);
+            buffer.threadId = GPU_THREAD_ID;
+        }
+    }
+    push(buffer, { name, startNs, durationNs, frame, GPU_THREAD_ID });
+}
+
+bool Profiler::exportChromeTrace(const std::string& filename) {
+    std::vector<Event> events;
+    std::vector<std::pair<uint32_t, std::string>> threadNames;
+    snapshotAll(events, threadNames);
+
+    FILE* file = fopen(filename.c_str(), "w");
+    if(!file) {
+        fprintf(stderr, "[ERROR]: could not open \"%s\" for writing\n", filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    for(const auto& threadName : threadNames) {
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": ",
+                first ? "" : ",\n", threadName.first);
+        writeJsonString(file, threadName.second.c_str());
+        fprintf(file, "}}");
+        first = false;
+    }
+    for(const Event& event : events) {
+        fprintf(file, ",\n{\"name\": ");
+        writeJsonString(file, event.name);
+        fprintf(file, ", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %u}}",
+                event.threadId == GPU_THREAD_ID ? "gpu" : "cpu", event.threadId,
+                event.startNs / 1000.0, event.durationNs / 1000.0, event.frame);
+    }
+    fprintf(file, "\n]}\n");
+
+    const bool written = fclose(file) == 0;
+    if(written) {
+        fprintf(stdout, "[INFO]: wrote %zu profiler events to %s\n", events.size(), filename.c_str());
+    }
+    return written;
+}
+
+bool Profiler::exportCsv(const std::string& filename) {
+    std::vector<Event> events;
+    std::vector<std::pair<uint32_t, std::string>> threadNames;
+    snapshotAll(events, threadNames);
+
+    FILE* file = fopen(filename.c_str(), "w");
+    if(!file) {
+        fprintf(stderr, "[ERROR]: could not open \"%s\" for writing\n", filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "thread,zone,frame,start_ms,duration_ms\n");
+    for(const Event& event : events) {
+        const auto threadName = std::find_if(threadNames.begin(), threadNames.end(),
+                                             [&event](const std::pair<uint32_t, std::string>& entry) { return entry.first == event.threadId; });
+        fprintf(file, "%s,%s,%u,%.6f,%.6f\n",
+                threadName != threadNames.end() ? threadName->second.c_str() : "?", event.name, event.frame,
+                event.startNs / 1.0e6, event.durationNs / 1.0e6);
+    }
+
+    const bool written = fclose(file) == 0;
+    if(written) {
+        fprintf(stdout, "[INFO]: wrote %zu profiler events to %s\n", events.size(), filename.c_str());
+    }
+    return written;
+}
+
+#endif
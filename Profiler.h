@@ -0,0 +1,98 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// \desc frame profiler collecting named CPU zones from every thread and GPU pass timings into
+/// per-thread ring buffers, exported as Chrome trace JSON (chrome://tracing, Perfetto) or CSV.
+/// only compiled in when FP_ENABLE_PROFILER is defined, otherwise every call is an empty
+/// inline function and the zone macros expand to nothing
+class Profiler {
+public:
+    /// \desc one recorded zone
+    struct Event {
+        /// \desc zone name, must be a string literal or otherwise outlive the profiler
+        const char* name;
+        /// \desc start of the zone in nanoseconds since the profiler started
+        uint64_t startNs;
+        uint64_t durationNs;
+        /// \desc frame the zone was recorded in
+        uint32_t frame;
+        /// \desc id of the recording thread, GPU_THREAD_ID for GPU passes
+        uint32_t threadId;
+    };
+
+    /// \desc thread id given to GPU pass timings so they show up on their own track
+    static constexpr uint32_t GPU_THREAD_ID = 0xFFFF;
+    /// \desc events kept per thread before the oldest are overwritten
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+#ifdef FP_ENABLE_PROFILER
+    /// \desc nanoseconds since the profiler started
+    static uint64_t now();
+    /// \desc marks the start of a new frame, events are tagged with the current frame
+    static void beginFrame();
+    /// \desc names the calling thread in exported traces
+    static void setThreadName(const char* name);
+    /// \desc records a CPU zone of the calling thread
+    static void recordZone(const char* name, uint64_t startNs, uint64_t endNs);
+    /// \desc records a GPU pass timing on the GPU track
+    /// \param frame frame the pass was submitted in
+    static void recordGpuZone(const char* name, uint32_t frame, uint64_t startNs, uint64_t durationNs);
+    /// \desc frame the events are currently tagged with
+    static uint32_t getFrame();
+
+    /// \desc writes every buffered event as Chrome trace JSON
+    /// \returns true if the file was written
+    static bool exportChromeTrace(const std::string& filename);
+    /// \desc writes every buffered event as CSV, one zone per line
+    /// \returns true if the file was written
+    static bool exportCsv(const std::string& filename);
+#else
+    static uint64_t now() { return 0; }
+    static void beginFrame() {}
+    static void setThreadName(const char*) {}
+    static void recordZone(const char*, uint64_t, uint64_t) {}
+    static void recordGpuZone(const char*, uint32_t, uint64_t, uint64_t) {}
+    static uint32_t getFrame() { return 0; }
+    static bool exportChromeTrace(const std::string&) { return false; }
+    static bool exportCsv(const std::string&) { return false; }
+#endif
+
+    /// \desc exports as CSV if the filename ends in .csv and as Chrome trace JSON otherwise
+    static bool exportTrace(const std::string& filename) {
+        const bool csv = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0;
+        return csv ? exportCsv(filename) : exportChromeTrace(filename);
+    }
+};
+
+#ifdef FP_ENABLE_PROFILER
+
+/// \desc records the wall clock time of its scope as a CPU zone
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : _name(name), _startNs(Profiler::now()) {}
+    ~ProfileZone() { Profiler::recordZone(_name, _startNs, Profiler::now()); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* _name;
+    uint64_t _startNs;
+};
+
+#define FP_PROFILE_CONCAT_INNER(a, b) a##b
+#define FP_PROFILE_CONCAT(a, b) FP_PROFILE_CONCAT_INNER(a, b)
+/// \desc profiles the rest of the enclosing scope under a name
+#define FP_PROFILE_ZONE(name) ProfileZone FP_PROFILE_CONCAT(_profileZone, __LINE__)(name)
+
+#else
+
+#define FP_PROFILE_ZONE(name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#include "QualityGovernor.h"
+
+#include <algorithm>
+#include <cstdio>
+
+const QualitySettings QualityGovernor::LEVELS[NUM_LEVELS] = {
+    // scale, particles, sphere detail, point lights
+    // full quality trims nothing, only the degraded levels cap the lights
+    { 1.0f,  100, 8, QualitySettings::ALL_POINT_LIGHTS },
+    { 0.85f, 60,  6, 8 },
+    { 0.7f,  30,  6, 4 },
+    { 0.5f,  15,  4, 1 }
+};
+
+QualityGovernor::QualityGovernor(double targetFrameRate)
+    : _targetMs(1000.0 / targetFrameRate),
+      _level(0),
+      _smoothedMs(-1.0),
+      _framesOver(0),
+      _framesUnder(0),
+      _cooldown(0) {
+    fprintf(stdout, "[INFO]: quality governor holding %.1f fps (%.2f ms)\n", targetFrameRate, _targetMs);
+}
+
+bool QualityGovernor::update(double cpuMs, double gpuMs) {
+    const double frameMs = std::max(cpuMs, gpuMs);
+    _smoothedMs = _smoothedMs < 0.0 ? frameMs : _smoothedMs + SMOOTHING * (frameMs - _smoothedMs);
+
+    if(_cooldown > 0) {
+        _cooldown--;
+        return false;
+    }
+
+    _framesOver = _smoothedMs > _targetMs * OVER_BUDGET ? _framesOver + 1 : 0;
+    _framesUnder = _smoothedMs < _targetMs * UNDER_BUDGET ? _framesUnder + 1 : 0;
+
+    if(_framesOver >= FRAMES_TO_DROP && _level < NUM_LEVELS - 1) {
+        _setLevel(_level + 1, cpuMs, gpuMs);
+        return true;
+    }
+    if(_framesUnder >= FRAMES_TO_RAISE && _level > 0) {
+        _setLevel(_level - 1, cpuMs, gpuMs);
+        return true;
+    }
+    return false;
+}
+
+void QualityGovernor::_setLevel(int level, double cpuMs, double gpuMs) {
+    const QualitySettings& settings = LEVELS[level];
+    char pointLights[16] = "all";
+    if(settings.maxPointLights != QualitySettings::ALL_POINT_LIGHTS) {
+        snprintf(pointLights, sizeof(pointLights), "%u", settings.maxPointLights);
+    }
+    fprintf(stdout, "[INFO]: quality governor: level %d -> %d, smoothed frame %.2f ms (cpu %.2f ms, gpu %.2f ms, target %.2f ms): "
+                    "render scale %.2f, particles %u, pellet spheres %dx%d, point lights per cell %s\n",
+            _level, level, _smoothedMs, cpuMs, gpuMs, _targetMs,
+            settings.renderScale, settings.maxParticles, settings.pelletSphereDetail, settings.pelletSphereDetail, pointLights);
+    _level = level;
+    _framesOver = 0;
+    _framesUnder = 0;
+    _cooldown = COOLDOWN_FRAMES;
+    // the old level's times no longer say anything about the new one
+    _smoothedMs = -1.0;
+}
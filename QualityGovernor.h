@@ -0,0 +1,75 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+/// \desc render cost knobs of one quality level
+struct QualitySettings {
+    /// \desc fraction of the framebuffer size the scene is drawn at before it is upscaled
+    float renderScale;
+    /// \desc most explosion particles drawn per frame
+    unsigned int maxParticles;
+    /// \desc stacks and slices of the pellet spheres
+    int pelletSphereDetail;
+    /// \desc most clustered point lights shaded per light grid cell, the flashlight comes on top
+    unsigned int maxPointLights;
+
+    /// \desc maxPointLights that keeps every light the light grid assigned to a cell
+    static constexpr unsigned int ALL_POINT_LIGHTS = ~0u;
+};
+
+/// \desc holds a target frame rate by stepping through a ladder of quality levels.  the
+/// bottleneck of every frame, the larger of the CPU and GPU frame time, is smoothed; the level
+/// drops quickly once the smoothed time runs over budget and rises slowly once it sits well
+/// under it, so it does not flip back and forth around the target.  every change is logged.
+/// owns no GL state
+class QualityGovernor {
+public:
+    /// \param targetFrameRate frames per second to hold
+    explicit QualityGovernor(double targetFrameRate);
+
+    /// \desc feeds the timings of a finished frame and changes the level if needed
+    /// \param cpuMs time the CPU spent on the frame, without pacing waits and the swap
+    /// \param gpuMs time the GPU spent on the frame, negative if not known yet
+    /// \returns true if the level changed
+    bool update(double cpuMs, double gpuMs);
+
+    /// \desc knobs of the current level
+    const QualitySettings& getSettings() const { return LEVELS[_level]; }
+    /// \desc current level, 0 is the highest quality
+    int getLevel() const { return _level; }
+    /// \desc smoothed bottleneck frame time in milliseconds
+    double getSmoothedFrameMs() const { return _smoothedMs; }
+
+    /// \desc knobs of the highest quality level, used when no governor runs
+    static const QualitySettings& getFullQuality() { return LEVELS[0]; }
+
+private:
+    /// \desc moves to a level and logs what changed
+    void _setLevel(int level, double cpuMs, double gpuMs);
+
+    double _targetMs;
+    int _level;
+    double _smoothedMs;
+    /// \desc consecutive frames over or well under budget
+    unsigned int _framesOver;
+    unsigned int _framesUnder;
+    /// \desc frames left before the level may change again
+    unsigned int _cooldown;
+
+    static constexpr int NUM_LEVELS = 4;
+    static const QualitySettings LEVELS[NUM_LEVELS];
+
+    /// \desc weight of the newest frame in the smoothed frame time
+    static constexpr double SMOOTHING = 0.1;
+    /// \desc the level drops once the smoothed time exceeds the budget by this factor ...
+    static constexpr double OVER_BUDGET = 1.05;
+    /// \desc ... for this many frames in a row
+    static constexpr unsigned int FRAMES_TO_DROP = 20;
+    /// \desc the level rises once the smoothed time stays below this fraction of the budget ...
+    static constexpr double UNDER_BUDGET = 0.7;
+    /// \desc ... for this many frames in a row
+    static constexpr unsigned int FRAMES_TO_RAISE = 180;
+    /// \desc frames after a change before the next one, lets the new level settle
+    static constexpr unsigned int COOLDOWN_FRAMES = 60;
+};
+
+#endif
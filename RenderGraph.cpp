@@ -0,0 +1,209 @@
+#include "RenderGraph.h"
+
+#include "GLStats.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+RenderGraph::RenderGraph()
+    : _numPasses(0),
+      _numCulled(0) {
+    _numCreated[0] = _numCreated[1] = 0;
+}
+
+RenderGraph::~RenderGraph() {
+    for(PooledTarget& pooled : _pool) {
+        delete pooled.target;
+    }
+}
+
+//*************************************************************************************
+//
+// Declaration
+
+RenderGraph::Resource RenderGraph::importTarget(const char* name, GLint width, GLint height, std::function<void()> bind) {
+    const Resource resource = (Resource)_resources.size();
+    _resources.push_back({ name, resource, NO_RESOURCE, width, height, false, true, false, std::move(bind), nullptr, NO_RESOURCE, 0, resource });
+    return resource;
+}
+
+RenderGraph::Resource RenderGraph::createTarget(const char* name, GLint width, GLint height, bool sampledColor) {
+    const Resource resource = (Resource)_resources.size();
+    _resources.push_back({ name, resource, NO_RESOURCE, width, height, sampledColor, false, false, nullptr, nullptr, NO_RESOURCE, 0, resource });
+    return resource;
+}
+
+void RenderGraph::markOutput(Resource resource) {
+    _resources[resource].output = true;
+}
+
+RenderGraph::Resource RenderGraph::addPass(const char* name, std::initializer_list<Resource> reads, Resource target, GLuint flags, std::function<void()> execute) {
+    Resource write = NO_RESOURCE;
+    if(target != NO_RESOURCE) {
+        // only the name and the links matter for a later version, the rest stays with the root
+        const ResourceNode& root = _resources[_resources[target].root];
+        write = (Resource)_resources.size();
+        _resources.push_back({ root.name, root.root, target, root.width, root.height, root.sampledColor, root.imported, false, nullptr, nullptr, NO_RESOURCE, 0, NO_RESOURCE });
+    }
+    _passes.push_back({ name, std::vector<Resource>(reads), write, flags, std::move(execute), false });
+    return write;
+}
+
+//*************************************************************************************
+//
+// Execution
+
+void RenderGraph::execute(GpuProfiler& gpuProfiler) {
+    _cull();
+    _allocate();
+
+    for(PassNode& pass : _passes) {
+        if(!pass.live) continue;
+
+        // a version drawn over by a live pass is gone, reading it means the declarations are wrong
+        for(Resource read : pass.reads) {
+            if(_resources[_resources[read].root].current != read) {
+                fprintf(stderr, "[WARN]: render graph pass \"%s\" reads \"%s\" after it was drawn over\n", pass.name, _resources[read].name);
+            }
+        }
+
+        if(pass.write != NO_RESOURCE) {
+            const ResourceNode& version = _resources[pass.write];
+            ResourceNode& resource = _resources[version.root];
+            if(!(pass.flags & COVERS_TARGET) && resource.current != version.previous) {
+                fprintf(stderr, "[WARN]: render graph pass \"%s\" draws over a stale version of \"%s\"\n", pass.name, resource.name);
+            }
+            if(resource.imported) {
+                resource.bind();
+            } else {
+                resource.target->bind();
+            }
+            glViewport(0, 0, resource.width, resource.height);
+            // transients hold whatever the pass they were aliased from left behind
+            if(resource.current == version.root && !(pass.flags & COVERS_TARGET)) {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            }
+            resource.current = pass.write;
+        }
+
+        FP_PROFILE_ZONE(pass.name);
+        FP_PROFILE_GPU_ZONE(gpuProfiler, pass.name);
+        pass.execute();
+    }
+
+    // every pass has run, no transient refers to a pooled target any more
+    _pool.erase(std::remove_if(_pool.begin(), _pool.end(), [](const PooledTarget& pooled) {
+        if(pooled.idleFrames <= POOL_RETIRE_FRAMES) return false;
+        delete pooled.target;
+        return true;
+    }), _pool.end());
+
+    _numPasses = (GLuint)_passes.size();
+    _resources.clear();
+    _passes.clear();
+}
+
+void RenderGraph::_cull() {
+    _needed.assign(_resources.size(), false);
+    for(Resource i = 0; i < _resources.size(); i++) {
+        _needed[i] = _resources[i].output;
+    }
+
+    // back to front, a pass is needed if a later needed pass or an output consumes its version
+    _numCulled = 0;
+    for(size_t i = _passes.size(); i-- > 0;) {
+        PassNode& pass = _passes[i];
+        pass.live = (pass.flags & SIDE_EFFECTS) || (pass.write != NO_RESOURCE && _needed[pass.write]);
+        if(!pass.live) {
+            _numCulled++;
+            continue;
+        }
+        // drawing over a version keeps what it holds, unless every pixel is replaced
+        if(pass.write != NO_RESOURCE && !(pass.flags & COVERS_TARGET)) {
+            _needed[_resources[pass.write].previous] = true;
+        }
+        for(Resource read : pass.reads) {
+            _needed[read] = true;
+        }
+    }
+}
+
+void RenderGraph::_allocate() {
+    for(GLuint i = 0; i < _passes.size(); i++) {
+        const PassNode& pass = _passes[i];
+        if(!pass.live) continue;
+        const auto use = [this, i](Resource resource) {
+            ResourceNode& node = _resources[_resources[resource].root];
+            if(node.firstUse == NO_RESOURCE) node.firstUse = i;
+            node.lastUse = i;
+        };
+        for(Resource read : pass.reads) use(read);
+        if(pass.write != NO_RESOURCE) use(pass.write);
+    }
+
+    for(PooledTarget& pooled : _pool) {
+        pooled.inUse = false;
+        pooled.idleFrames++;
+    }
+    _numCreated[0] = _numCreated[1] = 0;
+    // a target is free again once the last pass using its transient is done, so transients
+    // whose lifetimes do not overlap share one target
+    for(GLuint i = 0; i < _passes.size(); i++) {
+        if(!_passes[i].live) continue;
+        for(Resource r = 0; r < _resources.size(); r++) {
+            ResourceNode& resource = _resources[r];
+            if(resource.root == r && !resource.imported && resource.firstUse == i) {
+                resource.target = _acquire(resource);
+            }
+        }
+        for(Resource r = 0; r < _resources.size(); r++) {
+            ResourceNode& resource = _resources[r];
+            if(resource.root == r && !resource.imported && resource.firstUse != NO_RESOURCE && resource.lastUse == i) {
+                _release(resource.target);
+            }
+        }
+    }
+
+    // every transient has its target now, so one nothing took this frame is not needed by a
+    // later pass.  a new target most likely replaces such a one left over from before a
+    // resize, drop it rather than hold both until it retires
+    _pool.erase(std::remove_if(_pool.begin(), _pool.end(), [this](const PooledTarget& pooled) {
+        GLuint& numCreated = _numCreated[pooled.sampledColor];
+        if(pooled.idleFrames == 0 || numCreated == 0) return false;
+        numCreated--;
+        delete pooled.target;
+        return true;
+    }), _pool.end());
+}
+
+OffscreenTarget* RenderGraph::_acquire(const ResourceNode& resource) {
+    for(PooledTarget& pooled : _pool) {
+        if(!pooled.inUse && pooled.sampledColor == resource.sampledColor &&
+           pooled.target->getWidth() == resource.width && pooled.target->getHeight() == resource.height) {
+            pooled.inUse = true;
+            pooled.idleFrames = 0;
+            return pooled.target;
+        }
+    }
+
+    OffscreenTarget* target = new OffscreenTarget(resource.width, resource.height, resource.sampledColor);
+    // creating a color texture changes the 2D binding behind GLStats' back
+    GLStats::invalidateState();
+    if(!target->isComplete()) {
+        fprintf(stderr, "[ERROR]: could not create the %dx%d target \"%s\"\n", resource.width, resource.height, resource.name);
+    }
+
+    _numCreated[resource.sampledColor]++;
+    _pool.push_back({ target, resource.sampledColor, true, 0 });
+    return target;
+}
+
+void RenderGraph::_release(const OffscreenTarget* target) {
+    for(PooledTarget& pooled : _pool) {
+        if(pooled.target == target) {
+            pooled.inUse = false;
+            return;
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <glad/gl.h>
+
+#include "GpuProfiler.h"
+#include "OffscreenTarget.h"
+
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+/// \desc declares the passes of a frame with the framebuffers they read and draw into, then
+/// runs them in order.  every pass drawing into a framebuffer produces a new version of it, and
+/// later passes and the outputs name the version they consume.  effects are declared every
+/// frame and switched on by consuming their version, passes whose version nothing consumes are
+/// culled before anything is bound, so a disabled effect costs nothing.  framebuffers that only
+/// live within the frame are taken from a pool of offscreen targets, and one whose last reader
+/// has run is handed to the next pass asking for the same size.  the graph binds and sizes the
+/// viewport of each pass's target, clears it on its first write, and times every pass on the
+/// CPU and the GPU profiler.  declarations are rebuilt every frame.  requires a current GL
+/// context
+class RenderGraph {
+public:
+    /// \desc a version of a framebuffer declared this frame
+    typedef GLuint Resource;
+    /// \desc written by passes that draw nothing, like read backs
+    static constexpr Resource NO_RESOURCE = ~0u;
+
+    enum PassFlags {
+        /// \desc the pass replaces every pixel of its target, which is then neither cleared nor
+        /// loaded from the version it is drawn over
+        COVERS_TARGET = 1,
+        /// \desc the pass matters outside the graph and is never culled
+        SIDE_EFFECTS = 2
+    };
+
+    RenderGraph();
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    /// \desc declares a framebuffer owned outside the graph, like the back buffer
+    /// \param name name the framebuffer is reported by, must outlive the graph
+    /// \param bind binds the framebuffer for drawing and reading
+    Resource importTarget(const char* name, GLint width, GLint height, std::function<void()> bind);
+    /// \desc declares a color and depth framebuffer that only lives during this frame
+    /// \param sampledColor the color is read as a texture by a later pass
+    Resource createTarget(const char* name, GLint width, GLint height, bool sampledColor);
+    /// \desc marks a version as consumed after the frame, the passes drawing it are kept
+    void markOutput(Resource resource);
+
+    /// \desc declares a pass, passes run in the order they are added.  a live pass must read
+    /// and draw over the latest live version of a framebuffer, a warning is printed otherwise
+    /// \param name pass name, must outlive the graph and the profilers
+    /// \param reads versions the pass samples or copies from
+    /// \param target version the pass draws over, NO_RESOURCE if it draws nothing
+    /// \param flags PassFlags
+    /// \param execute issues the pass's work with its target bound
+    /// \returns the version of target holding what the pass drew, NO_RESOURCE without a target
+    Resource addPass(const char* name, std::initializer_list<Resource> reads, Resource target, GLuint flags, std::function<void()> execute);
+
+    /// \desc culls the passes, assigns pooled targets, runs what is left and clears the
+    /// declarations for the next frame
+    void execute(GpuProfiler& gpuProfiler);
+
+    /// \desc target backing any version of a framebuffer created with createTarget(), only
+    /// valid inside the passes using it
+    OffscreenTarget* getTarget(Resource resource) const { return _resources[_resources[resource].root].target; }
+
+    /// \desc passes declared in the last frame
+    GLuint getNumPasses() const { return _numPasses; }
+    /// \desc passes of the last frame culled because no output needed them
+    GLuint getNumCulled() const { return _numCulled; }
+    /// \desc offscreen targets held by the pool
+    GLuint getNumPooledTargets() const { return (GLuint)_pool.size(); }
+
+private:
+    /// \desc frames a pooled target may go unused before it is deleted
+    static constexpr GLuint POOL_RETIRE_FRAMES = 120;
+
+    /// \desc one version of a framebuffer, the physical state lives in the first version
+    struct ResourceNode {
+        const char* name;
+        /// \desc first version of the framebuffer
+        Resource root;
+        /// \desc version the pass producing this one drew over, NO_RESOURCE for the first
+        Resource previous;
+        GLint width;
+        GLint height;
+        bool sampledColor;
+        bool imported;
+        bool output;
+        std::function<void()> bind;
+        /// \desc pooled target of a transient, assigned by _allocate()
+        OffscreenTarget* target;
+        /// \desc first and last live pass touching the framebuffer
+        GLuint firstUse;
+        GLuint lastUse;
+        /// \desc latest version a live pass drew this frame, checked while executing
+        Resource current;
+    };
+    struct PassNode {
+        const char* name;
+        std::vector<Resource> reads;
+        /// \desc version the pass produces
+        Resource write;
+        GLuint flags;
+        std::function<void()> execute;
+        bool live;
+    };
+    struct PooledTarget {
+        OffscreenTarget* target;
+        bool sampledColor;
+        bool inUse;
+        GLuint idleFrames;
+    };
+
+    /// \desc walks the passes back from the outputs and marks the ones contributing
+    void _cull();
+    /// \desc hands pooled targets to the transients, reusing one as soon as its last pass ran
+    void _allocate();
+    /// \desc a free pooled target matching the transient, created if there is none
+    OffscreenTarget* _acquire(const ResourceNode& resource);
+    void _release(const OffscreenTarget* target);
+
+    std::vector<ResourceNode> _resources;
+    std::vector<PassNode> _passes;
+    std::vector<PooledTarget> _pool;
+    /// \desc versions needed by the passes after the one being culled
+    std::vector<bool> _needed;
+    /// \desc targets _allocate() created this frame, without and with a sampled color
+    GLuint _numCreated[2];
+    GLuint _numPasses;
+    GLuint _numCulled;
+};
+
+#endif
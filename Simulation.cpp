@@ -0,0 +1,380 @@
+#include "Simulation.h"
+
+#include "CollisionDetector.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "StageTimer.h"
+#include "World.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+//*************************************************************************************
+//
+// Public Interface
+
+Simulation::Simulation(JobSystem* jobSystem)
+    : _jobSystem(jobSystem),
+      _logging(true),
+      _worldSizeX(0.0f),
+      _worldSizeY(0.0f),
+      _tick(0),
+      _direction(0.0f),
+      _pos(3, 3),
+      _previousPos(3, 3),
+      _lastValidPosition(3, 3),
+      _lastDir(0),
+      _playerRadius(0.5f),
+      _currentHeight(0.5f),
+      _respawns(0),
+      _flashlightBright(false),
+      _hitTimer(0),
+      _isExploding(false),
+      _ghostFreezeTimer(0.0f),
+      _numLives(MAX_LIVES),
+      _ghostSpeed(INITIAL_GHOST_SPEED),
+      _stageTicks(0) {
+    for(double& stageTime : _stageTimeMs) stageTime = 0.0;
+}
+
+void Simulation::loadWorld(const std::vector<std::vector<int>>& world) {
+    // Clear any existing collision objects
+    CollisionDetector::clearCollisionObjects();
+    _world = world;
+    _worldSizeX = _world[0].size();
+    _worldSizeY = _world.size();
+
+    _points.clear();
+    _ghosts.clear();
+    _cars.clear();
+
+    for(int i = 0; i < _worldSizeX; i++){
+        for(int j=0; j < _worldSizeY; j++){
+            if(_world[i][j]==1){
+                CollisionDetector::addCollisionObject(glm::vec3(i*3, 0, j*3),2.1, false);
+            }
+            else if(_world[i][j]==0){
+                _points.push_back({glm::vec2(i*3, j*3), false});
+            }
+            else if(_world[i][j]==2){
+                Ghost ghost = {glm::vec2(i,j),glm::vec2(i,j),glm::vec2(i,j), glm::vec2(i,j), glm::vec2(i,j), _ghostSpeed, 1, false};
+                _ghosts.emplace_back(ghost);
+            }
+            else if(_world[i][j]==3){
+                _cars.push_back({glm::vec2(i*3, j*3), false});
+            }
+        }
+    }
+}
+
+void Simulation::tick(const Input& input, float deltaTime) {
+    FP_PROFILE_ZONE("tick");
+    _tick++;
+    _direction = input.direction;
+    _flashlightBright = input.forward;
+
+    _previousPos = _pos;
+    for(Ghost& ghost : _ghosts) {
+        ghost.previous_pos = ghost.current_pos;
+    }
+
+    if(++_stageTicks >= STAGE_REPORT_INTERVAL) {
+        _reportStageTimings();
+    }
+
+    if(_hitTimer>0){
+        _hitTimer = std::max(_hitTimer - deltaTime, 0.0f);
+    }
+    // Handle ghost collision explosion
+    if(_numLives<=0 && !_isExploding) {
+        _isExploding = true;
+        _particleSystem.spawn(glm::vec3(_pos.x,
+                                        _currentHeight,
+                                        _pos.y));
+        return;
+    }
+
+    // Handle explosion animation and reset
+    if(_isExploding) {
+        {
+            FP_PROFILE_ZONE("particles");
+            ScopedStageTimer timer(_stageTimeMs[STAGE_PARTICLES]);
+            _particleSystem.update(deltaTime, _jobSystem);
+        }
+
+        if(!_particleSystem.isAlive()) {
+            // Reset everything after explosion
+            _isExploding = false;
+            _pos = glm::vec2(SPAWN_POSITION.x, SPAWN_POSITION.z);
+            _previousPos = _pos;
+            _direction = 0.0f;
+            _respawns++;
+            _currentHeight = SPAWN_POSITION.y;
+            _numLives = MAX_LIVES;
+            _generatePoints();
+        }
+        return;
+    }
+
+    if(_pos.x > _worldSizeX*3-3.1){
+        _pos.x = _worldSizeX*3-3;
+    }
+    if(_pos.y > _worldSizeY*3-3.1){
+        _pos.y = _worldSizeY*3-3;
+    }
+    if(_pos.x < 0){
+        _pos.x = 0;
+    }
+    if(_pos.y < 0){
+        _pos.y = 0;
+    }
+    //get player position in grid
+    glm::vec2 player_aligned_pos = glm::vec2(std::round(_pos.x/3.0f), std::round(_pos.y/3.0f));
+    // move ghosts, every ghost only reads the maze and writes itself
+    if (_ghostFreezeTimer <= 0) {
+        FP_PROFILE_ZONE("ghosts");
+        ScopedStageTimer timer(_stageTimeMs[STAGE_GHOSTS]);
+        const float ghostStep = _ghostSpeed * deltaTime;
+        _jobSystem->parallelFor(0, _ghosts.size(), GHOST_GRAIN_SIZE, [this, &player_aligned_pos, ghostStep](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++) {
+                Ghost& ghost = _ghosts[i];
+                if (!ghost.is_moving) {
+                    ghost.start_pos = ghost.current_pos;
+                    ghost.target_pos = findBestMove(_world, ghost.current_pos, player_aligned_pos);
+
+                    // Only start moving if target is different
+                    if (ghost.target_pos != ghost.start_pos) {
+                        ghost.is_moving = true;
+                        ghost.progress = 0.0f;
+                    }
+                }
+                // Update movement progress
+                if (ghost.is_moving) {
+                    ghost.progress += ghostStep;
+
+                    // Interpolate position
+                    ghost.current_pos = glm::mix(ghost.start_pos, ghost.target_pos, glm::clamp(ghost.progress, 0.0f, 1.0f));
+
+                    // Check if movement is complete
+                    if (ghost.progress >= 1.0f) {
+                        ghost.current_pos = ghost.target_pos;
+                        ghost.is_moving = false;
+                    }
+                }
+            }
+        });
+    }
+    //check collisions with ghosts
+    for(Ghost& ghost : _ghosts){
+        float distance = glm::distance(_pos,glm::vec2(ghost.current_pos.x*3, ghost.current_pos.y*3));
+        if(distance<1.2){
+            _numLives-=1;
+            ghost.current_pos=ghost.spawn_pos;
+            ghost.start_pos=ghost.spawn_pos;
+            ghost.target_pos = ghost.spawn_pos;
+            ghost.previous_pos = ghost.spawn_pos;
+
+            if(_logging) fprintf(stdout,"You have been hit by a ghost, %d lives remaining\n",_numLives);
+            _hitTimer = HIT_EFFECT_DURATION;
+        }
+    }
+
+    if(_numLives<=0 && _logging){
+        fprintf(stdout,"You have lost all of your lives, you lose.\n");
+    }
+    // Check collisions with points
+    {
+        FP_PROFILE_ZONE("pellets");
+        ScopedStageTimer timer(_stageTimeMs[STAGE_PELLETS]);
+        const glm::vec2 playerPos = _pos;
+        _jobSystem->parallelFor(0, _points.size(), PELLET_GRAIN_SIZE, [this, playerPos](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++) {
+                float distance = glm::distance(playerPos, _points[i].position);
+                if(distance<1){
+                    _points[i].toBeDeleted = true;
+                }
+            }
+        });
+
+        // delete points that have been collected
+        _points.erase(
+                std::remove_if(_points.begin(), _points.end(),
+                               [](const PointsData& point) { return point.toBeDeleted; }),
+                _points.end()
+        );
+    }
+
+    //check to see if all points have been collected
+    if(_points.size()==0){
+        if(_logging) fprintf(stdout,"You have collected all of the points, congratulations!");
+        _generatePoints();
+        _ghostSpeed += GHOST_SPEED_INCREMENT;
+    }
+
+    const float speed = PLAYER_SPEED * deltaTime;
+    const glm::vec2 forward = glm::vec2(glm::sin(_direction), glm::cos(_direction));
+    const glm::vec2 leftward = glm::vec2(glm::sin(_direction + M_PI/2), glm::cos(_direction + M_PI/2));
+    const glm::vec2 rightward = glm::vec2(glm::sin(_direction - M_PI/2), glm::cos(_direction - M_PI/2));
+
+    if(input.forward) {
+        _tryMove(forward * speed);
+    }
+    if(input.backward) {
+        _tryMove(-forward * speed);
+    }
+    //strafe when A or D pressed
+    if(input.left) {
+        _tryMove(leftward * speed);
+    }
+    if(input.right) {
+        _tryMove(rightward * speed);
+    }
+
+    // Add car collection logic
+    for(CarData& carData : _cars) {
+        if(!carData.collected) {
+            float distance = glm::distance(_pos, carData.position);
+            if(distance < 2.0f) {  // Adjust collision radius as needed
+                carData.collected = true;
+                _ghostFreezeTimer = GHOST_FREEZE_DURATION;  // Start freeze timer
+                if(_logging) fprintf(stdout, "Ghosts frozen for 10 seconds!\n");
+            }
+        }
+    }
+
+    if (_ghostFreezeTimer > 0) {
+        _ghostFreezeTimer -= deltaTime;
+        if (_ghostFreezeTimer <= 0) {
+            _ghostFreezeTimer = 0;
+            if(_logging) fprintf(stdout, "Ghosts unfrozen!\n");
+        }
+    }
+}
+
+void Simulation::writeSnapshot(RenderSnapshot& snapshot) const {
+    snapshot.tick = _tick;
+    snapshot.playerPosition = _pos;
+    snapshot.previousPlayerPosition = _previousPos;
+    snapshot.playerDirection = _direction;
+    snapshot.respawns = _respawns;
+    snapshot.hitTimer = _hitTimer;
+    snapshot.isExploding = _isExploding;
+
+    // Update point light position to be in front of and above the plane
+    glm::vec3 planePos = glm::vec3(_pos.x+1.5, 0, _pos.y+3);
+    glm::vec3 lightOffset = glm::vec3(
+        -3.0f * glm::sin(_direction), // 3 units in front
+        2.0f,                                          // 2 units above
+        -3.0f * glm::cos(_direction)  // 3 units in front
+    );
+    snapshot.pointLightPosition = planePos + lightOffset;
+
+    // Make light brighter when moving forward
+    if(_flashlightBright) {
+        snapshot.pointLightColor = glm::vec3(0.4f, 0.4f, 0.4f); // Brighter white when moving
+    } else {
+        snapshot.pointLightColor = glm::vec3(0.2f, 0.2f, 0.2f); // Dimmer white when stationary
+    }
+
+    snapshot.ghostPositions.resize(_ghosts.size());
+    snapshot.previousGhostPositions.resize(_ghosts.size());
+    for(size_t i = 0; i < _ghosts.size(); i++) {
+        snapshot.ghostPositions[i] = _ghosts[i].current_pos;
+        snapshot.previousGhostPositions[i] = _ghosts[i].previous_pos;
+    }
+
+    snapshot.pointPositions.resize(_points.size());
+    for(size_t i = 0; i < _points.size(); i++) {
+        snapshot.pointPositions[i] = _points[i].position;
+    }
+
+    snapshot.carCollected.resize(_cars.size());
+    for(size_t i = 0; i < _cars.size(); i++) {
+        snapshot.carCollected[i] = _cars[i].collected ? 1 : 0;
+    }
+
+    if(_isExploding) {
+        snapshot.particles = _particleSystem.getParticles();
+    } else {
+        snapshot.particles.clear();
+    }
+}
+
+//*************************************************************************************
+//
+// Private Helper Functions
+
+void Simulation::_generatePoints() {
+    _points.clear();
+    for(int i=0;i<_worldSizeX;i++){
+        for(int j=0;j<_worldSizeY;j++){
+            if(_world[i][j]==0) {
+                _points.push_back({glm::vec2(i*3, j*3), false});
+            }
+        }
+    }
+}
+
+void Simulation::_tryMove(const glm::vec2& step) {
+    // Calculate new position
+    glm::vec2 newPos = _pos + step;
+
+    // Check for collisions
+    if(!_checkCollisions(newPos)) {
+        // No collision, update position
+        _pos = newPos;
+        _lastValidPosition = newPos;
+        _lastDir = 0;
+        return;
+    }
+
+    // Collision detected, slide along the wall we hit
+    CollisionObject* col = CollisionDetector::getCollidedObject(newPos);
+    bool x = false;
+    bool z = false;
+    if(_lastValidPosition.x > col->position.x + col->radius){
+        z = true;
+    }else if(_lastValidPosition.x < col->position.x - col->radius){
+        z = true;
+    }
+
+    if(_lastValidPosition.y > col->position.z + col->radius){
+        x = true;
+    }else if(_lastValidPosition.y < col->position.z - col->radius){
+        x = true;
+    }
+
+    if(x && (_lastDir == 0 || _lastDir == 1)){
+        _pos.x += step.x;
+        _lastDir = 1;
+    }
+    if(z && (_lastDir == 0 || _lastDir == 2)){
+        _pos.y += step.y;
+        _lastDir = 2;
+    }
+    if(_checkCollisions(_pos)){
+        _pos = _lastValidPosition;
+        _lastDir = 0;
+    }else{
+        _lastValidPosition = _pos;
+    }
+}
+
+bool Simulation::_checkCollisions(const glm::vec2& newPosition) const {
+    return CollisionDetector::checkCollision(newPosition, _playerRadius);
+}
+
+void Simulation::_reportStageTimings() {
+    static const char* STAGE_NAMES[NUM_STAGES] = { "ghosts", "pellets", "particles" };
+
+    if(_logging) {
+        fprintf(stdout, "[INFO]: average simulation stage timings over %u ticks:", _stageTicks);
+        for(unsigned int i = 0; i < NUM_STAGES; i++) {
+            fprintf(stdout, " %s %.3fms", STAGE_NAMES[i], _stageTimeMs[i] / _stageTicks);
+        }
+        fprintf(stdout, "\n");
+    }
+    for(double& stageTime : _stageTimeMs) stageTime = 0.0;
+    _stageTicks = 0;
+}
@@ -0,0 +1,183 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "ParticleSystem.h"
+
+class JobSystem;
+
+/// \desc immutable copy of one simulation tick holding everything the renderer needs to draw it
+struct RenderSnapshot {
+    /// \desc simulation tick this snapshot was taken after
+    unsigned long long tick = 0;
+    /// \desc length of one simulation tick in seconds
+    float tickSeconds = 0.0f;
+    /// \desc wall clock time in seconds at which the simulated time caught up with this tick.
+    /// the renderer blends from the previous tick to this one over the following tickSeconds
+    double tickTime = 0.0;
+
+    /// \desc player position on the ground plane in world units
+    glm::vec2 playerPosition;
+    /// \desc player position one tick earlier, for interpolation
+    glm::vec2 previousPlayerPosition;
+    /// \desc direction the simulation last moved the player along
+    float playerDirection = 0.0f;
+    /// \desc counts how often the player respawned, the renderer resets the camera when it changes
+    unsigned int respawns = 0;
+
+    /// \desc seconds left on the glitch effect after being hit by a ghost
+    float hitTimer = 0.0f;
+    /// \desc true while the death explosion plays
+    bool isExploding = false;
+
+    /// \desc flashlight that follows the player
+    glm::vec3 pointLightPosition;
+    glm::vec3 pointLightColor;
+
+    /// \desc ghost positions in maze grid coordinates
+    std::vector<glm::vec2> ghostPositions;
+    /// \desc ghost positions one tick earlier, index aligned with ghostPositions
+    std::vector<glm::vec2> previousGhostPositions;
+    /// \desc positions of the pellets not yet collected in world units
+    std::vector<glm::vec2> pointPositions;
+    /// \desc non-zero for every car that has been collected, index aligned with Simulation cars
+    std::vector<unsigned char> carCollected;
+    /// \desc explosion particles, empty unless isExploding
+    std::vector<Particle> particles;
+};
+
+/// \desc game logic of the maze: player movement, ghost AI, pickups and the death explosion.
+/// owns no GL state so that it can tick on any thread
+class Simulation {
+public:
+    /// \desc player controls sampled for one tick
+    struct Input {
+        bool forward = false;
+        bool backward = false;
+        bool left = false;
+        bool right = false;
+        /// \desc heading of the player in radians
+        float direction = 0.0f;
+    };
+
+    /// \param jobSystem thread pool to fan the ghost, pellet and particle stages out to
+    explicit Simulation(JobSystem* jobSystem);
+
+    /// \desc places ghosts, pellets, cars and wall colliders for a maze
+    /// \param world maze cells, 0 for points, 1 for walls, 2 for ghosts and 3 for cars
+    void loadWorld(const std::vector<std::vector<int>>& world);
+
+    /// \desc advances the game by one fixed length tick
+    /// \param input player controls for this tick
+    /// \param deltaTime length of the tick in seconds
+    void tick(const Input& input, float deltaTime);
+
+    /// \desc copies the current state into a snapshot, reusing its storage
+    void writeSnapshot(RenderSnapshot& snapshot) const;
+
+    /// \desc number of cars placed by loadWorld, index aligned with RenderSnapshot::carCollected
+    size_t getNumCars() const { return _cars.size(); }
+
+    /// \desc enables the gameplay messages and stage timing reports printed to stdout
+    void setLogging(bool enabled) { _logging = enabled; }
+
+private:
+    struct PointsData {
+        glm::vec2 position;
+        bool toBeDeleted;
+    };
+
+    struct Ghost {
+        glm::vec2 current_pos;     // Current interpolated position
+        glm::vec2 target_pos;      // Next target point
+        glm::vec2 start_pos;
+        glm::vec2 spawn_pos;
+        glm::vec2 previous_pos;    // Position at the start of the last tick
+        float movement_speed;      // Units per second
+        float progress;            // Movement progress [0, 1]
+        bool is_moving;
+    };
+
+    struct CarData {
+        glm::vec2 position;
+        bool collected;
+    };
+
+    /// \desc spawns a pellet on every empty cell of the maze
+    void _generatePoints();
+    /// \desc moves the player by a step, sliding along walls on collision
+    void _tryMove(const glm::vec2& step);
+    bool _checkCollisions(const glm::vec2& newPosition) const;
+
+    /// \desc prints the average time of every stage and resets the accumulators
+    void _reportStageTimings();
+
+    JobSystem* _jobSystem;
+    bool _logging;
+
+    std::vector<std::vector<int>> _world;
+    float _worldSizeX;
+    float _worldSizeY;
+
+    std::vector<PointsData> _points;
+    std::vector<Ghost> _ghosts;
+    std::vector<CarData> _cars;
+    ParticleSystem _particleSystem;
+
+    unsigned long long _tick;
+    float _direction;
+    glm::vec2 _pos;
+    glm::vec2 _previousPos;
+    glm::vec2 _lastValidPosition;
+    //0: normal
+    //1: collided moving x
+    //2: collided moving z
+    float _lastDir;
+    float _playerRadius;
+    float _currentHeight;
+    unsigned int _respawns;
+    bool _flashlightBright;
+
+    float _hitTimer;
+    bool _isExploding;
+    float _ghostFreezeTimer;
+
+    int _numLives;
+    float _ghostSpeed;
+
+    static constexpr int MAX_LIVES = 5;
+    /// \desc ghost speed at the first level in grid cells per second
+    static constexpr float INITIAL_GHOST_SPEED = 0.75f;
+    /// \desc ghost speed added every time the maze is cleared in grid cells per second
+    static constexpr float GHOST_SPEED_INCREMENT = 0.3f;
+    /// \desc player walking speed in world units per second
+    static constexpr float PLAYER_SPEED = 9.0f;
+    /// \desc length of the glitch effect after being hit in seconds
+    static constexpr float HIT_EFFECT_DURATION = 2.0f;
+    const float GHOST_FREEZE_DURATION = 10.0f;  // 10 seconds
+    const glm::vec3 SPAWN_POSITION = glm::vec3(3.0f, 0.5f, 3.0f);
+
+    /// \desc ghosts handed to a single job, path finding is the most expensive per item work
+    static constexpr size_t GHOST_GRAIN_SIZE = 16;
+    /// \desc pellets handed to a single job when checking for pickups
+    static constexpr size_t PELLET_GRAIN_SIZE = 1024;
+
+    /// \desc simulation stages that run on the job system and are timed every tick
+    enum STAGE_ID {
+        STAGE_GHOSTS = 0,
+        STAGE_PELLETS = 1,
+        STAGE_PARTICLES = 2,
+        NUM_STAGES = 3
+    };
+    /// \desc milliseconds spent in each stage since the last report
+    double _stageTimeMs[NUM_STAGES];
+    /// \desc number of ticks accumulated in _stageTimeMs
+    unsigned int _stageTicks;
+    /// \desc number of ticks between two stage timing reports
+    static constexpr unsigned int STAGE_REPORT_INTERVAL = 300;
+};
+
+#endif
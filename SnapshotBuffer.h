@@ -0,0 +1,56 @@
+#ifndef SNAPSHOT_BUFFER_H
+#define SNAPSHOT_BUFFER_H
+
+#include <atomic>
+
+/// \desc hands immutable snapshots from one producer thread to one consumer thread without locks.
+/// the producer fills its back buffer and publishes it, the consumer reads its front buffer.  a
+/// third hand-off slot sits between them so that neither side ever waits for the other: publishing
+/// swaps the back buffer into the hand-off slot, acquiring swaps a freshly published hand-off slot
+/// into the front buffer.  slot contents are reused, so containers inside T keep their capacity
+template<typename T>
+class SnapshotBuffer {
+public:
+    SnapshotBuffer() : _handOff(HAND_OFF_INITIAL), _backIndex(BACK_INITIAL), _frontIndex(FRONT_INITIAL) {}
+    SnapshotBuffer(const SnapshotBuffer&) = delete;
+    SnapshotBuffer& operator=(const SnapshotBuffer&) = delete;
+
+    /// \desc producer only: the buffer to fill with the next snapshot
+    T& getBackBuffer() { return _slots[_backIndex]; }
+
+    /// \desc producer only: makes the back buffer visible to the consumer and starts a new one
+    void publish() {
+        unsigned int previous = _handOff.exchange(_backIndex | FRESH_BIT, std::memory_order_acq_rel);
+        _backIndex = previous & INDEX_MASK;
+    }
+
+    /// \desc consumer only: the most recently published snapshot.  the reference stays valid
+    /// and unchanged until the next call to acquire()
+    const T& acquire() {
+        if(_handOff.load(std::memory_order_relaxed) & FRESH_BIT) {
+            unsigned int previous = _handOff.exchange(_frontIndex, std::memory_order_acq_rel);
+            _frontIndex = previous & INDEX_MASK;
+        }
+        return _slots[_frontIndex];
+    }
+
+    /// \desc consumer only: true if a snapshot newer than the current front buffer is waiting
+    bool hasFresh() const { return (_handOff.load(std::memory_order_relaxed) & FRESH_BIT) != 0; }
+
+private:
+    static constexpr unsigned int INDEX_MASK = 0x3;
+    static constexpr unsigned int FRESH_BIT = 0x4;
+    static constexpr unsigned int FRONT_INITIAL = 0;
+    static constexpr unsigned int HAND_OFF_INITIAL = 1;
+    static constexpr unsigned int BACK_INITIAL = 2;
+
+    T _slots[3];
+    /// \desc index of the hand-off slot plus FRESH_BIT while it holds an unread snapshot
+    std::atomic<unsigned int> _handOff;
+    /// \desc slot owned by the producer
+    unsigned int _backIndex;
+    /// \desc slot owned by the consumer
+    unsigned int _frontIndex;
+};
+
+#endif
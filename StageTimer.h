@@ -0,0 +1,22 @@
+#ifndef STAGE_TIMER_H
+#define STAGE_TIMER_H
+
+#include <chrono>
+
+/// \desc adds the wall clock time of its scope to an accumulator in milliseconds
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(double& accumulatorMs) : _accumulatorMs(accumulatorMs), _start(std::chrono::steady_clock::now()) {}
+    ~ScopedStageTimer() {
+        _accumulatorMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    double& _accumulatorMs;
+    std::chrono::steady_clock::time_point _start;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "StatsHud.h"
+
+#include "GLStats.h"
+
+#include <algorithm>
+#include <cstddef>
+
+//*************************************************************************************
+//
+// Font
+
+/// \desc one glyph of the built-in font, one byte per row with the leftmost pixel in bit 4
+struct FontGlyph {
+    char character;
+    unsigned char rows[7];
+};
+
+static const FontGlyph FONT_GLYPHS[] = {
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { 'A', { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 } },
+    { 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+    { 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+    { 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+    { 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+    { 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+    { 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+    { 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+    { 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+    { 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+    { 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+    { 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+    { 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+    { 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+    { 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+    { 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+    { 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+    { 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+    { 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+    { 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+    { ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+    { '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+    { ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+    { '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+    { '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+    { '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+    { '+', { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+    { '=', { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 } },
+    { '_', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F } },
+    { '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+    { ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } }
+};
+
+//*************************************************************************************
+//
+// Public Interface
+
+StatsHud::StatsHud()
+    : _visible(false) {
+    _shader = new CSCI441::ShaderProgram("shaders/hud.v.glsl", "shaders/hud.f.glsl");
+    _screenSizeUniformLocation = _shader->getUniformLocation("screenSize");
+    _shader->setProgramUniform(_shader->getUniformLocation("glyphAtlas"), 0);
+
+    _bakeAtlas();
+
+    glGenVertexArrays(1, &_vao);
+    glBindVertexArray(_vao);
+    glGenBuffers(1, &_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, u));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, r));
+    glEnableVertexAttribArray(2);
+    GLStats::invalidateState();
+}
+
+StatsHud::~StatsHud() {
+    delete _shader;
+    glDeleteTextures(1, &_atlasTexture);
+    glDeleteBuffers(1, &_vbo);
+    glDeleteVertexArrays(1, &_vao);
+}
+
+void StatsHud::draw(const std::vector<std::string>& lines, GLint framebufferWidth, GLint framebufferHeight) {
+    if(!_visible || lines.empty()) return;
+
+    static const GLubyte PANEL_COLOR[4] = { 0, 0, 0, 160 };
+    static const GLubyte TEXT_COLOR[4] = { 255, 255, 255, 255 };
+    const GLfloat advanceX = CELL_WIDTH * PIXEL_SCALE;
+    const GLfloat advanceY = CELL_HEIGHT * PIXEL_SCALE;
+
+    size_t longestLine = 0;
+    size_t numChars = 0;
+    for(const std::string& line : lines) {
+        longestLine = std::max(longestLine, line.size());
+        numChars += line.size();
+    }
+
+    _vertices.clear();
+    _vertices.reserve((numChars + 1) * 6);
+
+    // background panel from the fully covered atlas cell, sampled at its center
+    const GLfloat solidU = ((SOLID_CHAR - FIRST_CHAR) % ATLAS_COLUMNS + 0.5f) * CELL_WIDTH / (ATLAS_COLUMNS * CELL_WIDTH);
+    const GLfloat solidV = ((SOLID_CHAR - FIRST_CHAR) / ATLAS_COLUMNS + 0.5f) * CELL_HEIGHT / (ATLAS_ROWS * CELL_HEIGHT);
+    _appendQuad(0.0f, 0.0f, longestLine * advanceX + 2.0f * PANEL_MARGIN, lines.size() * advanceY + 2.0f * PANEL_MARGIN,
+                solidU, solidV, solidU, solidV, PANEL_COLOR);
+
+    GLfloat y = PANEL_MARGIN;
+    for(const std::string& line : lines) {
+        GLfloat x = PANEL_MARGIN;
+        for(char c : line) {
+            _appendGlyph(c, x, y, TEXT_COLOR);
+            x += advanceX;
+        }
+        y += advanceY;
+    }
+
+    GLStats::useProgram(_shader->getShaderProgramHandle());
+    GLStats::setProgramUniform(_shader, _screenSizeUniformLocation, glm::vec2((GLfloat)framebufferWidth, (GLfloat)framebufferHeight));
+    GLStats::activeTexture(GL_TEXTURE0);
+    GLStats::bindTexture(GL_TEXTURE_2D, _atlasTexture);
+    GLStats::bindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    GLStats::bufferData(GL_ARRAY_BUFFER, _vertices.size() * sizeof(Vertex), _vertices.data(), GL_STREAM_DRAW);
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLStats::drawArrays(GL_TRIANGLES, 0, (GLsizei)_vertices.size());
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+//*************************************************************************************
+//
+// Private Helper Functions
+
+void StatsHud::_bakeAtlas() {
+    const GLint atlasWidth = ATLAS_COLUMNS * CELL_WIDTH;
+    const GLint atlasHeight = ATLAS_ROWS * CELL_HEIGHT;
+    std::vector<GLubyte> pixels(atlasWidth * atlasHeight, 0);
+
+    auto bakeGlyph = [&pixels, atlasWidth](char c, const unsigned char rows[GLYPH_HEIGHT]) {
+        const GLint cell = c - FIRST_CHAR;
+        const GLint cellX = (cell % ATLAS_COLUMNS) * CELL_WIDTH;
+        const GLint cellY = (cell / ATLAS_COLUMNS) * CELL_HEIGHT;
+        for(GLint row = 0; row < GLYPH_HEIGHT; row++) {
+            for(GLint column = 0; column < GLYPH_WIDTH; column++) {
+                if(rows[row] & (1 << (GLYPH_WIDTH - 1 - column))) {
+                    pixels[(cellY + row) * atlasWidth + cellX + column] = 255;
+                }
+            }
+        }
+    };
+    for(const FontGlyph& glyph : FONT_GLYPHS) {
+        bakeGlyph(glyph.character, glyph.rows);
+        // lower case shares the upper case shapes
+        if(glyph.character >= 'A' && glyph.character <= 'Z') {
+            bakeGlyph((char)(glyph.character - 'A' + 'a'), glyph.rows);
+        }
+    }
+    // the panel cell is covered edge to edge so it can be sampled anywhere
+    const GLint solidCell = SOLID_CHAR - FIRST_CHAR;
+    for(GLint row = 0; row < CELL_HEIGHT; row++) {
+        for(GLint column = 0; column < CELL_WIDTH; column++) {
+            pixels[((solidCell / ATLAS_COLUMNS) * CELL_HEIGHT + row) * atlasWidth + (solidCell % ATLAS_COLUMNS) * CELL_WIDTH + column] = 255;
+        }
+    }
+
+    glGenTextures(1, &_atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void StatsHud::_appendQuad(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLfloat u0, GLfloat v0, GLfloat u1, GLfloat v1, const GLubyte color[4]) {
+    const Vertex topLeft     = { x0, y0, u0, v0, color[0], color[1], color[2], color[3] };
+    const Vertex topRight    = { x1, y0, u1, v0, color[0], color[1], color[2], color[3] };
+    const Vertex bottomLeft  = { x0, y1, u0, v1, color[0], color[1], color[2], color[3] };
+    const Vertex bottomRight = { x1, y1, u1, v1, color[0], color[1], color[2], color[3] };
+    _vertices.push_back(topLeft);
+    _vertices.push_back(bottomLeft);
+    _vertices.push_back(topRight);
+    _vertices.push_back(topRight);
+    _vertices.push_back(bottomLeft);
+    _vertices.push_back(bottomRight);
+}
+
+void StatsHud::_appendGlyph(char c, GLfloat x, GLfloat y, const GLubyte color[4]) {
+    if(c <= FIRST_CHAR || c >= SOLID_CHAR) return;
+
+    const GLint cell = c - FIRST_CHAR;
+    const GLfloat atlasWidth = (GLfloat)(ATLAS_COLUMNS * CELL_WIDTH);
+    const GLfloat atlasHeight = (GLfloat)(ATLAS_ROWS * CELL_HEIGHT);
+    const GLfloat u0 = (cell % ATLAS_COLUMNS) * CELL_WIDTH / atlasWidth;
+    const GLfloat v0 = (cell / ATLAS_COLUMNS) * CELL_HEIGHT / atlasHeight;
+    const GLfloat u1 = u0 + GLYPH_WIDTH / atlasWidth;
+    const GLfloat v1 = v0 + GLYPH_HEIGHT / atlasHeight;
+    _appendQuad(x, y, x + GLYPH_WIDTH * PIXEL_SCALE, y + GLYPH_HEIGHT * PIXEL_SCALE, u0, v0, u1, v1, color);
+}
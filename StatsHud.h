@@ -0,0 +1,73 @@
+#ifndef STATS_HUD_H
+#define STATS_HUD_H
+
+#include <glad/gl.h>
+
+#include <CSCI441/ShaderProgram.hpp>
+
+#include <string>
+#include <vector>
+
+/// \desc on-screen text overlay for frame statistics.  a built-in 5x7 bitmap font is baked
+/// into a single channel glyph atlas once, every frame all lines are batched into one vertex
+/// buffer and drawn with a single draw call.  requires a current GL context
+class StatsHud {
+public:
+    StatsHud();
+    ~StatsHud();
+
+    StatsHud(const StatsHud&) = delete;
+    StatsHud& operator=(const StatsHud&) = delete;
+
+    void setVisible(bool visible) { _visible = visible; }
+    bool isVisible() const { return _visible; }
+    void toggle() { _visible = !_visible; }
+
+    /// \desc draws lines of text on a dark panel in the top left corner, if visible
+    /// \param lines text to draw, lower case letters are drawn as upper case
+    /// \param framebufferWidth width of the framebuffer in pixels
+    /// \param framebufferHeight height of the framebuffer in pixels
+    void draw(const std::vector<std::string>& lines, GLint framebufferWidth, GLint framebufferHeight);
+
+private:
+    struct Vertex {
+        GLfloat x, y;
+        GLfloat u, v;
+        GLubyte r, g, b, a;
+    };
+
+    /// \desc rasterizes the font into the atlas texture
+    void _bakeAtlas();
+    /// \desc appends the two triangles of a screen space rectangle
+    void _appendQuad(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLfloat u0, GLfloat v0, GLfloat u1, GLfloat v1, const GLubyte color[4]);
+    /// \desc appends the quad of a single character
+    void _appendGlyph(char c, GLfloat x, GLfloat y, const GLubyte color[4]);
+
+    bool _visible;
+    CSCI441::ShaderProgram* _shader;
+    GLint _screenSizeUniformLocation;
+    GLuint _atlasTexture;
+    GLuint _vao;
+    GLuint _vbo;
+    /// \desc vertices of the current frame, kept to reuse the allocation
+    std::vector<Vertex> _vertices;
+
+    /// \desc size of a glyph in font pixels
+    static constexpr GLint GLYPH_WIDTH = 5;
+    static constexpr GLint GLYPH_HEIGHT = 7;
+    /// \desc size of a glyph cell in the atlas including one pixel of spacing
+    static constexpr GLint CELL_WIDTH = 6;
+    static constexpr GLint CELL_HEIGHT = 8;
+    /// \desc the atlas holds printable ASCII in a 16 by 6 grid
+    static constexpr GLint ATLAS_COLUMNS = 16;
+    static constexpr GLint ATLAS_ROWS = 6;
+    static constexpr char FIRST_CHAR = ' ';
+    /// \desc the DEL cell is baked fully covered and used for the background panel
+    static constexpr char SOLID_CHAR = 127;
+    /// \desc screen pixels per font pixel
+    static constexpr GLfloat PIXEL_SCALE = 2.0f;
+    /// \desc margin around the text in screen pixels
+    static constexpr GLfloat PANEL_MARGIN = 6.0f;
+};
+
+#endif
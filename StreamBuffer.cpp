@@ -0,0 +1,101 @@
+#include "StreamBuffer.h"
+
+#include <cstdio>
+
+StreamBuffer::StreamBuffer(GLenum target, GLsizeiptr regionSize)
+    : _target(target),
+      _regionSize(regionSize),
+      _uniformAlignment(1),
+      _region(NUM_REGIONS - 1),
+      _used(0),
+      _numWaits(0),
+      _numOverflows(0) {
+    for(GLsync& fence : _fences) fence = nullptr;
+
+    if(_target == GL_UNIFORM_BUFFER) {
+        GLint alignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        _uniformAlignment = alignment;
+        // every region has to start on a boundary a block can be bound at
+        _regionSize = (_regionSize + _uniformAlignment - 1) / _uniformAlignment * _uniformAlignment;
+    }
+
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(_target, _buffer);
+    glBufferData(_target, _regionSize * NUM_REGIONS, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(_target, 0);
+}
+
+StreamBuffer::~StreamBuffer() {
+    for(GLsync fence : _fences) {
+        if(fence) glDeleteSync(fence);
+    }
+    glDeleteBuffers(1, &_buffer);
+
+    if(_numWaits > 0 || _numOverflows > 0) {
+        fprintf(stdout, "[INFO]: stream buffer waited on the GPU %u times, %u allocations overflowed\n", _numWaits, _numOverflows);
+    }
+}
+
+void StreamBuffer::beginFrame() {
+    _region = (_region + 1) % NUM_REGIONS;
+    _used = 0;
+
+    GLsync& fence = _fences[_region];
+    if(!fence) return;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if(status == GL_TIMEOUT_EXPIRED) {
+        // the GPU is NUM_REGIONS frames behind, the only case the CPU waits
+        _numWaits++;
+        while(status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+    }
+    if(status == GL_WAIT_FAILED) {
+        fprintf(stderr, "[ERROR]: waiting for a stream buffer region failed\n");
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+    // nothing written, nothing the next user of the region has to wait for
+    if(_used == 0) return;
+    _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* StreamBuffer::map(GLsizeiptr bytes, GLsizeiptr alignment, GLintptr& offset) {
+    const GLsizeiptr start = (_used + alignment - 1) / alignment * alignment;
+    if(start + bytes > _regionSize) {
+        _numOverflows++;
+        return nullptr;
+    }
+    _used = start + bytes;
+    offset = _region * _regionSize + start;
+
+    glBindBuffer(_target, _buffer);
+    // the fence checked in beginFrame() proves the GPU is done with this range
+    void* data = glMapBufferRange(_target, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if(!data) {
+        fprintf(stderr, "[ERROR]: could not map %ld bytes of the stream buffer\n", (long)bytes);
+        glBindBuffer(_target, 0);
+    }
+    return data;
+}
+
+void StreamBuffer::unmap() {
+    glUnmapBuffer(_target);
+    glBindBuffer(_target, 0);
+}
+
+void* StreamBuffer::mapUniformBlock(GLsizeiptr bytes, GLintptr& offset) {
+    if(_target != GL_UNIFORM_BUFFER) {
+        fprintf(stderr, "[ERROR]: uniform blocks can only be streamed through a GL_UNIFORM_BUFFER ring\n");
+        return nullptr;
+    }
+    return map(bytes, _uniformAlignment, offset);
+}
+
+void StreamBuffer::bindUniformBlock(GLuint binding, GLintptr offset, GLsizeiptr bytes) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, _buffer, offset, bytes);
+}
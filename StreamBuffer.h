@@ -0,0 +1,67 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/gl.h>
+
+/// \desc one buffer split into a ring of per-frame regions that instance and uniform data is
+/// streamed through.  each frame writes only its own region, and the region is fenced once
+/// the frame's draws are submitted.  a region is reused NUM_REGIONS frames later, after its
+/// fence has signalled, so writes are mapped with GL_MAP_UNSYNCHRONIZED_BIT and the driver
+/// never has to stall on or shadow the buffer.  GL 4.1 has no persistent mapping, so every
+/// allocation maps its own range.  requires a current GL context
+class StreamBuffer {
+public:
+    /// \desc regions in the ring, frames the CPU may run ahead of the GPU
+    static constexpr GLuint NUM_REGIONS = 3;
+
+    /// \param target binding point the buffer is mapped through, GL_ARRAY_BUFFER for instance
+    /// data or GL_UNIFORM_BUFFER for uniform blocks
+    /// \param regionSize bytes one frame may allocate
+    StreamBuffer(GLenum target, GLsizeiptr regionSize);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    /// \desc moves on to the next region, waiting only if the GPU still reads it
+    void beginFrame();
+    /// \desc fences this frame's region, call after the last draw reading from it
+    void endFrame();
+
+    /// \desc reserves bytes in this frame's region and maps them for writing, the buffer stays
+    /// bound to the target until unmap()
+    /// \param alignment offset alignment, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform blocks
+    /// \param offset receives the offset of the allocation in the buffer
+    /// \returns memory to write the data to, null if the region has no room left or the
+    /// mapping failed, unmap() must not be called then
+    void* map(GLsizeiptr bytes, GLsizeiptr alignment, GLintptr& offset);
+    /// \desc ends the writes of the last map()
+    void unmap();
+
+    /// \desc map() for a uniform block, aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT so the
+    /// allocation can be bound with bindUniformBlock().  only for GL_UNIFORM_BUFFER rings
+    void* mapUniformBlock(GLsizeiptr bytes, GLintptr& offset);
+    /// \desc binds an allocation of this frame to a uniform block binding point
+    void bindUniformBlock(GLuint binding, GLintptr offset, GLsizeiptr bytes) const;
+
+    GLuint getBuffer() const { return _buffer; }
+    /// \desc frames whose region was still in use by the GPU when they began
+    GLuint getNumWaits() const { return _numWaits; }
+    /// \desc allocations that did not fit into their frame's region
+    GLuint getNumOverflows() const { return _numOverflows; }
+
+private:
+    GLenum _target;
+    GLsizeiptr _regionSize;
+    /// \desc GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, 1 for other targets
+    GLsizeiptr _uniformAlignment;
+    GLuint _buffer;
+    GLsync _fences[NUM_REGIONS];
+    GLuint _region;
+    /// \desc bytes of the current region already handed out
+    GLsizeiptr _used;
+    GLuint _numWaits;
+    GLuint _numOverflows;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "World.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+//*************************************************************************************
+//
+// CSV World Files
+
+std::vector<std::vector<int>> read_csv(const std::string& filename) {
+    std::vector<std::vector<int>> data;
+    std::ifstream file(filename);
+    std::string line;
+
+    if (!file.is_open()) {
+        std::cerr << "Could not open the file" << std::endl;
+        return data;
+    }
+
+    while (std::getline(file, line)) {
+        std::vector<int> row;
+        std::stringstream ss(line);
+        std::string cell;
+
+        while (std::getline(ss, cell, ',')) {
+            row.push_back(std::stoi(cell));
+        }
+
+        data.push_back(row);
+    }
+
+    file.close();
+    return data;
+}
+
+bool write_csv(const std::string& filename, const std::vector<std::vector<int>>& world) {
+    FILE* file = fopen(filename.c_str(), "w");
+    if(!file) {
+        fprintf(stderr, "[ERROR]: could not open \"%s\" for writing\n", filename.c_str());
+        return false;
+    }
+    // format a whole row at once, a call per cell is far too slow for large mazes
+    std::string line;
+    for(const std::vector<int>& row : world) {
+        line.clear();
+        for(size_t j = 0; j < row.size(); j++) {
+            if(j > 0) line += ',';
+            if(row[j] >= 0 && row[j] <= 9) line += (char)('0' + row[j]);
+            else line += std::to_string(row[j]);
+        }
+        line += '\n';
+        fwrite(line.data(), 1, line.size(), file);
+    }
+    return fclose(file) == 0;
+}
+
+//*************************************************************************************
+//
+// Binary World Files
+
+static const char WORLD_BINARY_MAGIC[4] = { 'F', 'P', 'W', 'B' };
+static const unsigned int WORLD_BINARY_VERSION = 1;
+
+static void writeUint32(FILE* file, unsigned int value) {
+    const unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8),
+                                     (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+    fwrite(bytes, 1, 4, file);
+}
+
+static bool readUint32(FILE* file, unsigned int& value) {
+    unsigned char bytes[4];
+    if(fread(bytes, 1, 4, file) != 4) return false;
+    value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+    return true;
+}
+
+bool write_world_binary(const std::string& filename, const std::vector<std::vector<int>>& world) {
+    FILE* file = fopen(filename.c_str(), "wb");
+    if(!file) {
+        fprintf(stderr, "[ERROR]: could not open \"%s\" for writing\n", filename.c_str());
+        return false;
+    }
+    const unsigned int rows = (unsigned int)world.size();
+    const unsigned int cols = rows > 0 ? (unsigned int)world[0].size() : 0;
+    fwrite(WORLD_BINARY_MAGIC, 1, sizeof(WORLD_BINARY_MAGIC), file);
+    writeUint32(file, WORLD_BINARY_VERSION);
+    writeUint32(file, rows);
+    writeUint32(file, cols);
+
+    std::vector<unsigned char> line(cols);
+    for(const std::vector<int>& row : world) {
+        for(unsigned int j = 0; j < cols; j++) line[j] = (unsigned char)row[j];
+        fwrite(line.data(), 1, cols, file);
+    }
+    return fclose(file) == 0;
+}
+
+std::vector<std::vector<int>> read_world(const std::string& filename) {
+    std::vector<std::vector<int>> data;
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(!file) {
+        fprintf(stderr, "[ERROR]: could not open world \"%s\"\n", filename.c_str());
+        return data;
+    }
+
+    char magic[sizeof(WORLD_BINARY_MAGIC)];
+    if(fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, WORLD_BINARY_MAGIC, sizeof(magic)) != 0) {
+        fclose(file);
+        return read_csv(filename);
+    }
+
+    unsigned int version = 0, rows = 0, cols = 0;
+    if(!readUint32(file, version) || !readUint32(file, rows) || !readUint32(file, cols) || version != WORLD_BINARY_VERSION) {
+        fprintf(stderr, "[ERROR]: \"%s\" has an unsupported binary world header\n", filename.c_str());
+        fclose(file);
+        return data;
+    }
+
+    data.resize(rows);
+    std::vector<unsigned char> line(cols);
+    for(unsigned int i = 0; i < rows; i++) {
+        if(fread(line.data(), 1, cols, file) != cols) {
+            fprintf(stderr, "[ERROR]: \"%s\" ends after %u of %u rows\n", filename.c_str(), i, rows);
+            data.clear();
+            break;
+        }
+        data[i].assign(line.begin(), line.end());
+    }
+    fclose(file);
+    return data;
+}
+
+//*************************************************************************************
+//
+// Ghost Movement
+
+std::vector<glm::vec2> getPossibleMoves(const std::vector<std::vector<int>>& world_matrix, const glm::vec2 current_pos) {
+    // Potential adjacent moves (right, left, down, up)
+    std::vector<glm::vec2> possible_moves = {
+            current_pos + glm::vec2(1, 0),   // right
+            current_pos + glm::vec2(-1, 0),  // left
+            current_pos + glm::vec2(0, 1),   // down
+            current_pos + glm::vec2(0, -1)   // up
+    };
+
+    std::vector<glm::vec2> actually_possible_moves;
+    // Filter out invalid moves
+    for(glm::vec2 move : possible_moves){
+        if(!(move.x<0 || move.y<0 || move.x>world_matrix[0].size()*3 || move.y>world_matrix.size()*3)&&world_matrix[move.x][move.y]!=1){
+            actually_possible_moves.emplace_back(move);
+        }
+    }
+
+    return actually_possible_moves;
+}
+
+glm::vec2 findBestMove(const std::vector<std::vector<int>>& world, glm::vec2 ghost_pos, glm::vec2 player_pos) {
+    // Get possible moves
+    std::vector<glm::vec2> possible_moves = getPossibleMoves(world, ghost_pos);
+    // If no moves possible, stay in place
+    if (possible_moves.empty()) {
+        return ghost_pos;
+    }
+    glm::vec2 target;
+    float minimum = 1000000000;
+    for(glm::vec2 move : possible_moves){
+        float distance = glm::distance(move,player_pos);
+        if(distance<minimum){
+            minimum=distance;
+            target=move;
+        }
+    }
+    return target;
+}
@@ -0,0 +1,59 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/// \desc values of the cells in a world file
+enum WorldCell {
+    /// \desc empty floor holding a point to collect
+    CELL_POINT = 0,
+    /// \desc solid wall
+    CELL_WALL = 1,
+    /// \desc empty floor a ghost spawns on
+    CELL_GHOST = 2,
+    /// \desc empty floor a car spawns on
+    CELL_CAR = 3
+};
+
+/// \desc reads a maze from a comma separated file, one row per line
+/// \param filename path of the csv file
+/// \returns the maze cells, empty if the file could not be opened
+std::vector<std::vector<int>> read_csv(const std::string& filename);
+
+/// \desc writes a maze as a comma separated file, one row per line
+/// \param filename path of the csv file
+/// \param world maze cells
+/// \returns true if the file was written
+bool write_csv(const std::string& filename, const std::vector<std::vector<int>>& world);
+
+/// \desc writes a maze as a binary world file: the magic "FPWB", a little endian uint32
+/// version, uint32 row and column counts and then one byte per cell, row by row.  much
+/// smaller and faster to load than csv for large mazes
+/// \param filename path of the binary file
+/// \param world maze cells, every row the same length
+/// \returns true if the file was written
+bool write_world_binary(const std::string& filename, const std::vector<std::vector<int>>& world);
+
+/// \desc reads a maze from a binary world file or, if it does not start with the binary
+/// magic, from a csv file
+/// \param filename path of the world file
+/// \returns the maze cells, empty if the file could not be read
+std::vector<std::vector<int>> read_world(const std::string& filename);
+
+/// \desc lists the neighboring cells a ghost can step onto
+/// \param world maze cells
+/// \param current_pos cell the ghost stands on in grid coordinates
+/// \returns the open cells to the right, left, below and above
+std::vector<glm::vec2> getPossibleMoves(const std::vector<std::vector<int>>& world, glm::vec2 current_pos);
+
+/// \desc picks the neighboring cell that brings a ghost closest to the player
+/// \param world maze cells
+/// \param ghost_pos cell the ghost stands on in grid coordinates
+/// \param player_pos cell the player stands on in grid coordinates
+/// \returns the chosen cell, ghost_pos if the ghost is boxed in
+glm::vec2 findBestMove(const std::vector<std::vector<int>>& world, glm::vec2 ghost_pos, glm::vec2 player_pos);
+
+#endif
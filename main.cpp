@@ -15,13 +15,141 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <cstring>
+
+///*****************************************************************************
+//
+// Command line parsing
+
+/// \desc fills the engine options from the command line, printing usage on unknown arguments
+/// \returns false if the program should exit
+static bool parseOptions(int argc, char* argv[], EngineOptions& options) {
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            options.simulationTickRate = atof(argv[++i]);
+            if(options.simulationTickRate <= 0.0) {
+                fprintf(stderr, "[ERROR]: tick rate must be positive\n");
+                return false;
+            }
+        } else if(strcmp(argv[i], "--no-sim-thread") == 0) {
+            options.threadedSimulation = false;
+        } else if(strcmp(argv[i], "--world") == 0 && i + 1 < argc) {
+            options.worldFile = argv[++i];
+        } else if(strcmp(argv[i], "--maze") == 0 && i + 1 < argc) {
+            options.generateMaze = true;
+            options.mazeOptions.size = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--maze-seed") == 0 && i + 1 < argc) {
+            options.mazeOptions.seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        } else if(strcmp(argv[i], "--wall-density") == 0 && i + 1 < argc) {
+            options.mazeOptions.wallDensity = (float)atof(argv[++i]);
+        } else if(strcmp(argv[i], "--ghosts") == 0 && i + 1 < argc) {
+            options.mazeOptions.numGhosts = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--pickups") == 0 && i + 1 < argc) {
+            options.mazeOptions.numPickups = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            options.profileOutput = argv[++i];
+        } else if(strcmp(argv[i], "--hud") == 0) {
+            options.showStatsHud = true;
+        } else if(strcmp(argv[i], "--glitch-strength") == 0 && i + 1 < argc) {
+            options.hitGlitchStrength = (float)atof(argv[++i]);
+            if(options.hitGlitchStrength < 0.0f || options.hitGlitchStrength > 1.0f) {
+                fprintf(stderr, "[ERROR]: glitch strength must be between 0 and 1\n");
+                return false;
+            }
+        } else if(strcmp(argv[i], "--no-occlusion") == 0) {
+            options.occlusionCulling = false;
+        } else if(strcmp(argv[i], "--depth-prepass") == 0) {
+            options.depthPrepass = true;
+        } else if(strcmp(argv[i], "--no-lightmap") == 0) {
+            options.bakeLightmap = false;
+        } else if(strcmp(argv[i], "--lightmap-cache") == 0 && i + 1 < argc) {
+            options.lightmapCacheDirectory = argv[++i];
+        } else if(strcmp(argv[i], "--flythrough") == 0) {
+            options.flythrough = true;
+        } else if(strcmp(argv[i], "--flythrough-frames") == 0 && i + 1 < argc) {
+            options.flythrough = true;
+            options.flythroughFramesPerCell = (GLuint)strtoul(argv[++i], nullptr, 10);
+            if(options.flythroughFramesPerCell == 0) {
+                fprintf(stderr, "[ERROR]: flythrough frames per cell must be positive\n");
+                return false;
+            }
+        } else if(strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            options.headless = true;
+            options.headlessFrames = (GLuint)strtoul(argv[++i], nullptr, 10);
+        } else if(strcmp(argv[i], "--dump-frames") == 0 && i + 1 < argc) {
+            options.frameDumpPrefix = argv[++i];
+        } else if(strcmp(argv[i], "--dump-format") == 0 && i + 1 < argc) {
+            i++;
+            if(strcmp(argv[i], "png") == 0) {
+                options.frameDumpFormat = FrameCapture::PNG;
+            } else if(strcmp(argv[i], "raw") == 0) {
+                options.frameDumpFormat = FrameCapture::RAW;
+            } else {
+                fprintf(stderr, "[ERROR]: dump format must be png or raw\n");
+                return false;
+            }
+        } else if(strcmp(argv[i], "--dump-interval") == 0 && i + 1 < argc) {
+            options.frameDumpInterval = (GLuint)strtoul(argv[++i], nullptr, 10);
+            if(options.frameDumpInterval == 0) {
+                fprintf(stderr, "[ERROR]: dump interval must be positive\n");
+                return false;
+            }
+        } else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options.recordInputFile = argv[++i];
+        } else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.replayInputFile = argv[++i];
+        } else if(strcmp(argv[i], "--latency") == 0) {
+            options.measureLatency = true;
+        } else if(strcmp(argv[i], "--frame-mode") == 0 && i + 1 < argc) {
+            if(!FramePacer::parseMode(argv[++i], options.frameMode)) {
+                fprintf(stderr, "[ERROR]: frame mode must be vsync, cap or uncapped\n");
+                return false;
+            }
+        } else if(strcmp(argv[i], "--adaptive-quality") == 0 && i + 1 < argc) {
+            options.adaptiveQualityTarget = atof(argv[++i]);
+            if(options.adaptiveQualityTarget <= 0.0) {
+                fprintf(stderr, "[ERROR]: adaptive quality target must be positive\n");
+                return false;
+            }
+        } else if(strcmp(argv[i], "--fps-cap") == 0 && i + 1 < argc) {
+            options.frameMode = FramePacer::CAP;
+            options.frameRateCap = atof(argv[++i]);
+            if(options.frameRateCap <= 0.0) {
+                fprintf(stderr, "[ERROR]: frame rate cap must be positive\n");
+                return false;
+            }
+        } else {
+            fprintf(stderr, "usage: %s [--tick-rate <hz>] [--no-sim-thread] [--world <file>]\n"
+                            "          [--maze <size>] [--maze-seed <n>] [--wall-density <0-1>] [--ghosts <n>] [--pickups <n>]\n"
+                            "          [--profile <trace.json|trace.csv>] [--hud] [--no-lightmap] [--lightmap-cache <dir>] [--depth-prepass]\n"
+                            "          [--glitch-strength <0-1>] [--no-occlusion]\n"
+                            "          [--headless <frames>] [--dump-frames <prefix>] [--dump-interval <n>] [--dump-format <png|raw>]\n"
+                            "          [--flythrough] [--flythrough-frames <frames per cell>]\n"
+                            "          [--record <input log>] [--replay <input log>] [--latency]\n"
+                            "          [--frame-mode <vsync|cap|uncapped>] [--fps-cap <hz>] [--adaptive-quality <fps>]\n", argv[0]);
+            return false;
+        }
+    }
+    if(!options.recordInputFile.empty() && !options.replayInputFile.empty()) {
+        fprintf(stderr, "[ERROR]: cannot record and replay input at the same time\n");
+        return false;
+    }
+    return true;
+}
 
 ///*****************************************************************************
 //
 // Our main function
-int main() {
+int main(int argc, char* argv[]) {
+    EngineOptions options;
+    if(!parseOptions(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
 
-    auto labEngine = new FPEngine();
+    auto labEngine = new FPEngine(options);
     labEngine->initialize();
     if (labEngine->getError() == CSCI441::OpenGLEngine::OPENGL_ENGINE_ERROR_NO_ERROR) {
         labEngine->run();
@@ -0,0 +1,75 @@
+/*
+ *  File: mazegen.cpp
+ *
+ *  Description:
+ *      Command line front end of the maze generator.  Writes seeded mazes as
+ *      world.csv compatible text or as binary world files for stress and
+ *      scaling tests.
+ */
+
+#include "JobSystem.h"
+#include "MazeGenerator.h"
+#include "World.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void printUsage(const char* program) {
+    fprintf(stderr, "usage: %s [--size <cells>] [--seed <n>] [--wall-density <0-1>] [--ghosts <n>] [--pickups <n>]\n"
+                    "          [--threads <n>] [--binary] [--output <file>]\n"
+                    "  writes world.csv by default, --binary or an output name ending in .bin writes a binary world\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    MazeOptions maze;
+    std::string outputFile = "world.csv";
+    bool binary = false;
+    unsigned int numThreads = 0;
+
+    for(int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--size") == 0 && hasValue) maze.size = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--seed") == 0 && hasValue) maze.seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        else if(strcmp(argv[i], "--wall-density") == 0 && hasValue) maze.wallDensity = (float)atof(argv[++i]);
+        else if(strcmp(argv[i], "--ghosts") == 0 && hasValue) maze.numGhosts = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--pickups") == 0 && hasValue) maze.numPickups = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue) numThreads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--output") == 0 && hasValue) outputFile = argv[++i];
+        else if(strcmp(argv[i], "--binary") == 0) binary = true;
+        else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if(outputFile.size() > 4 && outputFile.compare(outputFile.size() - 4, 4, ".bin") == 0) {
+        binary = true;
+    }
+
+    JobSystem jobSystem(numThreads);
+    MazeGenerator generator(&jobSystem);
+
+    const auto generateStart = std::chrono::steady_clock::now();
+    const std::vector<std::vector<int>> world = generator.generate(maze);
+    const auto generateEnd = std::chrono::steady_clock::now();
+    if(world.empty()) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const bool written = binary ? write_world_binary(outputFile, world) : write_csv(outputFile, world);
+    const auto writeEnd = std::chrono::steady_clock::now();
+    if(!written) {
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "[INFO]: generated %dx%d maze (seed %u) in %.1fms on %u threads, wrote %s in %.1fms\n",
+            maze.size, maze.size, maze.seed,
+            std::chrono::duration<double, std::milli>(generateEnd - generateStart).count(),
+            jobSystem.getNumThreads(), outputFile.c_str(),
+            std::chrono::duration<double, std::milli>(writeEnd - generateEnd).count());
+    return EXIT_SUCCESS;
+}
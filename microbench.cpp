@@ -0,0 +1,381 @@
+/*
+ *  File: microbench.cpp
+ *
+ *  Description:
+ *      Micro benchmarks of the hot kernels of the game.  Every kernel is swept
+ *      across input sizes and the results are written as JSON so that two runs
+ *      can be diffed.  GL calls are replaced by no-op functions, no window or
+ *      context is created.
+ */
+
+#include "Billboard.h"
+#include "CollisionDetector.h"
+#include "JobSystem.h"
+#include "MazeGenerator.h"
+#include "ParticleSystem.h"
+#include "Plane.h"
+#include "World.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+//*************************************************************************************
+//
+// Benchmark Harness
+
+/// \desc results are added here so the compiler cannot drop the measured work
+static volatile float gSink = 0.0f;
+
+struct BenchOptions {
+    /// \desc only run benchmarks whose name contains this string
+    std::string filter;
+    /// \desc file to write the JSON results to, stdout when empty
+    std::string outputFile;
+    /// \desc minimum length of one timed sample in milliseconds
+    double minSampleMs = 20.0;
+    /// \desc number of timed samples per benchmark and size
+    int numSamples = 5;
+    /// \desc worker threads for the job system, 0 picks one per hardware thread
+    unsigned int numThreads = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    /// \desc input size the kernel was run with
+    size_t size;
+    /// \desc kernel calls per timed sample
+    size_t iterations;
+    /// \desc items processed by one kernel call, used for the throughput
+    size_t itemsPerCall;
+    double nsPerCallMedian;
+    double nsPerCallMin;
+    double nsPerCallMax;
+};
+
+/// \desc times one kernel: grows the iteration count until a sample takes at least the
+/// minimum sample time, then records numSamples samples of that length
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options) : _options(options) {}
+
+    /// \param name name of the kernel
+    /// \param size input size the kernel was set up with
+    /// \param itemsPerCall items processed by one call of the kernel
+    /// \param kernel runs the kernel the given number of times
+    void run(const std::string& name, size_t size, size_t itemsPerCall,
+             const std::function<void(size_t)>& kernel) {
+        if(!_options.filter.empty() && name.find(_options.filter) == std::string::npos) return;
+
+        size_t iterations = 1;
+        while(true) {
+            const double ms = _time(kernel, iterations);
+            if(ms >= _options.minSampleMs || iterations >= MAX_ITERATIONS) break;
+            const double scale = ms > 0.0 ? 1.2 * _options.minSampleMs / ms : 10.0;
+            iterations = std::min(MAX_ITERATIONS, std::max(iterations + 1, (size_t)(iterations * std::min(scale, 10.0))));
+        }
+
+        std::vector<double> samples;
+        for(int i = 0; i < _options.numSamples; i++) {
+            samples.push_back(_time(kernel, iterations) * 1.0e6 / iterations);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchResult result;
+        result.name = name;
+        result.size = size;
+        result.iterations = iterations;
+        result.itemsPerCall = itemsPerCall;
+        result.nsPerCallMedian = samples[samples.size() / 2];
+        result.nsPerCallMin = samples.front();
+        result.nsPerCallMax = samples.back();
+        _results.push_back(result);
+
+        fprintf(stderr, "[INFO]: %-24s size %8zu  %12.1f ns/call\n", name.c_str(), size, result.nsPerCallMedian);
+    }
+
+    /// \desc writes every result as one JSON document
+    void writeJson(FILE* file) const {
+        fprintf(file, "{\n  \"threads\": %u,\n  \"min_sample_ms\": %.1f,\n  \"samples\": %d,\n  \"benchmarks\": [\n",
+                _threads, _options.minSampleMs, _options.numSamples);
+        for(size_t i = 0; i < _results.size(); i++) {
+            const BenchResult& r = _results[i];
+            const double itemsPerSecond = r.nsPerCallMedian > 0.0 ? r.itemsPerCall * 1.0e9 / r.nsPerCallMedian : 0.0;
+            fprintf(file, "    {\"name\": \"%s\", \"size\": %zu, \"iterations\": %zu, "
+                          "\"ns_per_call_median\": %.3f, \"ns_per_call_min\": %.3f, \"ns_per_call_max\": %.3f, "
+                          "\"items_per_second\": %.1f}%s\n",
+                    r.name.c_str(), r.size, r.iterations, r.nsPerCallMedian, r.nsPerCallMin, r.nsPerCallMax,
+                    itemsPerSecond, i + 1 < _results.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+    }
+
+    void setThreads(unsigned int threads) { _threads = threads; }
+
+private:
+    static double _time(const std::function<void(size_t)>& kernel, size_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        kernel(iterations);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static constexpr size_t MAX_ITERATIONS = 100000000;
+
+    const BenchOptions& _options;
+    std::vector<BenchResult> _results;
+    unsigned int _threads = 0;
+};
+
+//*************************************************************************************
+//
+// GL Stubs
+
+static void GLAD_API_PTR stubProgramUniformMatrix4fv(GLuint, GLint, GLsizei, GLboolean, const GLfloat* value) {
+    gSink = gSink + value[0];
+}
+
+static void GLAD_API_PTR stubProgramUniformMatrix3fv(GLuint, GLint, GLsizei, GLboolean, const GLfloat* value) {
+    gSink = gSink + value[0];
+}
+
+//*************************************************************************************
+//
+// Kernels
+
+static const size_t MAZE_SIZES[] = { 16, 64, 256, 1024 };
+
+/// \desc the maze every kernel of a given size runs on
+static std::vector<std::vector<int>> benchMaze(size_t size) {
+    MazeOptions maze;
+    maze.size = (int)size;
+    return MazeGenerator().generate(maze);
+}
+
+/// \desc open cells of a maze in grid coordinates
+static std::vector<glm::vec2> openCells(const std::vector<std::vector<int>>& world) {
+    std::vector<glm::vec2> cells;
+    for(size_t i = 0; i < world.size(); i++) {
+        for(size_t j = 0; j < world[i].size(); j++) {
+            if(world[i][j] != CELL_WALL) cells.emplace_back((float)i, (float)j);
+        }
+    }
+    return cells;
+}
+
+static void benchReadCsv(BenchRunner& runner) {
+    for(size_t size : MAZE_SIZES) {
+        const std::string filename = "microbench_world_" + std::to_string(size) + ".csv";
+        if(!write_csv(filename, benchMaze(size))) continue;
+        runner.run("read_csv", size, size * size, [&filename](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                gSink = gSink + (float)read_csv(filename).size();
+            }
+        });
+        remove(filename.c_str());
+    }
+}
+
+static void benchMazeGenerator(BenchRunner& runner, JobSystem& jobSystem) {
+    static const size_t GENERATED_SIZES[] = { 64, 256, 1024, 4096 };
+
+    for(size_t size : GENERATED_SIZES) {
+        MazeOptions maze;
+        maze.size = (int)size;
+        maze.wallDensity = 0.8f;
+        runner.run("maze_generate", size, size * size, [&maze](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                gSink = gSink + (float)MazeGenerator().generate(maze).size();
+            }
+        });
+        runner.run("maze_generate_jobs", size, size * size, [&maze, &jobSystem](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                gSink = gSink + (float)MazeGenerator(&jobSystem).generate(maze).size();
+            }
+        });
+    }
+}
+
+static void benchCollision(BenchRunner& runner) {
+    static const size_t OBJECT_COUNTS[] = { 64, 256, 1024, 4096, 16384 };
+    static const size_t NUM_QUERIES = 1024;
+
+    std::mt19937 rng(1);
+    for(size_t numObjects : OBJECT_COUNTS) {
+        // lay the walls out on a square grid like the maze does
+        const size_t side = (size_t)std::ceil(std::sqrt((double)numObjects));
+        CollisionDetector::clearCollisionObjects();
+        for(size_t k = 0; k < numObjects; k++) {
+            CollisionDetector::addCollisionObject(glm::vec3((k / side) * 3.0f, 0.0f, (k % side) * 3.0f), 1.5f, false);
+        }
+        std::uniform_real_distribution<float> coordinate(0.0f, side * 3.0f);
+        std::vector<glm::vec2> queries(NUM_QUERIES);
+        for(glm::vec2& query : queries) query = glm::vec2(coordinate(rng), coordinate(rng));
+
+        runner.run("collision_query", numObjects, 1, [&queries](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                gSink = gSink + (CollisionDetector::getCollidedObject(queries[i % NUM_QUERIES], 0.5f) ? 1.0f : 0.0f);
+            }
+        });
+    }
+    CollisionDetector::clearCollisionObjects();
+}
+
+static void benchGhostMoves(BenchRunner& runner) {
+    static const size_t NUM_QUERIES = 1024;
+
+    std::mt19937 rng(1);
+    for(size_t size : MAZE_SIZES) {
+        const std::vector<std::vector<int>> world = benchMaze(size);
+        const std::vector<glm::vec2> cells = openCells(world);
+        std::vector<glm::vec2> ghosts(NUM_QUERIES), players(NUM_QUERIES);
+        for(size_t q = 0; q < NUM_QUERIES; q++) {
+            ghosts[q] = cells[rng() % cells.size()];
+            players[q] = cells[rng() % cells.size()];
+        }
+
+        runner.run("get_possible_moves", size, 1, [&world, &ghosts](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                gSink = gSink + (float)getPossibleMoves(world, ghosts[i % NUM_QUERIES]).size();
+            }
+        });
+        runner.run("find_best_move", size, 1, [&world, &ghosts, &players](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                gSink = gSink + findBestMove(world, ghosts[i % NUM_QUERIES], players[i % NUM_QUERIES]).x;
+            }
+        });
+    }
+}
+
+static void benchParticles(BenchRunner& runner, JobSystem& jobSystem) {
+    static const int PARTICLE_COUNTS[] = { ParticleSystem::NUM_PARTICLES, 1000, 10000, 100000 };
+
+    for(int numParticles : PARTICLE_COUNTS) {
+        ParticleSystem particles;
+        runner.run("particle_update", numParticles, numParticles, [&particles, numParticles](size_t iterations) {
+            particles.spawn(glm::vec3(0.0f), numParticles);
+            for(size_t i = 0; i < iterations; i++) particles.update(1.0f / 60.0f);
+            gSink = gSink + particles.getParticles()[0].position.y;
+        });
+        runner.run("particle_update_jobs", numParticles, numParticles, [&particles, &jobSystem, numParticles](size_t iterations) {
+            particles.spawn(glm::vec3(0.0f), numParticles);
+            for(size_t i = 0; i < iterations; i++) particles.update(1.0f / 60.0f, &jobSystem);
+            gSink = gSink + particles.getParticles()[0].position.y;
+        });
+    }
+}
+
+static void benchBillboards(BenchRunner& runner) {
+    static const size_t BILLBOARD_COUNTS[] = { 16, 256, 4096, 65536 };
+
+    const glm::mat4 viewMtx = glm::lookAt(glm::vec3(3.0f, 0.5f, 3.0f), glm::vec3(10.0f, 0.5f, 7.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coordinate(0.0f, 300.0f);
+    for(size_t count : BILLBOARD_COUNTS) {
+        std::vector<glm::vec3> positions(count);
+        for(glm::vec3& position : positions) position = glm::vec3(coordinate(rng), 1.0f, coordinate(rng));
+        std::vector<glm::mat4> models(count);
+
+        runner.run("billboard_matrix", count, count, [&positions, &models, &viewMtx](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                for(size_t k = 0; k < positions.size(); k++) {
+                    models[k] = createBillboardMatrix(positions[k], viewMtx);
+                }
+            }
+            gSink = gSink + models.back()[3][0];
+        });
+    }
+}
+
+static void benchPlaneUniforms(BenchRunner& runner) {
+    static const size_t CAR_COUNTS[] = { 1, 16, 256, 4096 };
+
+    glad_glProgramUniformMatrix4fv = stubProgramUniformMatrix4fv;
+    glad_glProgramUniformMatrix3fv = stubProgramUniformMatrix3fv;
+
+    const Plane plane(0, 0, 1, 2, 3);
+    const glm::mat4 viewMtx = glm::lookAt(glm::vec3(3.0f, 0.5f, 3.0f), glm::vec3(10.0f, 0.5f, 7.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projMtx = glm::perspective(45.0f, 16.0f / 9.0f, 0.001f, 1000.0f);
+    for(size_t count : CAR_COUNTS) {
+        std::vector<glm::mat4> models(count);
+        for(size_t k = 0; k < count; k++) {
+            models[k] = glm::translate(glm::mat4(1.0f), glm::vec3(k * 3.0f, 0.0f, 3.0f));
+        }
+
+        runner.run("plane_matrix_uniforms", count, count, [&plane, &models, &viewMtx, &projMtx](size_t iterations) {
+            for(size_t i = 0; i < iterations; i++) {
+                for(const glm::mat4& model : models) {
+                    plane.computeAndSendMatrixUniforms(model, viewMtx, projMtx);
+                }
+            }
+        });
+    }
+}
+
+//*************************************************************************************
+//
+// Our main function
+
+static void printUsage(const char* program) {
+    fprintf(stderr, "usage: %s [--filter <name>] [--output <file.json>] [--min-time <ms>] [--samples <n>] [--threads <n>]\n", program);
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for(int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--filter") == 0 && hasValue) options.filter = argv[++i];
+        else if(strcmp(argv[i], "--output") == 0 && hasValue) options.outputFile = argv[++i];
+        else if(strcmp(argv[i], "--min-time") == 0 && hasValue) options.minSampleMs = atof(argv[++i]);
+        else if(strcmp(argv[i], "--samples") == 0 && hasValue) options.numSamples = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue) options.numThreads = atoi(argv[++i]);
+        else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if(options.minSampleMs <= 0.0 || options.numSamples <= 0) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if(!parseOptions(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
+
+    JobSystem jobSystem(options.numThreads);
+    BenchRunner runner(options);
+    runner.setThreads(jobSystem.getNumThreads());
+
+    benchReadCsv(runner);
+    benchMazeGenerator(runner, jobSystem);
+    benchCollision(runner);
+    benchGhostMoves(runner);
+    benchParticles(runner, jobSystem);
+    benchBillboards(runner);
+    benchPlaneUniforms(runner);
+
+    FILE* output = stdout;
+    if(!options.outputFile.empty()) {
+        output = fopen(options.outputFile.c_str(), "w");
+        if(!output) {
+            fprintf(stderr, "[ERROR]: could not open \"%s\" for writing\n", options.outputFile.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    runner.writeJson(output);
+    if(output != stdout) fclose(output);
+
+    return EXIT_SUCCESS;
+}
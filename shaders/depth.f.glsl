@@ -0,0 +1,5 @@
+#version 410 core
+
+// depth only, the color writes are masked off while this runs
+void main() {
+}
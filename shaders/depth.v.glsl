@@ -0,0 +1,17 @@
+#version 410 core
+
+uniform mat4 mvpMatrix;
+// maps quantized positions back to mesh space, see PackedVertex.h
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+layout(location = 0) in vec3 vPos;
+
+// the scene pass tests against this depth with GL_LEQUAL from fp.v.glsl, both must compute
+// gl_Position with the same expressions for it to match
+invariant gl_Position;
+
+void main() {
+    vec3 position = vPos * positionScale + positionOffset;
+    gl_Position = mvpMatrix * vec4(position, 1.0);
+}
@@ -3,24 +3,72 @@
 uniform sampler2D textureMap;
 uniform vec3 lightDirection;
 uniform vec3 directionalLightColor;
-uniform vec3 pointLightPosition;
-uniform vec3 pointLightColor;
-uniform vec3 viewVector;
+// written once per frame through the stream buffer, see FPEngine::FrameUniforms
+layout(std140) uniform FrameUniforms {
+    vec3 pointLightPosition;
+    vec3 pointLightColor;
+    vec3 viewVector;
+};
+// non-zero for cutout draws like the ghosts, opaque draws never reach the discard
+uniform int alphaTest;
+
+// Clustered point lights, see LightGrid
+uniform samplerBuffer lightData;
+uniform usamplerBuffer lightCells;
+uniform usamplerBuffer lightIndices;
+uniform vec2 lightGridOrigin;
+uniform float lightGridCellSize;
+uniform ivec2 lightGridSize;
+
+// Static light baked onto the floor and walls, see LightmapBaker
+uniform sampler2DArray lightmap;
+uniform int useLightmap;
+uniform float lightmapScale;
+uniform float lightmapCellSize;
+uniform ivec2 lightmapCells;
 
 layout(location = 0) in vec2 texCoord;
 layout(location = 1) in vec3 fragPos;
 layout(location = 2) in vec3 fragNormal;
 layout(location = 3) in vec3 color;
+layout(location = 4) in vec3 worldPos;
+// coverage written to alpha, below one only for the blended particles
+layout(location = 5) in float instanceOpacity;
 
 // Fragment Output
 out vec4 fragColorOut;
 
+// Ambient and directional light baked for a point on the floor or a wall, the layer and tile
+// follow from the position and the normal
+vec3 bakedLight(vec3 position, vec3 normal) {
+    // the cell the face belongs to lies behind it
+    vec3 inside = position - normal * 0.01;
+    ivec2 cell = ivec2(floor(inside.xz / lightmapCellSize + 0.5));
+    vec2 cellCorner = (vec2(cell) - 0.5) * lightmapCellSize;
+    vec2 local;
+    float layer;
+    if(normal.y > 0.5) {
+        layer = 0.0;
+        local = (position.xz - cellCorner) / lightmapCellSize;
+    } else if(abs(normal.x) > abs(normal.z)) {
+        layer = normal.x > 0.0 ? 1.0 : 2.0;
+        local = vec2(position.z - cellCorner.y, position.y) / lightmapCellSize;
+    } else {
+        layer = normal.z > 0.0 ? 3.0 : 4.0;
+        local = vec2(position.x - cellCorner.x, position.y) / lightmapCellSize;
+    }
+    // filter within the tile of the face, the neighbouring tiles belong to other faces
+    vec2 halfTexel = 0.5 * vec2(lightmapCells) / vec2(textureSize(lightmap, 0).xy);
+    local = clamp(local, halfTexel, 1.0 - halfTexel);
+    return texture(lightmap, vec3((vec2(cell) + local) / vec2(lightmapCells), layer)).rgb * lightmapScale;
+}
+
 void main() {
     // Get texture color including alpha
     vec4 texColor = texture(textureMap, texCoord);
 
     // Discard fragments with low alpha
-    if(texColor.a < 0.1) {
+    if(alphaTest != 0 && texColor.a < 0.1) {
         discard;
     }
 
@@ -32,16 +80,24 @@ void main() {
         materialColor = texColor.rgb;  // Use RGB from texture
     }
 
-    // Directional Light
-    vec3 directionalNormalizedLightDirection = normalize(-lightDirection);
-    float diff = max(dot(fragNormal, directionalNormalizedLightDirection), 0.0);
-    vec3 directionalDiffuse = directionalLightColor * diff * materialColor;
-
-    // Specular for Directional Light
     vec3 viewDir = normalize(viewVector - fragPos);
-    vec3 reflectDir = reflect(-directionalNormalizedLightDirection, fragNormal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 2.0);
-    vec3 directionalSpecular = directionalLightColor * spec * materialColor;
+
+    // Ambient and Directional Light, baked for the static maze
+    vec3 staticLight;
+    if(useLightmap != 0) {
+        staticLight = bakedLight(worldPos, normalize(fragNormal)) * materialColor;
+    } else {
+        vec3 directionalNormalizedLightDirection = normalize(-lightDirection);
+        float diff = max(dot(fragNormal, directionalNormalizedLightDirection), 0.0);
+        vec3 directionalDiffuse = directionalLightColor * diff * materialColor;
+
+        // Specular for Directional Light
+        vec3 reflectDir = reflect(-directionalNormalizedLightDirection, fragNormal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 2.0);
+        vec3 directionalSpecular = directionalLightColor * spec * materialColor;
+
+        staticLight = ambientReflection * materialColor + 0.1*(directionalDiffuse + directionalSpecular);
+    }
 
     // Point Light
     vec3 pointLightDir = normalize(pointLightPosition - fragPos);
@@ -60,7 +116,27 @@ void main() {
 
 
 
+    // Clustered point lights, only the ones binned into this fragment's grid cell
+    vec3 clusteredDiffuse = vec3(0.0);
+    ivec2 cell = ivec2(floor((worldPos.xz - lightGridOrigin) / lightGridCellSize));
+    if(all(greaterThanEqual(cell, ivec2(0))) && all(lessThan(cell, lightGridSize))) {
+        uvec2 range = texelFetch(lightCells, cell.y * lightGridSize.x + cell.x).xy;
+        for(uint i = 0u; i < range.y; i++) {
+            int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+            vec4 lightPositionRadius = texelFetch(lightData, 2 * light);
+            vec3 lightColor = texelFetch(lightData, 2 * light + 1).rgb;
+
+            vec3 toLight = lightPositionRadius.xyz - worldPos;
+            float lightDistance = max(length(toLight), 0.0001);
+            // fades out to nothing at the radius the light was binned with
+            float window = clamp(1.0 - pow(lightDistance / lightPositionRadius.w, 4.0), 0.0, 1.0);
+            float falloff = window * window / (1.0 + lightDistance * lightDistance);
+            clusteredDiffuse += lightColor * max(dot(fragNormal, toLight / lightDistance), 0.0) * falloff;
+        }
+    }
+
     // Combine
-    vec3 result = ambientReflection * materialColor + 0.1*(directionalDiffuse + directionalSpecular) + attenuation * 9*(pointDiffuse + pointSpecular);
-    fragColorOut = vec4(result, texColor.a);
+    vec3 result = staticLight + attenuation * 9*(pointDiffuse + pointSpecular);
+    result += clusteredDiffuse * materialColor;
+    fragColorOut = vec4(result, texColor.a * instanceOpacity);
 }
@@ -2,23 +2,46 @@
 
 // Uniform inputs
 uniform mat4 mvpMatrix;
+uniform mat4 modelMatrix;
 uniform mat3 normalMatrix;
 uniform vec3 materialColor;  
+// maps quantized positions back to mesh space, see PackedVertex.h
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+// non-zero for the instanced particles, which are placed by their instance attributes
+uniform int instanced;
 
 layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec2 inTexCoord;
 layout(location = 2) in vec3 normalVec;
+// per instance center and size, then color and opacity
+layout(location = 5) in vec4 instanceCenterSize;
+layout(location = 6) in vec4 instanceColor;
 
 // Outputs to Fragment Shader
 layout(location = 0) out vec2 texCoord;
 layout(location = 1) out vec3 fragPos;  
 layout(location = 2) out vec3 fragNormal; 
 layout(location = 3) out vec3 color;
+layout(location = 4) out vec3 worldPos;
+layout(location = 5) out float instanceOpacity;
+
+// must match the depth prepass in depth.v.glsl, keep the position math the same in both
+invariant gl_Position;
 
 void main() {
-    gl_Position = mvpMatrix * vec4(vPos, 1.0);
-    fragPos = vPos;
-    fragNormal = normalize(normalMatrix * normalVec);
+    vec3 position = vPos * positionScale + positionOffset;
     color = materialColor;
+    instanceOpacity = 1.0;
+    if(instanced != 0) {
+        // instances are placed in world space, mvpMatrix and modelMatrix only hold the camera
+        position = position * instanceCenterSize.w + instanceCenterSize.xyz;
+        color = instanceColor.rgb;
+        instanceOpacity = instanceColor.a;
+    }
+    gl_Position = mvpMatrix * vec4(position, 1.0);
+    fragPos = position;
+    worldPos = vec3(modelMatrix * vec4(position, 1.0));
+    fragNormal = normalize(normalMatrix * normalVec);
     texCoord = inTexCoord;
 }
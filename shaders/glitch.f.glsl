@@ -0,0 +1,51 @@
+#version 410 core
+
+// the finished scene of this frame
+uniform sampler2D sceneColor;
+// 0 leaves the scene untouched, 1 is the full effect
+uniform float strength;
+// animation counter, runs down 60 steps per second of the hit
+uniform float time;
+
+in vec2 screenCoord;
+
+out vec4 fragColorOut;
+
+// Random function
+float rand(vec2 co) {
+    return fract(sin(dot(co.xy, vec2(12.9898, 78.233))) * 43758.5453);
+}
+
+// Wacky Wave Function
+vec3 bezier(float time) {
+    float T = fract(time / 15);
+    vec3 P0 = vec3(-200, -200, 100);
+    vec3 P1 = vec3(25, -379, 0);
+    vec3 P2 = vec3(116, 330, 500);
+    vec3 P3 = vec3(200, -200, -200);
+    vec3 bezierPoint = (pow((1 - T),3)) * P0
+        + (3*T*pow((1 - T),2)) * P1
+        + (3*pow(T,2)*(1 - T)) * P2
+        + (pow(T,3)) * P3;
+    return bezierPoint;
+}
+
+void main() {
+    // the noise holds still for a few steps at a time, like the old per-vertex wobble
+    float frame = floor(time / 4.0);
+
+    // the whole image sways along the wave, some horizontal bands tear away from it
+    vec2 wave = normalize(bezier(time)).xy * 0.01;
+    float band = floor(screenCoord.y * 24.0);
+    float tear = (rand(vec2(band, frame)) - 0.5) * step(0.7, rand(vec2(frame, band * 0.37)));
+    vec2 uv = screenCoord + (wave + vec2(tear * 0.08, 0.0)) * strength;
+    vec3 sceneRgb = texture(sceneColor, uv).rgb;
+
+    // per channel noise and sparkles over 2x2 pixel blocks
+    vec2 block = floor(gl_FragCoord.xy * 0.5) + frame;
+    vec3 noise = vec3(rand(block * 0.1), rand(block * 0.2), rand(block * 0.3));
+    float sparkle = step(0.95, rand(block * 0.5)) * 0.8;
+    vec3 glitched = sceneRgb * noise * 2.0 + vec3(sparkle);
+
+    fragColorOut = vec4(mix(sceneRgb, glitched, strength), 1.0);
+}
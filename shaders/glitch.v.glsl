@@ -0,0 +1,10 @@
+#version 410 core
+
+out vec2 screenCoord;
+
+void main() {
+    // a single triangle covering the screen, the vertices come from the vertex index alone
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    gl_Position = vec4(pos, 0.0, 1.0);
+    screenCoord = pos * 0.5 + 0.5;
+}
@@ -0,0 +1,13 @@
+#version 410 core
+
+// single channel glyph coverage
+uniform sampler2D glyphAtlas;
+
+layout(location = 0) in vec2 texCoord;
+layout(location = 1) in vec4 color;
+
+out vec4 fragColorOut;
+
+void main() {
+    fragColorOut = vec4(color.rgb, color.a * texture(glyphAtlas, texCoord).r);
+}
@@ -0,0 +1,18 @@
+#version 410 core
+
+// size of the framebuffer in pixels
+uniform vec2 screenSize;
+
+// position in pixels from the top left corner
+layout(location = 0) in vec2 vPos;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 texCoord;
+layout(location = 1) out vec4 color;
+
+void main() {
+    gl_Position = vec4(vPos.x / screenSize.x * 2.0 - 1.0, 1.0 - vPos.y / screenSize.y * 2.0, 0.0, 1.0);
+    texCoord = inTexCoord;
+    color = inColor;
+}
@@ -1,10 +1,13 @@
 #version 410 core
 
-in vec2 TexCoord;
+in vec4 ClipPos;
 out vec4 FragColor;
 
-uniform sampler2D skyTexture;
+uniform mat4 inverseViewProjection;
+uniform samplerCube skyTexture;
 
 void main() {
-    FragColor = texture(skyTexture, TexCoord);
+    // the view has no translation, the unprojected point is the view direction
+    vec4 direction = inverseViewProjection * ClipPos;
+    FragColor = texture(skyTexture, direction.xyz / direction.w);
 }
\ No newline at end of file
@@ -1,15 +1,11 @@
 #version 410 core
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
-
-out vec2 TexCoord;
-
-uniform mat4 projection;
-uniform mat4 view;
+out vec4 ClipPos;
 
 void main() {
-    vec4 pos = projection * view * vec4(aPos, 1.0);
-    gl_Position = pos.xyww;  // Force depth to be maximum
-    TexCoord = aTexCoord;
-}
\ No newline at end of file
+    // a single triangle covering the screen, the vertices come from the vertex index alone
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    // z = w puts the sky on the far plane, every pixel already covered fails the depth test
+    gl_Position = vec4(pos, 1.0, 1.0);
+    ClipPos = gl_Position;
+}
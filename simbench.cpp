@@ -0,0 +1,304 @@
+/*
+ *  File: simbench.cpp
+ *
+ *  Description:
+ *      Headless benchmark of the game simulation.  Loads or generates a maze,
+ *      spawns ghosts, drives the player with a scripted bot and reports how
+ *      fast the simulation ticks without any window or GL context.
+ */
+
+#include "JobSystem.h"
+#include "MazeGenerator.h"
+#include "Simulation.h"
+#include "World.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+//*************************************************************************************
+//
+// Allocation Counting
+
+/// \desc number of heap allocations made since the program started
+static std::atomic<unsigned long long> gAllocationCount(0);
+
+void* operator new(size_t size) {
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if(void* memory = malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+//*************************************************************************************
+//
+// Benchmark Setup
+
+struct BenchOptions {
+    /// \desc csv or binary world to load, generated when empty
+    std::string worldFile;
+    /// \desc side length of the generated maze in cells
+    int mazeSize = 64;
+    /// \desc fraction of maze walls kept in the generated maze
+    float wallDensity = 1.0f;
+    /// \desc number of ghosts to place, 0 keeps the ghosts of the world file
+    int numGhosts = 16;
+    /// \desc number of simulation ticks to measure
+    int numTicks = 10000;
+    /// \desc ticks run before measuring
+    int warmupTicks = 100;
+    /// \desc worker threads for the job system, 0 picks one per hardware thread
+    unsigned int numThreads = 0;
+    /// \desc seed for the maze, ghost placement and bot
+    unsigned int seed = 1;
+    /// \desc simulation ticks per second
+    double tickRate = 60.0;
+};
+
+static void printUsage(const char* program) {
+    fprintf(stderr, "usage: %s [--world <file>] [--size <cells>] [--wall-density <0-1>] [--ghosts <n>]\n"
+                    "          [--ticks <n>] [--warmup <n>] [--threads <n>] [--seed <n>] [--tick-rate <hz>]\n", program);
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for(int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if(strcmp(argv[i], "--world") == 0 && hasValue) options.worldFile = argv[++i];
+        else if(strcmp(argv[i], "--size") == 0 && hasValue) options.mazeSize = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--wall-density") == 0 && hasValue) options.wallDensity = (float)atof(argv[++i]);
+        else if(strcmp(argv[i], "--ghosts") == 0 && hasValue) options.numGhosts = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--ticks") == 0 && hasValue) options.numTicks = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--warmup") == 0 && hasValue) options.warmupTicks = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue) options.numThreads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--seed") == 0 && hasValue) options.seed = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--tick-rate") == 0 && hasValue) options.tickRate = atof(argv[++i]);
+        else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if(options.mazeSize < 5 || options.numTicks <= 0 || options.tickRate <= 0.0) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+/// \desc replaces the ghosts of a world with the requested number placed on random open cells
+static void placeGhosts(std::vector<std::vector<int>>& world, int numGhosts, std::mt19937& rng) {
+    std::vector<std::pair<int, int>> openCells;
+    for(int i = 0; i < (int)world.size(); i++) {
+        for(int j = 0; j < (int)world[i].size(); j++) {
+            if(world[i][j] == CELL_GHOST) world[i][j] = CELL_POINT;
+            // keep the area around the player spawn free
+            if(world[i][j] == CELL_POINT && (i > 3 || j > 3)) openCells.emplace_back(i, j);
+        }
+    }
+    std::shuffle(openCells.begin(), openCells.end(), rng);
+    for(int g = 0; g < numGhosts && g < (int)openCells.size(); g++) {
+        world[openCells[g].first][openCells[g].second] = CELL_GHOST;
+    }
+}
+
+//*************************************************************************************
+//
+// Scripted Player
+
+/// \desc walks the player from cell center to cell center along breadth first paths to
+/// random destinations, steering the same way the mouse would
+class PlayerBot {
+public:
+    PlayerBot(const std::vector<std::vector<int>>& world, unsigned int seed) : _world(world), _rng(seed) {
+        for(int i = 0; i < (int)world.size(); i++) {
+            for(int j = 0; j < (int)world[i].size(); j++) {
+                if(world[i][j] != CELL_WALL) _openCells.emplace_back(i, j);
+            }
+        }
+    }
+
+    /// \desc input steering the player from its current position toward the next waypoint
+    Simulation::Input drive(const glm::vec2& playerPosition) {
+        const int cellI = (int)std::lround(playerPosition.x / 3.0f);
+        const int cellJ = (int)std::lround(playerPosition.y / 3.0f);
+
+        while(!_path.empty() && glm::distance(playerPosition, _waypoint(_path.back())) < 0.5f) {
+            _path.pop_back();
+        }
+        if(_path.empty()) {
+            _planPath(cellI, cellJ);
+        }
+
+        Simulation::Input input;
+        if(!_path.empty()) {
+            const glm::vec2 toWaypoint = _waypoint(_path.back()) - playerPosition;
+            input.direction = std::atan2(toWaypoint.x, toWaypoint.y);
+            input.forward = true;
+        }
+        return input;
+    }
+
+private:
+    static glm::vec2 _waypoint(const std::pair<int, int>& cell) {
+        return glm::vec2(cell.first * 3.0f, cell.second * 3.0f);
+    }
+
+    /// \desc breadth first search to a random open cell, path stored goal first
+    void _planPath(int startI, int startJ) {
+        const int rows = (int)_world.size();
+        const int cols = (int)_world[0].size();
+        if(startI < 0 || startJ < 0 || startI >= rows || startJ >= cols || _openCells.empty()) return;
+
+        const std::pair<int, int> goal = _openCells[_rng() % _openCells.size()];
+        std::vector<int> parent(rows * cols, -1);
+        std::queue<int> frontier;
+        const int start = startI * cols + startJ;
+        parent[start] = start;
+        frontier.push(start);
+
+        static const int OFFSETS[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+        while(!frontier.empty()) {
+            const int current = frontier.front();
+            frontier.pop();
+            if(current == goal.first * cols + goal.second) break;
+            for(const auto& offset : OFFSETS) {
+                const int ni = current / cols + offset[0];
+                const int nj = current % cols + offset[1];
+                if(ni < 0 || nj < 0 || ni >= rows || nj >= cols || _world[ni][nj] == CELL_WALL) continue;
+                const int next = ni * cols + nj;
+                if(parent[next] != -1) continue;
+                parent[next] = current;
+                frontier.push(next);
+            }
+        }
+
+        _path.clear();
+        int node = goal.first * cols + goal.second;
+        if(parent[node] == -1) return;
+        while(node != start) {
+            _path.emplace_back(node / cols, node % cols);
+            node = parent[node];
+        }
+    }
+
+    const std::vector<std::vector<int>>& _world;
+    std::mt19937 _rng;
+    std::vector<std::pair<int, int>> _openCells;
+    /// \desc remaining cells to walk through, next waypoint at the back
+    std::vector<std::pair<int, int>> _path;
+};
+
+//*************************************************************************************
+//
+// Our main function
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if(!parseOptions(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
+
+    JobSystem jobSystem(options.numThreads);
+
+    std::vector<std::vector<int>> world;
+    if(!options.worldFile.empty()) {
+        world = read_world(options.worldFile);
+        if(world.empty()) {
+            fprintf(stderr, "[ERROR]: could not load world \"%s\"\n", options.worldFile.c_str());
+            return EXIT_FAILURE;
+        }
+        if(options.numGhosts > 0) {
+            std::mt19937 rng(options.seed);
+            placeGhosts(world, options.numGhosts, rng);
+        }
+        // the player always spawns on cell (1,1)
+        if(world.size() > 1 && world[1].size() > 1) world[1][1] = CELL_POINT;
+    } else {
+        MazeOptions maze;
+        maze.size = options.mazeSize;
+        maze.seed = options.seed;
+        maze.wallDensity = options.wallDensity;
+        maze.numGhosts = options.numGhosts;
+        maze.numPickups = 0;
+        world = MazeGenerator(&jobSystem).generate(maze);
+        if(world.empty()) {
+            return EXIT_FAILURE;
+        }
+    }
+    Simulation simulation(&jobSystem);
+    simulation.setLogging(false);
+    simulation.loadWorld(world);
+
+    PlayerBot bot(world, options.seed);
+    RenderSnapshot snapshot;
+    // the bot plans its first path from the spawn, not from whatever the stack held
+    simulation.writeSnapshot(snapshot);
+    const float tickSeconds = (float)(1.0 / options.tickRate);
+
+    for(int i = 0; i < options.warmupTicks; i++) {
+        simulation.tick(bot.drive(snapshot.playerPosition), tickSeconds);
+        simulation.writeSnapshot(snapshot);
+    }
+
+    std::vector<double> tickMs(options.numTicks);
+    double snapshotMs = 0.0;
+    // publishing the snapshot is not part of the tick, its allocations are counted on their own
+    unsigned long long tickAllocations = 0;
+    unsigned long long snapshotAllocations = 0;
+
+    const auto benchStart = std::chrono::steady_clock::now();
+    for(int i = 0; i < options.numTicks; i++) {
+        const Simulation::Input input = bot.drive(snapshot.playerPosition);
+
+        const unsigned long long allocationsBefore = gAllocationCount.load(std::memory_order_relaxed);
+        const auto tickStart = std::chrono::steady_clock::now();
+        simulation.tick(input, tickSeconds);
+        const auto tickEnd = std::chrono::steady_clock::now();
+        const unsigned long long allocationsAfterTick = gAllocationCount.load(std::memory_order_relaxed);
+        simulation.writeSnapshot(snapshot);
+        const auto snapshotEnd = std::chrono::steady_clock::now();
+        tickAllocations += allocationsAfterTick - allocationsBefore;
+        snapshotAllocations += gAllocationCount.load(std::memory_order_relaxed) - allocationsAfterTick;
+
+        tickMs[i] = std::chrono::duration<double, std::milli>(tickEnd - tickStart).count();
+        snapshotMs += std::chrono::duration<double, std::milli>(snapshotEnd - tickEnd).count();
+    }
+    const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - benchStart).count();
+
+    std::vector<double> sorted = tickMs;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) {
+        size_t index = (size_t)std::ceil(p * sorted.size()) - 1;
+        return sorted[std::min(index, sorted.size() - 1)];
+    };
+    double tickTotalMs = 0.0;
+    for(double ms : tickMs) tickTotalMs += ms;
+
+    fprintf(stdout, "[INFO]: simbench world %zux%zu, %zu ghosts, %d ticks at %.0f Hz on %u threads\n",
+            world.size(), world[0].size(), snapshot.ghostPositions.size(), options.numTicks, options.tickRate,
+            jobSystem.getNumThreads());
+    fprintf(stdout, "ticks_per_second %.1f\n", options.numTicks / totalSeconds);
+    fprintf(stdout, "tick_ms_mean %.4f\n", tickTotalMs / options.numTicks);
+    fprintf(stdout, "tick_ms_p50 %.4f\n", percentile(0.50));
+    fprintf(stdout, "tick_ms_p99 %.4f\n", percentile(0.99));
+    fprintf(stdout, "tick_ms_max %.4f\n", sorted.back());
+    fprintf(stdout, "snapshot_ms_mean %.4f\n", snapshotMs / options.numTicks);
+    fprintf(stdout, "allocations_total %llu\n", tickAllocations);
+    fprintf(stdout, "allocations_per_tick %.2f\n", (double)tickAllocations / options.numTicks);
+    fprintf(stdout, "snapshot_allocations_total %llu\n", snapshotAllocations);
+    fprintf(stdout, "snapshot_allocations_per_tick %.2f\n", (double)snapshotAllocations / options.numTicks);
+
+    return EXIT_SUCCESS;
+}